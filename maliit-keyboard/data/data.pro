@@ -13,6 +13,57 @@ styles.files = styles
 
 INSTALLS += languages styles
 
+!disable-compiled-layouts {
+    # All layouts compiled into one binary image, which KeyboardLoader maps
+    # instead of parsing the XML files at runtime.
+    LAYOUT_COMPILER = $${OUT_PWD}/../layout-compiler/maliit-keyboard-layout-compiler
+    COMPILED_LAYOUTS = $${OUT_PWD}/layouts.bin
+
+    compiled_layouts.target = $$COMPILED_LAYOUTS
+    compiled_layouts.depends = $$LAYOUT_COMPILER $$files($$PWD/languages/*.xml)
+    compiled_layouts.commands = \
+        xmllint --noout --dtdvalid \"$$PWD/languages/VirtualKeyboardLayout.dtd\" \"$$PWD/languages/\"*.xml && \
+        \"$$LAYOUT_COMPILER\" -o \"$$COMPILED_LAYOUTS\" \"$$PWD/languages/\"*.xml
+
+    QMAKE_EXTRA_TARGETS += compiled_layouts
+    PRE_TARGETDEPS += $$COMPILED_LAYOUTS
+    QMAKE_CLEAN += $$COMPILED_LAYOUTS
+
+    compiled_languages.path = $$MALIIT_PLUGINS_DATA_DIR/languages
+    compiled_languages.files = $$COMPILED_LAYOUTS
+    compiled_languages.CONFIG += no_check_exist
+
+    INSTALLS += compiled_languages
+}
+
+!disable-compiled-styles {
+    # Every style profile compiled into one binary bundle, which Style maps
+    # instead of parsing the INI files at runtime.
+    STYLE_COMPILER = $${OUT_PWD}/../style-compiler/maliit-keyboard-style-compiler
+
+    for(profile_dir, $$list($$files($$PWD/styles/*))) {
+        profile = $$basename(profile_dir)
+        name = $$replace(profile, -, _)
+        bundle = $${OUT_PWD}/styles/$${profile}/style.bin
+
+        style_bundle_$${name}.target = $$bundle
+        style_bundle_$${name}.depends = $$STYLE_COMPILER $$files($$profile_dir/*.ini)
+        style_bundle_$${name}.commands = \
+            $(MKDIR) \"$${OUT_PWD}/styles/$${profile}\" && \
+            \"$$STYLE_COMPILER\" -o \"$$bundle\" \"$$profile_dir\"
+
+        QMAKE_EXTRA_TARGETS += style_bundle_$${name}
+        PRE_TARGETDEPS += $$bundle
+        QMAKE_CLEAN += $$bundle
+
+        compiled_style_$${name}.path = $$MALIIT_KEYBOARD_DATA_DIR/styles/$${profile}
+        compiled_style_$${name}.files = $$bundle
+        compiled_style_$${name}.CONFIG += no_check_exist
+
+        INSTALLS += compiled_style_$${name}
+    }
+}
+
 QMAKE_EXTRA_TARGETS += check
 check.target = check
 
@@ -0,0 +1,14 @@
+include(../config.pri)
+
+TOP_BUILDDIR = $${OUT_PWD}/../..
+TEMPLATE = app
+TARGET = maliit-keyboard-layout-compiler
+
+INCLUDEPATH += ../lib
+LIBS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+PRE_TARGETDEPS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+SOURCES += main.cpp
+
+QT = core
+
+include(../word-prediction.pri)
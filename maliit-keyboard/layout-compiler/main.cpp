@@ -0,0 +1,120 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "parser/layoutimage.h"
+#include "parser/layoutparser.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace MaliitKeyboard;
+
+namespace {
+
+void printUsage()
+{
+    std::fprintf(stderr, "Usage: maliit-keyboard-layout-compiler -o OUTPUT LAYOUT.xml...\n"
+                         "Compiles the given layout files into one binary layout image.\n");
+}
+
+} // unnamed namespace
+
+int main(int argc,
+         char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args(app.arguments());
+    QString output;
+    QStringList inputs;
+
+    args.removeFirst();
+
+    while (not args.isEmpty()) {
+        const QString arg(args.takeFirst());
+
+        if (arg == "-o") {
+            if (args.isEmpty()) {
+                printUsage();
+                return 1;
+            }
+            output = args.takeFirst();
+        } else if (arg == "-h" or arg == "--help") {
+            printUsage();
+            return 0;
+        } else {
+            inputs.append(arg);
+        }
+    }
+
+    if (output.isEmpty() or inputs.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    LayoutImageWriter writer;
+
+    Q_FOREACH (const QString &input, inputs) {
+        const QFileInfo file_info(input);
+        QFile file(input);
+
+        if (not file.open(QIODevice::ReadOnly)) {
+            qCritical("Could not open %s: %s", qPrintable(input), qPrintable(file.errorString()));
+            return 1;
+        }
+
+        LayoutParser parser(&file);
+
+        if (not parser.parse()) {
+            qCritical("Could not parse %s: %s", qPrintable(input), qPrintable(parser.errorString()));
+            return 1;
+        }
+
+        writer.addKeyboard(file_info.completeBaseName(),
+                           parser.tree(),
+                           LayoutImage::hashFile(input));
+    }
+
+    QFile file(output);
+    const QByteArray image(writer.data());
+
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        or file.write(image) != image.size()) {
+        qCritical("Could not write %s: %s", qPrintable(output), qPrintable(file.errorString()));
+        return 1;
+    }
+
+    return 0;
+}
@@ -34,6 +34,9 @@
 
 #include "models/key.h"
 
+#include <QDir>
+#include <QAtomicInt>
+
 namespace MaliitKeyboard {
 namespace CoreUtils {
 namespace {
@@ -68,6 +71,20 @@ const QString &maliitKeyboardStyleProfilesDirectory()
     return styles_profiles_directory;
 }
 
+// Honours MALIIT_KEYBOARD_CACHEDIR, then the XDG base directory spec.
+const QString &maliitKeyboardCacheDirectory()
+{
+    static const QByteArray env_cache_directory = qgetenv("MALIIT_KEYBOARD_CACHEDIR");
+    static const QByteArray xdg_cache_home = qgetenv("XDG_CACHE_HOME");
+    static const QString cache_directory(not env_cache_directory.isEmpty()
+                                         ? QString::fromUtf8(env_cache_directory)
+                                         : (xdg_cache_home.isEmpty() ? QDir::homePath() + "/.cache"
+                                                                     : QString::fromUtf8(xdg_cache_home))
+                                           + "/maliit-keyboard");
+
+    return cache_directory;
+}
+
 QString idFromKey(const Key &key)
 {
     switch (key.action()) {
@@ -83,4 +100,21 @@ QString idFromKey(const Key &key)
     }
 }
 
+//! \brief Returns a new id for the content of a model, such as a KeyArea.
+//!
+//! Models assign a new id whenever a setter changes their content, and
+//! copies share the id of their source. Two models with non-zero ids hold
+//! the same content exactly if their ids are equal, so they are compared
+//! without looking at the content. Id 0 marks content that is not tracked,
+//! either because it was default constructed or because a mutable reference
+//! to it was handed out; such content is compared in full. A mutable
+//! reference must not be used after a setter was called.
+//!
+//! Ids are unique within the process. Safe to call from any thread.
+int nextContentId()
+{
+    static QAtomicInt last_id(0);
+    return last_id.fetchAndAddRelaxed(1) + 1;
+}
+
 }} // namespace CoreUtils, MaliitKeyboard
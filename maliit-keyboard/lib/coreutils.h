@@ -42,7 +42,9 @@ namespace CoreUtils {
 const QString &pluginDataDirectory();
 const QString &maliitKeyboardDataDirectory();
 const QString &maliitKeyboardStyleProfilesDirectory();
+const QString &maliitKeyboardCacheDirectory();
 QString idFromKey(const Key &key);
+int nextContentId();
 }} // namespace MaliitKeyboard, CoreUtils
 
 #endif // UTILS_H
@@ -73,23 +73,14 @@ KeyArea createFromKeyboard(StyleAttributes *attributes,
     }
 
     attributes->setStyleName(kb.style_name);
+    const StyleSnapshot &style(attributes->snapshot(kb.style_name, orientation));
 
-    Font font;
-    font.setName(attributes->fontName(orientation));
-    font.setSize(attributes->fontSize(orientation));
-    font.setColor(attributes->fontColor(orientation));
-
-    Font small_font(font);
-    small_font.setSize(attributes->smallFontSize(orientation));
-
-    static const QMargins bg_margins(attributes->keyBackgroundBorders());
-
-    const qreal max_width(attributes->keyAreaWidth(orientation));
-    const qreal key_height(attributes->keyHeight(orientation));
-    const qreal key_top_row_height(attributes->keyTopRowHeight(orientation));
-    const qreal key_bottom_row_height(attributes->keyBottomRowHeight(orientation));
-    const qreal margin = attributes->keyMargin(orientation);
-    const qreal padding = attributes->keyAreaPadding(orientation);
+    const qreal max_width(style.key_area_width);
+    const qreal key_height(style.key_height);
+    const qreal key_top_row_height(style.key_top_row_height);
+    const qreal key_bottom_row_height(style.key_bottom_row_height);
+    const qreal margin = style.key_margin;
+    const qreal padding = style.key_area_padding;
 
     QPoint pos(0, 0);
     QVector<int> row_indices;
@@ -123,13 +114,13 @@ KeyArea createFromKeyboard(StyleAttributes *attributes,
             ++spacer_count;
         }
 
-        width = attributes->keyWidth(orientation, desc.width);
+        width = style.key_widths[desc.width];
 
         const qreal key_margin((at_row_start || at_row_end) ? margin + padding : margin * 2);
 
         Area area;
-        area.setBackground(attributes->keyBackground(key.style(), KeyDescription::NormalState));
-        area.setBackgroundBorders(bg_margins);
+        area.setBackground(style.key_backgrounds[key.style()][KeyDescription::NormalState]);
+        area.setBackgroundBorders(style.key_background_borders);
         area.setSize(QSize(width + key_margin, row_height));
         key.setArea(area);
 
@@ -138,13 +129,12 @@ KeyArea createFromKeyboard(StyleAttributes *attributes,
                                 at_row_end   ? padding : margin, margin));
 
         const QString &text(key.label().text());
-        key.rLabel().setFont(text.count() > 1 ? small_font : font);
+        key.rLabel().setFont(text.count() > 1 ? style.small_font : style.font);
 
         if (key.icon().isEmpty()) {
-            key.setIcon(attributes->icon(desc.icon,
-                                         KeyDescription::NormalState));
+            key.setIcon(style.icons[desc.icon][KeyDescription::NormalState]);
         } else {
-            key.setIcon(attributes->customIcon(key.icon()));
+            key.setIcon(style.custom_icons.value(key.icon()));
         }
 
         pos.rx() += key.rect().width();
@@ -197,14 +187,14 @@ KeyArea createFromKeyboard(StyleAttributes *attributes,
     }
 
     Area area;
-    area.setBackground(attributes->keyAreaBackground());
-    area.setBackgroundBorders(attributes->keyAreaBackgroundBorders());
+    area.setBackground(style.key_area_background);
+    area.setBackgroundBorders(style.key_area_background_borders);
     area.setSize(QSize((is_extended_keyarea ? consumed_width : max_width),
                        pos.y()));
 
     ka.setArea(area);
-    ka.setOrigin(is_extended_keyarea ? QPoint(0, -attributes->verticalOffset(orientation))
-                                     : QPoint(0, attributes->wordRibbonHeight(orientation)));
+    ka.setOrigin(is_extended_keyarea ? QPoint(0, -style.vertical_offset)
+                                     : QPoint(0, style.word_ribbon_height));
     ka.setKeys(kb.keys);
 
     return ka;
@@ -259,6 +249,14 @@ KeyArea KeyAreaConverter::previousKeyArea() const
 }
 
 
+//! \brief Returns the main key area of a prefetched layout.
+//! \param id The id of the layout.
+KeyArea KeyAreaConverter::prefetchedKeyArea(const QString &id) const
+{
+    return createFromKeyboard(m_attributes, m_loader->prefetchedKeyboard(id), m_orientation);
+}
+
+
 //! \brief Returns the main key area with shift bindings activated.
 KeyArea KeyAreaConverter::shiftedKeyArea() const
 {
@@ -62,6 +62,7 @@ public:
     virtual KeyArea keyArea() const;
     virtual KeyArea nextKeyArea() const;
     virtual KeyArea previousKeyArea() const;
+    virtual KeyArea prefetchedKeyArea(const QString &id) const;
 
     virtual KeyArea shiftedKeyArea() const;
     virtual KeyArea symbolsKeyArea(int page = 0) const;
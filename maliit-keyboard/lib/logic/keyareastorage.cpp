@@ -0,0 +1,386 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "keyareastorage.h"
+#include "coreutils.h"
+
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QTemporaryFile>
+#include <QThreadPool>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+namespace {
+
+const quint32 storage_magic(0x4d4b4b41); // "MKKA"
+const quint32 storage_version(1);
+const char *const storage_suffix(".keyareas");
+const int max_entries_in_memory(8);
+
+void writeFont(QDataStream &stream,
+               const Font &font)
+{
+    stream << font.name() << qint32(font.size()) << font.color() << qint32(font.stretch());
+}
+
+void readFont(QDataStream &stream,
+              Font *font)
+{
+    QByteArray name;
+    qint32 size(0);
+    QByteArray color;
+    qint32 stretch(0);
+
+    stream >> name >> size >> color >> stretch;
+
+    font->setName(name);
+    font->setSize(size);
+    font->setColor(color);
+    font->setStretch(stretch);
+}
+
+void writeArea(QDataStream &stream,
+               const Area &area)
+{
+    stream << area.size() << area.background() << area.backgroundBorders();
+}
+
+void readArea(QDataStream &stream,
+              Area *area)
+{
+    QSize size;
+    QByteArray background;
+    QMargins borders;
+
+    stream >> size >> background >> borders;
+
+    area->setSize(size);
+    area->setBackground(background);
+    area->setBackgroundBorders(borders);
+}
+
+void writeKey(QDataStream &stream,
+              const Key &key)
+{
+    const Label label(key.label());
+
+    stream << key.origin();
+    writeArea(stream, key.area());
+    stream << label.text() << label.rect();
+    writeFont(stream, label.font());
+    stream << qint32(key.action()) << qint32(key.style()) << key.margins() << key.icon()
+           << key.hasExtendedKeys() << qint32(key.extendedKeysId()) << key.commandSequence();
+}
+
+void readKey(QDataStream &stream,
+             Key *key)
+{
+    QPoint origin;
+    QString text;
+    QRect rect;
+    qint32 action(0);
+    qint32 style(0);
+    QMargins margins;
+    QByteArray icon;
+    bool has_extended_keys(false);
+    qint32 extended_keys_id(-1);
+    QString command_sequence;
+    Font font;
+
+    stream >> origin;
+    readArea(stream, &key->rArea());
+    stream >> text >> rect;
+    readFont(stream, &font);
+    stream >> action >> style >> margins >> icon
+           >> has_extended_keys >> extended_keys_id >> command_sequence;
+
+    key->setOrigin(origin);
+    key->rLabel().setText(text);
+    key->rLabel().setRect(rect);
+    key->rLabel().setFont(font);
+    key->setAction(static_cast<Key::Action>(action));
+    key->setStyle(static_cast<Key::Style>(style));
+    key->setMargins(margins);
+    key->setIcon(icon);
+    key->setExtendedKeysEnabled(has_extended_keys);
+    key->setExtendedKeysId(extended_keys_id);
+    key->setCommandSequence(command_sequence);
+}
+
+void writeKeyArea(QDataStream &stream,
+                  const KeyArea &key_area)
+{
+    const QVector<Key> keys(key_area.keys());
+
+    stream << key_area.origin();
+    writeArea(stream, key_area.area());
+    stream << quint32(keys.size());
+
+    Q_FOREACH (const Key &key, keys) {
+        writeKey(stream, key);
+    }
+}
+
+void readKeyArea(QDataStream &stream,
+                 KeyArea *key_area)
+{
+    QPoint origin;
+    Area area;
+    quint32 count(0);
+    QVector<Key> keys;
+
+    stream >> origin;
+    readArea(stream, &area);
+    stream >> count;
+
+    for (quint32 index(0); index < count and stream.status() == QDataStream::Ok; ++index) {
+        Key key;
+
+        readKey(stream, &key);
+        keys.append(key);
+    }
+
+    key_area->setOrigin(origin);
+    key_area->setArea(area);
+    key_area->setKeys(keys);
+}
+
+//! \brief Writes one entry, from a worker thread.
+class StoreTask
+    : public QRunnable
+{
+private:
+    const QString m_path;
+    const QByteArray m_stamp;
+    const QVector<KeyArea> m_key_areas;
+
+public:
+    explicit StoreTask(const QString &path,
+                       const QByteArray &stamp,
+                       const QVector<KeyArea> &key_areas)
+        : m_path(path)
+        , m_stamp(stamp)
+        , m_key_areas(key_areas)
+    {}
+
+    void run()
+    {
+        if (not QDir().mkpath(QFileInfo(m_path).path())) {
+            return;
+        }
+
+        QTemporaryFile file(m_path + ".XXXXXX");
+
+        if (not file.open()) {
+            qWarning() << __PRETTY_FUNCTION__ << "Could not write file:" << file.fileTemplate() << ", error:" << file.errorString();
+            return;
+        }
+
+        QDataStream stream(&file);
+
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << storage_magic << storage_version << m_stamp << quint32(m_key_areas.size());
+
+        Q_FOREACH (const KeyArea &key_area, m_key_areas) {
+            writeKeyArea(stream, key_area);
+        }
+
+        file.close();
+
+        // Replace the old entry only once the new one is complete, so that a
+        // concurrent load never sees a partial entry.
+        QFile::remove(m_path);
+        if (file.rename(m_path)) {
+            file.setAutoRemove(false);
+        }
+    }
+};
+
+} // unnamed namespace
+
+struct StoredKeyAreas
+{
+    QByteArray stamp;
+    QVector<KeyArea> key_areas;
+};
+
+class KeyAreaStoragePrivate
+{
+public:
+    QString directory;
+    mutable QCache<QString, StoredKeyAreas> entries;
+    QThreadPool pool;
+
+    explicit KeyAreaStoragePrivate(const QString &new_directory)
+        : directory(new_directory)
+        , entries(max_entries_in_memory)
+        , pool()
+    {
+        pool.setMaxThreadCount(1);
+    }
+
+    void keep(const QString &name,
+              const QByteArray &stamp,
+              const QVector<KeyArea> &key_areas) const
+    {
+        StoredKeyAreas *stored(new StoredKeyAreas);
+
+        stored->stamp = stamp;
+        stored->key_areas = key_areas;
+        entries.insert(name, stored);
+    }
+
+    QString path(const QString &name) const
+    {
+        return (directory + "/"
+                + QCryptographicHash::hash(name.toUtf8(), QCryptographicHash::Sha1).toHex()
+                + storage_suffix);
+    }
+};
+
+//! \param directory The directory to keep the entries in (optional). By
+//!                  default, a keyareas directory in the cache directory.
+KeyAreaStorage::KeyAreaStorage(const QString &directory)
+    : d_ptr(new KeyAreaStoragePrivate(directory.isEmpty()
+                                      ? CoreUtils::maliitKeyboardCacheDirectory() + "/keyareas"
+                                      : directory))
+{}
+
+//! Waits for pending writes.
+KeyAreaStorage::~KeyAreaStorage()
+{
+    waitForDone();
+}
+
+QString KeyAreaStorage::directory() const
+{
+    Q_D(const KeyAreaStorage);
+    return d->directory;
+}
+
+//! \brief Reads an entry.
+//!
+//! Only the header of the entry is read if it is stale, so validation costs
+//! one small read.
+//! \param name The name of the entry.
+//! \param stamp The stamp of the files the entry has to be converted from.
+//! \param key_areas Receives the key areas of the entry.
+//! \returns Whether an up to date entry was found.
+bool KeyAreaStorage::load(const QString &name,
+                          const QByteArray &stamp,
+                          QVector<KeyArea> *key_areas) const
+{
+    Q_D(const KeyAreaStorage);
+
+    const StoredKeyAreas *entry(d->entries.object(name));
+
+    if (entry and entry->stamp == stamp) {
+        *key_areas = entry->key_areas;
+        return true;
+    }
+
+    QFile file(d->path(name));
+
+    if (not file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic(0);
+    quint32 version(0);
+    QByteArray stored_stamp;
+    quint32 count(0);
+
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream >> magic >> version;
+
+    if (magic != storage_magic or version != storage_version) {
+        return false;
+    }
+
+    stream >> stored_stamp;
+
+    if (stored_stamp != stamp) {
+        return false;
+    }
+
+    stream >> count;
+
+    QVector<KeyArea> result;
+
+    for (quint32 index(0); index < count and stream.status() == QDataStream::Ok; ++index) {
+        KeyArea key_area;
+
+        readKeyArea(stream, &key_area);
+        result.append(key_area);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    d->keep(name, stamp, result);
+
+    *key_areas = result;
+    return true;
+}
+
+//! \brief Writes an entry in the background, replacing an existing one.
+//! \param name The name of the entry.
+//! \param stamp The stamp of the files the key areas were converted from.
+//! \param key_areas The key areas to store.
+void KeyAreaStorage::store(const QString &name,
+                           const QByteArray &stamp,
+                           const QVector<KeyArea> &key_areas)
+{
+    Q_D(KeyAreaStorage);
+
+    d->keep(name, stamp, key_areas);
+    d->pool.start(new StoreTask(d->path(name), stamp, key_areas));
+}
+
+//! \brief Waits until all entries are written.
+void KeyAreaStorage::waitForDone()
+{
+    Q_D(KeyAreaStorage);
+    d->pool.waitForDone();
+}
+
+}} // namespace Logic, MaliitKeyboard
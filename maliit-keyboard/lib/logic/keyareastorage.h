@@ -0,0 +1,84 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef MALIIT_KEYBOARD_KEYAREASTORAGE_H
+#define MALIIT_KEYBOARD_KEYAREASTORAGE_H
+
+#include "models/keyarea.h"
+
+#include <QtCore>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class KeyAreaStoragePrivate;
+
+class KeyAreaStorage;
+typedef QSharedPointer<KeyAreaStorage> SharedKeyAreaStorage;
+
+//! \brief Keeps converted key areas in memory and on disk, across process restarts.
+//!
+//! Every entry is stored under a name, which identifies what was converted
+//! (layout, style profile, orientation, screen size), together with a stamp
+//! made of the content hashes of the files it was converted from. An entry
+//! whose stamp differs from the current one is stale and never returned.
+//! Entries are written by a worker thread, so storing does not block the
+//! caller; converting the key areas is still up to the caller. The most
+//! recently used entries are also kept in memory, so that everybody sharing
+//! the storage converts a layout only once.
+class KeyAreaStorage
+{
+    Q_DISABLE_COPY(KeyAreaStorage)
+    Q_DECLARE_PRIVATE(KeyAreaStorage)
+
+public:
+    explicit KeyAreaStorage(const QString &directory = QString());
+    ~KeyAreaStorage();
+
+    QString directory() const;
+
+    bool load(const QString &name,
+              const QByteArray &stamp,
+              QVector<KeyArea> *key_areas) const;
+    void store(const QString &name,
+               const QByteArray &stamp,
+               const QVector<KeyArea> &key_areas);
+    void waitForDone();
+
+private:
+    const QScopedPointer<KeyAreaStoragePrivate> d_ptr;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_KEYAREASTORAGE_H
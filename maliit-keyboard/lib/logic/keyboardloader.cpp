@@ -31,10 +31,19 @@
  *
  */
 
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
-#include <QRegExp>
-
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QSet>
+#include <QTemporaryFile>
+#include <QThreadPool>
+
+#include "parser/layoutimage.h"
 #include "parser/layoutparser.h"
 #include "coreutils.h"
 
@@ -64,62 +73,222 @@ QString getLanguagesDir()
     return languages_dir;
 }
 
-typedef const QStringList (LayoutParser::*ParserFunc)() const;
+const char *const compiled_layouts_file("layouts.bin");
+
+//! \brief Returns the image written by maliit-keyboard-layout-compiler.
+//!
+//! The image is mapped on first use and stays mapped for the lifetime of the
+//! process. If there is none, an invalid image is returned and all layouts are
+//! read from their XML files.
+const LayoutImage &getLayoutImage()
+{
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+
+    static QFile file(getLanguagesDir() + "/" + compiled_layouts_file);
+    static LayoutImage image;
+    static bool initialized(false);
+
+    if (not initialized) {
+        initialized = true;
+
+        if (file.exists() and file.open(QIODevice::ReadOnly)) {
+            const uchar *data(file.map(0, file.size()));
+
+            if (data) {
+                image = LayoutImage(data, file.size());
+            } else {
+                qWarning() << __PRETTY_FUNCTION__ << "Could not map file:" << file.fileName() << ", error:" << file.errorString();
+            }
+        }
+    }
+
+    return image;
+}
+
+struct SourceHash
+{
+    qint64 last_modified;
+    qint64 size;
+    QByteArray hash;
+
+    SourceHash()
+        : last_modified(-1)
+        , size(-1)
+        , hash()
+    {}
+};
+
+typedef QHash<QString, SourceHash> SourceHashCache;
+
+SourceHashCache readSourceHashes(const QString &languages_dir);
+
+//! \brief Returns the content hash of a layout file.
+//!
+//! Hashing reads the whole file, so the hash is kept for as long as size and
+//! modification time of the file stay the same. These only decide when to
+//! hash again, never whether a compiled entry is up to date. The hashes of
+//! the previous run are taken from the metadata cache, so that unchanged
+//! files are not read at all.
+QByteArray getSourceHash(const QFileInfo &file_info)
+{
+    static QMutex mutex;
+    static SourceHashCache hashes;
+    static bool hashes_loaded(false);
+    QMutexLocker locker(&mutex);
+
+    if (not hashes_loaded) {
+        hashes_loaded = true;
+        hashes = readSourceHashes(getLanguagesDir());
+    }
+
+    SourceHash &entry(hashes[file_info.filePath()]);
+    const qint64 last_modified(file_info.lastModified().toMSecsSinceEpoch());
+
+    if (entry.last_modified != last_modified or entry.size != file_info.size()) {
+        entry.last_modified = last_modified;
+        entry.size = file_info.size();
+        entry.hash = LayoutImage::hashFile(file_info.filePath());
+    }
+
+    return entry.hash;
+}
+
+//! \brief Checks whether the compiled image holds an up to date copy of a layout.
+//!
+//! An entry is outdated when the contents of its XML file differ from the
+//! ones it was compiled from. Layouts shipped only in the compiled image are
+//! always up to date.
+bool hasCompiledLayout(const QString &id,
+                       const QFileInfo &file_info)
+{
+    const LayoutImage &image(getLayoutImage());
+
+    if (not image.contains(id)) {
+        return false;
+    }
+
+    return (not file_info.exists()
+            or getSourceHash(file_info) == image.sourceHash(id));
+}
 
-TagKeyboardPtr getTagKeyboard(const QString &id)
+struct CachedLayoutTree
+{
+    QDateTime last_modified;
+    LayoutTreePtr tree;
+};
+
+typedef QHash<QString, CachedLayoutTree> LayoutTreeCache;
+
+// Parsed layouts are shared between all KeyboardLoader instances. An entry is
+// only reused as long as the modification time of its file did not change.
+LayoutTreeCache &getLayoutTreeCache()
+{
+    static LayoutTreeCache cache;
+
+    return cache;
+}
+
+// Layouts are also loaded by the prefetcher thread, so the cache is only
+// accessed with this mutex locked.
+QMutex &getLayoutTreeCacheMutex()
+{
+    static QMutex mutex;
+
+    return mutex;
+}
+
+LayoutTreePtr getLayoutTree(const QString &id)
 {
     if (id.isEmpty()) {
-        return TagKeyboardPtr();
+        return LayoutTreePtr();
     }
 
     const QString path(getLanguagesDir() + "/" + id + ".xml");
-    QFile file(path);
+    const QFileInfo file_info(path);
+    const bool compiled(hasCompiledLayout(id, file_info));
+    LayoutTreeCache &cache(getLayoutTreeCache());
 
-    if (file.exists()) {
-        file.open(QIODevice::ReadOnly);
+    if (compiled or file_info.exists()) {
+        const QDateTime last_modified(file_info.lastModified());
 
-        LayoutParser parser(&file);
-        const bool result(parser.parse());
+        {
+            QMutexLocker locker(&getLayoutTreeCacheMutex());
+            LayoutTreeCache::const_iterator cached(cache.find(id));
 
-        file.close();
-        if (result) {
-            return parser.keyboard();
-        } else {
-            qWarning() << __PRETTY_FUNCTION__ << "Could not parse file:" << path << ", error:" << parser.errorString();
+            if (cached != cache.constEnd() and cached->last_modified == last_modified) {
+                return cached->tree;
+            }
+        }
+
+        CachedLayoutTree entry;
+
+        entry.last_modified = last_modified;
+
+        if (compiled) {
+            entry.tree = getLayoutImage().tree(id);
+        }
+
+        if (not entry.tree and file_info.exists()) {
+            QFile file(path);
+
+            file.open(QIODevice::ReadOnly);
+
+            LayoutParser parser(&file);
+            const bool result(parser.parse());
+
+            file.close();
+            if (result) {
+                entry.tree = parser.tree();
+            } else {
+                qWarning() << __PRETTY_FUNCTION__ << "Could not parse file:" << path << ", error:" << parser.errorString();
+            }
+        }
+
+        if (entry.tree) {
+            QMutexLocker locker(&getLayoutTreeCacheMutex());
+
+            cache.insert(id, entry);
+            return entry.tree;
         }
     } else {
         qWarning() << __PRETTY_FUNCTION__ << "File not found:" << path;
     }
 
-    return TagKeyboardPtr();
+    QMutexLocker locker(&getLayoutTreeCacheMutex());
+
+    cache.remove(id);
+    return LayoutTreePtr();
 }
 
-QPair<Key, KeyDescription> keyAndDescFromTags(const TagKeyPtr &key,
-                                              const TagBindingPtr &binding,
+QPair<Key, KeyDescription> keyAndDescFromTree(const LayoutTree &tree,
+                                              const LayoutTree::Element &key,
+                                              int binding_index,
                                               int row)
 {
+    const LayoutTree::Binding &binding(tree.binding(binding_index));
     Key skey;
     KeyDescription skey_description;
 
-    skey.setExtendedKeysEnabled(key->extended());
-    skey.rLabel().setText(binding->label());
+    skey.setExtendedKeysEnabled(key.extended);
+    skey.rLabel().setText(tree.string(binding.label));
 
-    if (binding->dead()) {
+    if (binding.dead) {
         // TODO: document it.
         skey.setAction(Key::ActionDead);
     } else {
-        skey.setAction(static_cast<Key::Action>(binding->action()));
+        skey.setAction(static_cast<Key::Action>(binding.action));
     }
 
-    skey.setCommandSequence(binding->sequence());
-    skey.setIcon(binding->icon().toUtf8());
-    skey.setStyle(static_cast<Key::Style>(key->style()));
+    skey.setCommandSequence(tree.string(binding.sequence));
+    skey.setIcon(tree.string(binding.icon).toUtf8());
+    skey.setStyle(static_cast<Key::Style>(key.style));
 
     skey_description.row = row;
-    skey_description.use_rtl_icon = key->rtl();
+    skey_description.use_rtl_icon = key.rtl;
     skey_description.left_spacer = false;
     skey_description.right_spacer = false;
-    skey_description.width = static_cast<KeyDescription::Width>(key->width());
+    skey_description.width = static_cast<KeyDescription::Width>(key.width);
 
     switch (skey.action()) {
     case Key::ActionLeft:
@@ -172,207 +341,771 @@ QPair<Key, KeyDescription> keyAndDescFromTags(const TagKeyPtr &key,
     return qMakePair(skey, skey_description);
 }
 
-Keyboard getKeyboard(const TagKeyboardPtr &keyboard,
-                     bool shifted = false,
-                     int page = 0,
-                     const QString &dead_label = "")
+void appendKey(Keyboard *keyboard,
+               const LayoutTree &tree,
+               const LayoutTree::Element &key,
+               int binding,
+               int row,
+               bool left_spacer)
 {
-    Keyboard skeyboard;
-    const QChar dead_key((dead_label.size() == 1) ? dead_label[0] : QChar::Null);
+    QPair<Key, KeyDescription> key_and_desc(keyAndDescFromTree(tree, key, binding, row));
 
-    if (keyboard) {
-        TagLayoutPtrs layouts(keyboard->layouts());
+    key_and_desc.second.left_spacer = left_spacer;
+    key_and_desc.second.right_spacer = false;
 
-        if (not layouts.isEmpty()) {
-            const TagSectionPtrs sections(layouts.first()->sections());
-            // sections cannot be empty - parser does not allow that.
-            const TagSectionPtr section(sections[page % sections.size()]);
-            const TagRowPtrs rows(section->rows());
-            int row_num(0);
-            QString section_style(section->style());
-            int key_count(0);
-
-            Q_FOREACH (const TagRowPtr &row, rows) {
-                const TagRowElementPtrs elements(row->elements());
-                bool spacer_met(false);
-
-                Q_FOREACH (const TagRowElementPtr &element, elements) {
-                    if (element->element_type() == TagRowElement::Key) {
-                        const TagKeyPtr key(element.staticCast<TagKey>());
-                        const TagBindingPtr binding(key->binding());
-                        TagBindingPtr the_binding;
-                        const TagModifiersPtrs all_modifiers(binding->modifiers());
-
-                        ++key_count;
-
-                        if (not shifted or all_modifiers.isEmpty()) {
-                            the_binding = binding;
-                        } else {
-                            Q_FOREACH (const TagModifiersPtr &modifiers, all_modifiers) {
-                                if (modifiers->keys() == TagModifiers::Shift) {
-                                    the_binding = modifiers->binding();
-                                }
-                            }
-                            if (not the_binding) {
-                                the_binding = binding;
-                            }
-                        }
-
-                        const int index(dead_key.isNull() ? -1 : the_binding->accents().indexOf(dead_key));
-                        QPair<Key, KeyDescription> key_and_desc(keyAndDescFromTags(key, the_binding, row_num));
-
-                        key_and_desc.first.rLabel().setText(index < 0 ? the_binding->label()
-                                                                      : the_binding->accented_labels().at(index));
-                        key_and_desc.second.left_spacer = spacer_met;
-                        key_and_desc.second.right_spacer = false;
-
-                        skeyboard.keys.append(key_and_desc.first);
-                        skeyboard.key_descriptions.append(key_and_desc.second);
-                        spacer_met = false;
-                    } else { // spacer
-                        if (not skeyboard.key_descriptions.isEmpty()) {
-                            KeyDescription &previous_skey_description(skeyboard.key_descriptions.last());
-
-                            if (previous_skey_description.row == row_num) {
-                                previous_skey_description.right_spacer = true;
-                            }
-                        }
-                        spacer_met = true;
+    keyboard->keys.append(key_and_desc.first);
+    keyboard->key_descriptions.append(key_and_desc.second);
+}
+
+void appendSpacer(Keyboard *keyboard,
+                  int row)
+{
+    if (not keyboard->key_descriptions.isEmpty()) {
+        KeyDescription &previous_skey_description(keyboard->key_descriptions.last());
+
+        if (previous_skey_description.row == row) {
+            previous_skey_description.right_spacer = true;
+        }
+    }
+}
+
+//! \brief Builds keyboards from a section of \a tree.
+//!
+//! The plain keyboard and, if \a shifted is given, the shifted keyboard are
+//! filled in one walk over the section. The indices of the bindings used for
+//! each key are stored in \a bindings and \a shifted_bindings, if given, in
+//! key order, and so are the indices of the keys themselves in \a keys.
+void getKeyboards(const LayoutTree &tree,
+                  int section,
+                  Keyboard *keyboard,
+                  QVector<int> *bindings,
+                  Keyboard *shifted = 0,
+                  QVector<int> *shifted_bindings = 0,
+                  QVector<int> *keys = 0)
+{
+    const LayoutTree::Section &tree_section(tree.section(section));
+    int row_num(0);
+    QString section_style(tree.string(tree_section.style));
+    int key_count(0);
+
+    for (int row(tree_section.rows.first); row != -1; row = tree.row(row).next) {
+        bool spacer_met(false);
+
+        for (int element(tree.row(row).elements.first); element != -1; element = tree.element(element).next) {
+            const LayoutTree::Element &key(tree.element(element));
+
+            if (key.type == LayoutTree::Element::Key) {
+                const int binding(key.binding);
+
+                ++key_count;
+
+                appendKey(keyboard, tree, key, binding, row_num, spacer_met);
+                if (bindings) {
+                    bindings->append(binding);
+                }
+                if (keys) {
+                    keys->append(element);
+                }
+
+                if (shifted) {
+                    const int shifted_binding(tree.shiftedBinding(binding));
+
+                    appendKey(shifted, tree, key, shifted_binding, row_num, spacer_met);
+                    if (shifted_bindings) {
+                        shifted_bindings->append(shifted_binding);
                     }
                 }
-                ++row_num;
-            }
-            if (section_style.isEmpty()) {
-                section_style = "keys" + QString::number(key_count);
+                spacer_met = false;
+            } else { // spacer
+                appendSpacer(keyboard, row_num);
+                if (shifted) {
+                    appendSpacer(shifted, row_num);
+                }
+                spacer_met = true;
             }
-            skeyboard.style_name = section_style;
         }
+        ++row_num;
+    }
+    if (section_style.isEmpty()) {
+        section_style = "keys" + QString::number(key_count);
+    }
+    keyboard->style_name = section_style;
+    if (shifted) {
+        shifted->style_name = section_style;
     }
-    return skeyboard;
 }
 
-QPair<TagKeyPtr, TagBindingPtr> getTagKeyAndBinding(const TagKeyboardPtr &keyboard,
-                                                    const QString &label,
-                                                    bool *shifted)
+Keyboard getKeyboard(const LayoutTreePtr &tree,
+                     int page = 0)
 {
-    QPair<TagKeyPtr, TagBindingPtr> pair;
+    Keyboard skeyboard;
+
+    if (tree) {
+        const int layout(tree->keyboard().layouts.first);
 
-    if (keyboard) {
-        TagLayoutPtrs layouts(keyboard->layouts());
+        if (layout != -1) {
+            const int sections(tree->layout(layout).sections.count);
 
-        if (not layouts.isEmpty()) {
             // sections cannot be empty - parser does not allow that.
-            TagRowPtrs rows(layouts.first()->sections().first()->rows());
-
-            Q_FOREACH (const TagRowPtr &row, rows) {
-                TagRowElementPtrs elements(row->elements());
-
-                Q_FOREACH (const TagRowElementPtr &element, elements) {
-                    if (element->element_type() == TagRowElement::Key) {
-                        TagKeyPtr key(element.staticCast<TagKey>());
-                        TagBindingPtr the_binding;
-                        TagBindingPtr binding(key->binding());
-
-                        // Hotfix for suppressing long-press on space bringing
-                        // up extended keys if another key has empty label, in
-                        // given layout.
-                        // FIXME: Make extended keyboard/keyarea part of key
-                        // model instead, to avoid wrong lookups.
-                        if (binding->action() == TagBinding::Space) {
-                            continue;
-                        }
-                        if (binding->label() == label) {
-                            the_binding = binding;
-                            *shifted = false;
-                        } else {
-                            const TagModifiersPtrs all_modifiers(binding->modifiers());
-
-                            Q_FOREACH (const TagModifiersPtr &modifiers, all_modifiers) {
-                                const TagBindingPtr mod_binding(modifiers->binding());
-
-                                if (mod_binding->label() == label) {
-                                    the_binding = mod_binding;
-                                    *shifted = (modifiers->keys() == TagModifiers::Shift);
-                                    break;
-                                }
-                            }
-                        }
-
-                        if (the_binding) {
-                            pair.first = key;
-                            pair.second = the_binding;
-                            return pair;
-                        }
-                    }
-                }
+            if (sections > 0) {
+                getKeyboards(*tree, tree->sectionAt(layout, page % sections), &skeyboard, 0);
             }
         }
     }
-    return pair;
+    return skeyboard;
 }
 
-Keyboard getImportedKeyboard(const QString &id,
-                             ParserFunc func,
-                             const QString &file_prefix,
-                             const QString &default_file,
-                             int page = 0)
+//! \brief Adds a dead key variant of \a keyboard for every accent of its keys.
+//!
+//! Each variant is a copy of \a keyboard where the label of every key with
+//! the accent in its binding is replaced by the matching accented label.
+void addDeadKeyboards(const Keyboard &keyboard,
+                      const LayoutTree &tree,
+                      const QVector<int> &bindings,
+                      QHash<QChar, Keyboard> *dead_keyboards)
 {
-    QString path(getLanguagesDir() + "/" + id + ".xml");
-    QFile file(path);
+    for (int key_index(0); key_index < bindings.size(); ++key_index) {
+        const LayoutTree::Binding &binding(tree.binding(bindings.at(key_index)));
+        const QString &accents(tree.string(binding.accents));
+        const QString &accented_labels(tree.string(binding.accented_labels));
 
-    if (file.exists()) {
-        file.open(QIODevice::ReadOnly);
+        for (int index(0); index < accents.size() and index < accented_labels.size(); ++index) {
+            const QChar accent(accents.at(index));
 
-        LayoutParser parser(&file);
-        const bool result(parser.parse());
+            // Only the first occurence of an accent counts.
+            if (accents.indexOf(accent) != index) {
+                continue;
+            }
+
+            QHash<QChar, Keyboard>::iterator dead_keyboard(dead_keyboards->find(accent));
 
-        file.close();
-        if (result) {
-            const QStringList f_results((parser.*func)());
+            if (dead_keyboard == dead_keyboards->end()) {
+                dead_keyboard = dead_keyboards->insert(accent, keyboard);
+            }
 
-            Q_FOREACH (const QString &f_result, f_results) {
-                const QFileInfo file_info(getLanguagesDir() + "/" + f_result);
+            Key &dead_key(dead_keyboard->keys[key_index]);
 
-                if (file_info.exists() and file_info.isFile()) {
-                    const TagKeyboardPtr keyboard(getTagKeyboard(file_info.baseName()));
-                    return getKeyboard(keyboard, false, page);
-                }
+            // The accented key no longer is the key its extended keys belong
+            // to, so they are looked up by its label instead.
+            dead_key.rLabel().setText(accented_labels.at(index));
+            dead_key.setExtendedKeysId(-1);
+        }
+    }
+}
+
+//! \brief Builds the extended keyboard of a key.
+//!
+//! The Shift bindings of the extended keys are used if \a shifted is true.
+Keyboard getExtendedKeyboard(const LayoutTree &tree,
+                             const LayoutTree::Element &main_key,
+                             bool shifted)
+{
+    Keyboard skeyboard;
+    int row_index(0);
+
+    for (int row(main_key.extended_rows.first); row != -1; row = tree.row(row).next) {
+        for (int element(tree.row(row).elements.first); element != -1; element = tree.element(element).next) {
+            const LayoutTree::Element &key(tree.element(element));
+
+            if (key.type == LayoutTree::Element::Key) {
+                const int binding(shifted ? tree.shiftedBinding(key.binding) : key.binding);
+                QPair<Key, KeyDescription> key_and_desc(keyAndDescFromTree(tree, key, binding, row_index));
+
+                skeyboard.keys.append(key_and_desc.first);
+                skeyboard.key_descriptions.append(key_and_desc.second);
             }
+        }
+        ++row_index;
+    }
 
-            // If we got there then it means that we got xml layout file that does not use
-            // new <import> syntax or just does not specify explicitly which file to import.
-            // In this case we have to search imports list for entry with filename beginning
-            // with file_prefix.
-            const QStringList imports(parser.imports());
-            const QRegExp file_regexp("^(" + file_prefix + ".*).xml$");
+    return skeyboard;
+}
 
-            Q_FOREACH (const QString &import, imports) {
-                if (file_regexp.exactMatch(import)) {
-                    QFileInfo file_info(getLanguagesDir() + "/" + import);
+int extendedKeysId(int key_index,
+                   bool shifted)
+{
+    return (key_index * 2 + (shifted ? 1 : 0));
+}
 
-                    if (file_info.exists() and file_info.isFile()) {
-                        const TagKeyboardPtr keyboard(getTagKeyboard(file_regexp.cap(1)));
-                        return getKeyboard(keyboard, false, page);
-                    }
-                }
+//! \brief Builds the extended keyboards of all keys of a section.
+//!
+//! Every key with extended keys in \a keyboard and \a shifted gets an id
+//! under which its extended keyboard is stored in \a extended. Keys which do
+//! not come from the section are still looked up by label, so
+//! \a extended_labels maps labels to ids the same way the layout used to be
+//! scanned: the first key having the label in any of its bindings wins, and
+//! space keys are skipped. Keys without extended keys map to -1.
+void addExtendedKeyboards(const LayoutTree &tree,
+                          const QVector<int> &keys,
+                          Keyboard *keyboard,
+                          Keyboard *shifted,
+                          QHash<int, Keyboard> *extended,
+                          QHash<QString, int> *extended_labels)
+{
+    for (int key_index(0); key_index < keys.size(); ++key_index) {
+        const LayoutTree::Element &key(tree.element(keys.at(key_index)));
+        const LayoutTree::Binding &binding(tree.binding(key.binding));
+
+        if (key.extended) {
+            const int id(extendedKeysId(key_index, false));
+            const int shifted_id(extendedKeysId(key_index, true));
+
+            extended->insert(id, getExtendedKeyboard(tree, key, false));
+            extended->insert(shifted_id, getExtendedKeyboard(tree, key, true));
+            keyboard->keys[key_index].setExtendedKeysId(id);
+            shifted->keys[key_index].setExtendedKeysId(shifted_id);
+        }
+
+        if (binding.action == LayoutTree::Binding::Space) {
+            continue;
+        }
+
+        const QString &label(tree.string(binding.label));
+
+        if (not extended_labels->contains(label)) {
+            extended_labels->insert(label,
+                                    key.extended ? extendedKeysId(key_index, false) : -1);
+        }
+
+        for (int index(binding.modifiers.first); index != -1; index = tree.modifiers(index).next) {
+            const LayoutTree::Modifiers &modifiers(tree.modifiers(index));
+            const QString &modifiers_label(tree.string(tree.binding(modifiers.binding).label));
+
+            if (not extended_labels->contains(modifiers_label)) {
+                extended_labels->insert(modifiers_label,
+                                        key.extended ? extendedKeysId(key_index, modifiers.keys == LayoutTree::Modifiers::Shift) : -1);
             }
+        }
+    }
+}
+
+bool caseInsensitiveLessThan(const QString &s1,
+                             const QString &s2)
+{
+    return (s1.compare(s2, Qt::CaseInsensitive) < 0);
+}
+
+// Checks whether a layout is available, without warning if it is not.
+bool hasLayout(const QString &id)
+{
+    const QFileInfo file_info(getLanguagesDir() + "/" + id + ".xml");
+
+    return ((file_info.exists() and file_info.isFile()) or hasCompiledLayout(id, file_info));
+}
+
+//! \brief What the layout list needs to know about a layout.
+//!
+//! Modification time and size are the ones of the XML file, or -1 for
+//! layouts which are shipped only in the compiled image. The source hash is
+//! the content hash of the XML file at that modification time and size.
+struct LayoutMetadata
+{
+    QString title;
+    QString language;
+    qint64 last_modified;
+    qint64 size;
+    QByteArray source_hash;
+
+    LayoutMetadata()
+        : title()
+        , language()
+        , last_modified(-1)
+        , size(-1)
+        , source_hash()
+    {}
+
+    bool isCurrent(const QFileInfo &file_info) const
+    {
+        return (last_modified == file_info.lastModified().toMSecsSinceEpoch()
+                and size == file_info.size());
+    }
+};
+
+bool operator==(const LayoutMetadata &lhs,
+                const LayoutMetadata &rhs)
+{
+    return (lhs.title == rhs.title
+            and lhs.language == rhs.language
+            and lhs.last_modified == rhs.last_modified
+            and lhs.size == rhs.size
+            and lhs.source_hash == rhs.source_hash);
+}
+
+typedef QHash<QString, LayoutMetadata> LayoutMetadataHash;
+
+const char *const metadata_cache_file("layouts-metadata.cache");
+const quint32 metadata_cache_magic(0x4d4b4c4d); // "MKLM"
+const quint32 metadata_cache_version(2);
+
+QString getMetadataCachePath()
+{
+    return CoreUtils::maliitKeyboardCacheDirectory() + "/" + metadata_cache_file;
+}
+
+//! \brief Reads the metadata stored by writeMetadataCache().
+//!
+//! Nothing is returned if the cache was written for another languages
+//! directory or in another format.
+LayoutMetadataHash readMetadataCache(const QString &languages_dir)
+{
+    LayoutMetadataHash metadata;
+    QFile file(getMetadataCachePath());
+
+    if (not file.open(QIODevice::ReadOnly)) {
+        return metadata;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic(0);
+    quint32 version(0);
+    QString cached_languages_dir;
+    quint32 count(0);
+
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream >> magic >> version;
+
+    if (magic != metadata_cache_magic or version != metadata_cache_version) {
+        return metadata;
+    }
+
+    stream >> cached_languages_dir >> count;
 
-            // If we got there then we try to just load a file with name in default_file.
-            QFileInfo file_info(getLanguagesDir() + "/" + default_file);
+    if (cached_languages_dir != languages_dir) {
+        return metadata;
+    }
+
+    for (quint32 index(0); index < count and stream.status() == QDataStream::Ok; ++index) {
+        QString id;
+        LayoutMetadata entry;
+
+        stream >> id >> entry.title >> entry.language
+               >> entry.last_modified >> entry.size >> entry.source_hash;
+        metadata.insert(id, entry);
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        metadata.clear();
+    }
+
+    return metadata;
+}
+
+void writeMetadataCache(const QString &languages_dir,
+                        const LayoutMetadataHash &metadata)
+{
+    const QString path(getMetadataCachePath());
+
+    if (not QDir().mkpath(QFileInfo(path).path())) {
+        return;
+    }
+
+    // Several loaders may write the cache at the same time.
+    QTemporaryFile file(path + ".XXXXXX");
+
+    if (not file.open()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not write file:" << file.fileTemplate() << ", error:" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << metadata_cache_magic << metadata_cache_version
+           << languages_dir << quint32(metadata.size());
+
+    for (LayoutMetadataHash::const_iterator it(metadata.constBegin()); it != metadata.constEnd(); ++it) {
+        stream << it.key() << it->title << it->language
+               << it->last_modified << it->size << it->source_hash;
+    }
+
+    file.close();
+
+    // Replace the old cache only once the new one is complete.
+    QFile::remove(path);
+    if (file.rename(path)) {
+        file.setAutoRemove(false);
+    }
+}
+
+//! \brief Returns the source hashes stored in the metadata cache, by file path.
+SourceHashCache readSourceHashes(const QString &languages_dir)
+{
+    const LayoutMetadataHash metadata(readMetadataCache(languages_dir));
+    SourceHashCache hashes;
+
+    for (LayoutMetadataHash::const_iterator it(metadata.constBegin()); it != metadata.constEnd(); ++it) {
+        if (it->last_modified < 0 or it->source_hash.isEmpty()) {
+            continue;
+        }
+
+        SourceHash &entry(hashes[languages_dir + "/" + it.key() + ".xml"]);
+
+        entry.last_modified = it->last_modified;
+        entry.size = it->size;
+        entry.hash = it->source_hash;
+    }
 
-            if (file_info.exists() and file_info.isFile()) {
-                const TagKeyboardPtr keyboard(getTagKeyboard(file_info.baseName()));
-                return getKeyboard(keyboard, false);
+    return hashes;
+}
+
+//! \brief Reads the metadata of a layout from the root element of its file.
+bool readLayoutMetadata(const QFileInfo &file_info,
+                        LayoutMetadata *metadata)
+{
+    QFile file(file_info.filePath());
+
+    if (not file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    LayoutParser parser(&file);
+
+    if (not parser.parseHeader()) {
+        return false;
+    }
+
+    const LayoutTreePtr tree(parser.tree());
+
+    metadata->title = tree->string(tree->keyboard().title);
+    metadata->language = tree->string(tree->keyboard().language);
+    metadata->last_modified = file_info.lastModified().toMSecsSinceEpoch();
+    metadata->size = file_info.size();
+
+    return true;
+}
+
+//! \brief Returns the metadata of a layout shipped in the compiled image.
+LayoutMetadata getCompiledLayoutMetadata(const QString &id,
+                                         const QFileInfo &file_info)
+{
+    const LayoutImage &image(getLayoutImage());
+    LayoutMetadata metadata;
+
+    metadata.title = image.title(id);
+    metadata.language = image.language(id);
+    if (file_info.exists()) {
+        metadata.last_modified = file_info.lastModified().toMSecsSinceEpoch();
+        metadata.size = file_info.size();
+    }
+
+    return metadata;
+}
+
+//! \brief Reads the metadata of a layout whose file changed since the last scan.
+//!
+//! The file is hashed once, and its metadata taken from the compiled image
+//! if that holds an up to date copy of the layout.
+bool updateLayoutMetadata(const QString &id,
+                          const QFileInfo &file_info,
+                          LayoutMetadata *metadata)
+{
+    const QByteArray source_hash(getSourceHash(file_info));
+
+    if (getLayoutImage().sourceHash(id) == source_hash) {
+        *metadata = getCompiledLayoutMetadata(id, file_info);
+    } else if (not readLayoutMetadata(file_info, metadata)) {
+        return false;
+    }
+
+    metadata->source_hash = source_hash;
+    return true;
+}
+
+//! \brief Finds the id of the layout imported by \a main_keyboard for one kind of view.
+//!
+//! \a paged is set to false if only the first page of the returned layout
+//! should be used, which is the case for the default_file fallback.
+QString resolveImport(const LayoutTreePtr &main_keyboard,
+                      LayoutTree::Import::Type type,
+                      const QString &file_prefix,
+                      const QString &default_file,
+                      bool *paged)
+{
+    *paged = true;
+
+    if (not main_keyboard) {
+        return QString();
+    }
+
+    const QStringList f_results(main_keyboard->imports(type));
+
+    Q_FOREACH (const QString &f_result, f_results) {
+        const QString imported_id(QFileInfo(f_result).completeBaseName());
+
+        if (hasLayout(imported_id)) {
+            return imported_id;
+        }
+    }
+
+    // If we got there then it means that we got xml layout file that does not use
+    // new <import> syntax or just does not specify explicitly which file to import.
+    // In this case we have to search imports list for entry with filename beginning
+    // with file_prefix.
+    const QStringList imports(main_keyboard->imports(LayoutTree::Import::OldStyle));
+    const QString xml_suffix(".xml");
+
+    Q_FOREACH (const QString &import, imports) {
+        if (import.startsWith(file_prefix) and import.endsWith(xml_suffix)) {
+            const QString imported_id(import.left(import.size() - xml_suffix.size()));
+
+            if (hasLayout(imported_id)) {
+                return imported_id;
             }
-        } else {
-            qWarning() << __PRETTY_FUNCTION__ << "Could not parse file:" << path << ", error:" << parser.errorString();
         }
-    } else {
-        qWarning() << __PRETTY_FUNCTION__ << "File not found:" << path;
     }
-    return Keyboard();
+
+    // If we got there then we try to just load a file with name in default_file.
+    const QString default_id(QFileInfo(default_file).completeBaseName());
+
+    if (hasLayout(default_id)) {
+        *paged = false;
+        return default_id;
+    }
+
+    return QString();
+}
+
+//! \brief The layouts imported by a layout, for each kind of view.
+struct ResolvedImports
+{
+    LayoutTreePtr main_keyboard;
+    QString symbols;
+    bool symbols_paged;
+    QString number;
+    QString phone_number;
+
+    ResolvedImports()
+        : main_keyboard()
+        , symbols()
+        , symbols_paged(false)
+        , number()
+        , phone_number()
+    {}
+};
+
+//! \brief Pages of an imported layout, shared by all layouts importing it.
+struct ImportedPages
+{
+    LayoutTreePtr keyboard;
+    QVector<Keyboard> pages;
+};
+
+//! \brief Imports of layouts and the layouts they import, by id.
+//!
+//! An entry stays valid as long as the parsed layout it was built from is the
+//! one in the parsed layout cache.
+struct ImportsCache
+{
+    QMutex mutex;
+    QHash<QString, ResolvedImports> resolved;
+    QHash<QString, ImportedPages> imported;
+};
+
+ImportsCache &getImportsCache()
+{
+    static ImportsCache cache;
+
+    return cache;
+}
+
+ResolvedImports getResolvedImports(const QString &id,
+                                   const LayoutTreePtr &main_keyboard)
+{
+    ImportsCache &cache(getImportsCache());
+
+    {
+        QMutexLocker locker(&cache.mutex);
+        const QHash<QString, ResolvedImports>::const_iterator it(cache.resolved.find(id));
+
+        if (it != cache.resolved.constEnd() and it->main_keyboard == main_keyboard) {
+            return *it;
+        }
+    }
+
+    ResolvedImports imports;
+    bool paged(false);
+
+    imports.main_keyboard = main_keyboard;
+    imports.symbols = resolveImport(main_keyboard, LayoutTree::Import::Symview,
+                                    "symbols", "symbols_en.xml", &imports.symbols_paged);
+    imports.number = resolveImport(main_keyboard, LayoutTree::Import::Number,
+                                   "number", "number.xml", &paged);
+    imports.phone_number = resolveImport(main_keyboard, LayoutTree::Import::PhoneNumber,
+                                         "phonenumber", "phonenumber.xml", &paged);
+
+    QMutexLocker locker(&cache.mutex);
+
+    cache.resolved.insert(id, imports);
+    return imports;
 }
 
+//! \brief Returns all pages of an imported layout.
+//!
+//! The pages are built once per parsed layout. Keyboards are implicitly
+//! shared, so all layouts importing the same file share the same keys.
+QVector<Keyboard> getImportedPages(const QString &id)
+{
+    if (id.isEmpty()) {
+        return QVector<Keyboard>();
+    }
+
+    const LayoutTreePtr keyboard(getLayoutTree(id));
+    ImportsCache &cache(getImportsCache());
+
+    {
+        QMutexLocker locker(&cache.mutex);
+        const QHash<QString, ImportedPages>::const_iterator it(cache.imported.find(id));
+
+        if (it != cache.imported.constEnd() and it->keyboard == keyboard) {
+            return it->pages;
+        }
+    }
+
+    ImportedPages imported;
+
+    imported.keyboard = keyboard;
+
+    if (keyboard and keyboard->keyboard().layouts.count > 0) {
+        const int pages(keyboard->layout(keyboard->keyboard().layouts.first).sections.count);
+
+        for (int page(0); page < pages; ++page) {
+            imported.pages.append(getKeyboard(keyboard, page));
+        }
+    }
+
+    QMutexLocker locker(&cache.mutex);
+
+    cache.imported.insert(id, imported);
+    return imported.pages;
+}
+
+//! \brief All views of a layout.
+//!
+//! The views are built together when a layout gets activated, so switching
+//! between them later only picks the right one.
+struct KeyboardViews
+{
+    Keyboard main;
+    Keyboard shifted;
+    QHash<QChar, Keyboard> dead;
+    QHash<QChar, Keyboard> shifted_dead;
+    QVector<Keyboard> symbols;
+    Keyboard number;
+    Keyboard phone_number;
+    QHash<int, Keyboard> extended;
+    QHash<QString, int> extended_labels;
+};
+
+typedef QSharedPointer<const KeyboardViews> KeyboardViewsPtr;
+
+KeyboardViewsPtr getKeyboardViews(const QString &id,
+                                  const LayoutTreePtr &keyboard)
+{
+    QSharedPointer<KeyboardViews> views(new KeyboardViews);
+
+    if (not keyboard) {
+        return views;
+    }
+
+    const int layout(keyboard->keyboard().layouts.first);
+
+    if (layout != -1 and keyboard->layout(layout).sections.count > 0) {
+        QVector<int> bindings;
+        QVector<int> shifted_bindings;
+        QVector<int> keys;
+
+        getKeyboards(*keyboard, keyboard->layout(layout).sections.first,
+                     &views->main, &bindings,
+                     &views->shifted, &shifted_bindings,
+                     &keys);
+        addExtendedKeyboards(*keyboard, keys, &views->main, &views->shifted,
+                             &views->extended, &views->extended_labels);
+        addDeadKeyboards(views->main, *keyboard, bindings, &views->dead);
+        addDeadKeyboards(views->shifted, *keyboard, shifted_bindings, &views->shifted_dead);
+    }
+
+    const ResolvedImports imports(getResolvedImports(id, keyboard));
+
+    views->symbols = getImportedPages(imports.symbols);
+    if (not imports.symbols_paged and views->symbols.size() > 1) {
+        views->symbols.resize(1);
+    }
+
+    views->number = getImportedPages(imports.number).value(0);
+    views->phone_number = getImportedPages(imports.phone_number).value(0);
+
+    return views;
+}
+
+typedef QHash<QString, KeyboardViewsPtr> KeyboardViewsHash;
+
+//! \brief Views of the layouts next to the active one.
+//!
+//! Filled by NeighbourPrefetcher. Results of a prefetch are dropped if the
+//! generation was bumped while it ran.
+struct PrefetchedViews
+{
+    QMutex mutex;
+    int generation;
+    KeyboardViewsHash views;
+
+    PrefetchedViews()
+        : mutex()
+        , generation(0)
+        , views()
+    {}
+};
+
+//! \brief Builds the views of the neighbour layouts in a worker thread.
+//!
+//! Once done, neighboursPrefetched() of the loader is emitted in its thread.
+class NeighbourPrefetcher
+    : public QRunnable
+{
+private:
+    KeyboardLoader *const m_loader;
+    PrefetchedViews *const m_prefetched;
+    const int m_generation;
+    const QStringList m_ids;
+    const KeyboardViewsHash m_ready;
+
+public:
+    explicit NeighbourPrefetcher(KeyboardLoader *loader,
+                                 PrefetchedViews *prefetched,
+                                 int generation,
+                                 const QStringList &ids,
+                                 const KeyboardViewsHash &ready)
+        : m_loader(loader)
+        , m_prefetched(prefetched)
+        , m_generation(generation)
+        , m_ids(ids)
+        , m_ready(ready)
+    {}
+
+    void run()
+    {
+        KeyboardViewsHash views;
+
+        Q_FOREACH (const QString &id, m_ids) {
+            const KeyboardViewsPtr ready(m_ready.value(id));
+
+            views.insert(id, ready ? ready : getKeyboardViews(id, getLayoutTree(id)));
+        }
+
+        {
+            QMutexLocker locker(&m_prefetched->mutex);
+
+            if (m_prefetched->generation != m_generation) {
+                return;
+            }
+
+            m_prefetched->views = views;
+        }
+
+        QMetaObject::invokeMethod(m_loader, "neighboursPrefetched", Qt::QueuedConnection);
+    }
+};
+
 } // anonymous namespace
 
 namespace MaliitKeyboard {
@@ -380,42 +1113,291 @@ namespace MaliitKeyboard {
 class KeyboardLoaderPrivate
 {
 public:
-
     QString active_id;
+    mutable LayoutTreePtr active_keyboard;
+    mutable KeyboardViewsPtr active_views;
+    mutable QStringList ids;
+    mutable QHash<QString, int> id_indices;
+    mutable bool ids_valid;
+    mutable LayoutMetadataHash metadata;
+    mutable bool metadata_loaded;
+    mutable QFileSystemWatcher watcher;
+    mutable PrefetchedViews prefetched;
+    bool activated;
+    int prefetch_hits;
+    int prefetch_misses;
+    // Declared last, so that it is destroyed first: its destructor waits for
+    // a running prefetch, which uses the members above.
+    QThreadPool prefetch_pool;
+
+    explicit KeyboardLoaderPrivate();
+    LayoutTreePtr activeKeyboard() const;
+    const KeyboardViews &activeViews() const;
+    void updateIds() const;
+    QString title(const QString &id) const;
+    QString neighbourId(int offset) const;
+    KeyboardViewsPtr prefetchedViews(const QString &id) const;
+    void prefetchNeighbours(KeyboardLoader *loader,
+                            const KeyboardViewsHash &ready);
+    void clearPrefetchedViews();
 };
 
-KeyboardLoader::KeyboardLoader(QObject *parent)
-    : QObject(parent)
-    , d_ptr(new KeyboardLoaderPrivate)
+KeyboardLoaderPrivate::KeyboardLoaderPrivate()
+    : active_id()
+    , active_keyboard()
+    , active_views()
+    , ids()
+    , id_indices()
+    , ids_valid(false)
+    , metadata()
+    , metadata_loaded(false)
+    , watcher()
+    , prefetched()
+    , activated(false)
+    , prefetch_hits(0)
+    , prefetch_misses(0)
+    , prefetch_pool()
 {
-    setActiveId("en_us");
+    prefetch_pool.setMaxThreadCount(1);
 }
 
-KeyboardLoader::~KeyboardLoader()
-{}
-
-QStringList KeyboardLoader::ids() const
+//! \brief Scans the languages directory for language files.
+//!
+//! The result is kept until the watcher reports a change in the directory,
+//! so that the files are looked at only once and not on every layout switch.
+//! Title and language of every layout are kept in a cache on disk, so that
+//! only files changed since the last scan need to be read, and then only up
+//! to their root element.
+void KeyboardLoaderPrivate::updateIds() const
 {
-    QStringList ids;
-    QDir dir(getLanguagesDir(),
+    if (ids_valid) {
+        return;
+    }
+
+    const QString languages_dir(getLanguagesDir());
+    QDir dir(languages_dir,
              "*.xml",
              QDir::Name | QDir::IgnoreCase,
              QDir::Files | QDir::NoSymLinks | QDir::Readable);
 
+    const LayoutImage &image(getLayoutImage());
+    LayoutMetadataHash old_metadata(metadata_loaded ? metadata : readMetadataCache(languages_dir));
+    bool needs_sorting(false);
+
+    ids.clear();
+    id_indices.clear();
+    metadata.clear();
+    metadata_loaded = true;
+
     if (dir.exists()) {
+        if (not watcher.directories().contains(languages_dir)) {
+            watcher.addPath(languages_dir);
+        }
+
         QFileInfoList file_infos(dir.entryInfoList());
 
         Q_FOREACH (const QFileInfo &file_info, file_infos) {
-            QFile file(file_info.filePath());
-            file.open(QIODevice::ReadOnly);
-            LayoutParser parser(&file);
+            const QString id(file_info.completeBaseName());
+            const LayoutMetadataHash::const_iterator cached(old_metadata.find(id));
+            LayoutMetadata entry;
+
+            if (cached != old_metadata.constEnd() and cached->isCurrent(file_info)) {
+                entry = *cached;
+            } else if (not updateLayoutMetadata(id, file_info, &entry)) {
+                continue;
+            }
+
+            metadata.insert(id, entry);
+
+            if (not entry.language.isEmpty()) {
+                ids.append(id);
+            }
+        }
+    }
+
+    // Layouts which are shipped only in compiled form.
+    Q_FOREACH (const QString &id, image.ids()) {
+        if (not metadata.contains(id)) {
+            const LayoutMetadata entry(getCompiledLayoutMetadata(id, QFileInfo()));
+
+            metadata.insert(id, entry);
+
+            if (not entry.language.isEmpty()) {
+                ids.append(id);
+                needs_sorting = true;
+            }
+        }
+    }
+
+    if (needs_sorting) {
+        qSort(ids.begin(), ids.end(), caseInsensitiveLessThan);
+    }
+
+    for (int index(0); index < ids.size(); ++index) {
+        id_indices.insert(ids.at(index), index);
+    }
+
+    if (metadata != old_metadata) {
+        writeMetadataCache(languages_dir, metadata);
+    }
+
+    ids_valid = true;
+}
+
+//! \brief Returns the title of a layout, using the metadata of the last scan.
+//!
+//! The metadata of a layout whose file changed since is read again.
+QString KeyboardLoaderPrivate::title(const QString &id) const
+{
+    updateIds();
+
+    LayoutMetadataHash::iterator entry(metadata.find(id));
+
+    if (entry == metadata.end()) {
+        const LayoutTreePtr keyboard(getLayoutTree(id));
+
+        return (keyboard ? keyboard->string(keyboard->keyboard().title) : QString());
+    }
+
+    if (entry->last_modified < 0) {
+        return entry->title;
+    }
+
+    const QFileInfo file_info(getLanguagesDir() + "/" + id + ".xml");
+
+    if (not entry->isCurrent(file_info)) {
+        LayoutMetadata updated;
+
+        if (not updateLayoutMetadata(id, file_info, &updated)) {
+            return QString();
+        }
+
+        *entry = updated;
+        writeMetadataCache(getLanguagesDir(), metadata);
+    }
+
+    return entry->title;
+}
+
+//! \brief Returns the id found \a offset positions away from the active one.
+//!
+//! Going past the end wraps around to the first id, going past the beginning
+//! stops at the first id.
+QString KeyboardLoaderPrivate::neighbourId(int offset) const
+{
+    updateIds();
+
+    if (ids.isEmpty()) {
+        return QString();
+    }
+
+    int index(id_indices.value(active_id, -1) + offset);
+
+    if (index < 0 or index >= ids.size()) {
+        index = 0;
+    }
+
+    return ids.at(index);
+}
+
+KeyboardViewsPtr KeyboardLoaderPrivate::prefetchedViews(const QString &id) const
+{
+    QMutexLocker locker(&prefetched.mutex);
 
-            if (parser.isLanguageFile()) {
-                ids.append(file_info.baseName());
+    return prefetched.views.value(id);
+}
+
+//! \brief Starts building the views of the layouts next to the active one.
+//!
+//! Views in \a ready, as well as already prefetched ones, are reused instead
+//! of being built again.
+void KeyboardLoaderPrivate::prefetchNeighbours(KeyboardLoader *loader,
+                                               const KeyboardViewsHash &ready)
+{
+    QStringList neighbour_ids;
+
+    Q_FOREACH (const QString &id, QStringList() << neighbourId(-1) << neighbourId(+1)) {
+        if (not id.isEmpty() and id != active_id and not neighbour_ids.contains(id)) {
+            neighbour_ids.append(id);
+        }
+    }
+
+    KeyboardViewsHash reused;
+    int generation(0);
+
+    {
+        QMutexLocker locker(&prefetched.mutex);
+
+        generation = ++prefetched.generation;
+
+        Q_FOREACH (const QString &id, neighbour_ids) {
+            const KeyboardViewsPtr views(ready.contains(id) ? ready.value(id)
+                                                            : prefetched.views.value(id));
+
+            if (views) {
+                reused.insert(id, views);
             }
         }
     }
-    return ids;
+
+    if (not neighbour_ids.isEmpty()) {
+        prefetch_pool.start(new NeighbourPrefetcher(loader, &prefetched, generation,
+                                                    neighbour_ids, reused));
+    }
+}
+
+void KeyboardLoaderPrivate::clearPrefetchedViews()
+{
+    QMutexLocker locker(&prefetched.mutex);
+
+    ++prefetched.generation;
+    prefetched.views.clear();
+}
+
+// The active layout is looked up once per activation, so that switching
+// between its views afterwards never goes to the filesystem.
+LayoutTreePtr KeyboardLoaderPrivate::activeKeyboard() const
+{
+    if (not active_keyboard) {
+        active_keyboard = getLayoutTree(active_id);
+    }
+
+    return active_keyboard;
+}
+
+const KeyboardViews &KeyboardLoaderPrivate::activeViews() const
+{
+    if (not active_views) {
+        active_views = getKeyboardViews(active_id, activeKeyboard());
+    }
+
+    return *active_views;
+}
+
+KeyboardLoader::KeyboardLoader(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new KeyboardLoaderPrivate)
+{
+    Q_D(KeyboardLoader);
+
+    connect(&d->watcher, SIGNAL(directoryChanged(QString)),
+            this,        SLOT(onLanguagesDirectoryChanged()));
+
+    // The default layout is only loaded once it is used, and neither counts
+    // as a prefetch miss nor starts prefetching: most loaders get another
+    // layout activated right away, or are thrown away.
+    d->active_id = "en_us";
+}
+
+KeyboardLoader::~KeyboardLoader()
+{}
+
+QStringList KeyboardLoader::ids() const
+{
+    Q_D(const KeyboardLoader);
+
+    d->updateIds();
+    return d->ids;
 }
 
 QString KeyboardLoader::activeId() const
@@ -428,50 +1410,124 @@ void KeyboardLoader::setActiveId(const QString &id)
 {
     Q_D(KeyboardLoader);
 
-    if (d->active_id != id) {
+    if (d->active_id == id) {
+        // Explicitly activating the default layout starts prefetching.
+        if (not d->activated) {
+            d->activated = true;
+            d->prefetchNeighbours(this, KeyboardViewsHash());
+        }
+    } else {
+        KeyboardViewsHash ready;
+
+        if (d->active_views) {
+            ready.insert(d->active_id, d->active_views);
+        }
+
         d->active_id = id;
+        d->active_keyboard.clear();
+        d->active_views = d->prefetchedViews(id);
+
+        if (d->active_views) {
+            ++d->prefetch_hits;
+        } else {
+            ++d->prefetch_misses;
+            d->activeViews();
+        }
+
+        d->activated = true;
+        d->prefetchNeighbours(this, ready);
 
-        // FIXME: Emit only after parsing new keyboard.
         Q_EMIT keyboardsChanged();
     }
 }
 
+void KeyboardLoader::invalidateCache(const QString &id)
+{
+    Q_D(KeyboardLoader);
+
+    {
+        QMutexLocker locker(&getLayoutTreeCacheMutex());
+
+        if (id.isEmpty()) {
+            getLayoutTreeCache().clear();
+        } else {
+            getLayoutTreeCache().remove(id);
+        }
+    }
+
+    {
+        ImportsCache &cache(getImportsCache());
+        QMutexLocker locker(&cache.mutex);
+
+        cache.resolved.clear();
+        cache.imported.clear();
+    }
+
+    // Views of the active layout may also come from an imported layout, so
+    // they are rebuilt on any invalidation, and so are the prefetched ones.
+    d->active_keyboard.clear();
+    d->active_views.clear();
+    d->clearPrefetchedViews();
+    d->ids_valid = false;
+
+    Q_EMIT neighboursPrefetched();
+
+    if (id.isEmpty() or id == d->active_id) {
+        Q_EMIT keyboardsChanged();
+    }
+
+    if (d->activated) {
+        d->prefetchNeighbours(this, KeyboardViewsHash());
+    }
+}
+
 QString KeyboardLoader::title(const QString &id) const
 {
-    const TagKeyboardPtr keyboard(getTagKeyboard(id));
+    Q_D(const KeyboardLoader);
+
+    return d->title(id);
+}
+
+//! \brief Returns the content hash of the XML file a layout is read from.
+//!
+//! For layouts which are shipped only in the compiled image, this is the hash
+//! the image was compiled from. The file is only hashed again when its size
+//! or modification time changed.
+QByteArray KeyboardLoader::sourceHash(const QString &id) const
+{
+    const QFileInfo file_info(getLanguagesDir() + "/" + id + ".xml");
 
-    if (keyboard) {
-        return keyboard->title();
+    if (file_info.exists()) {
+        return getSourceHash(file_info);
     }
 
-    return QString();
+    return getLayoutImage().sourceHash(id);
 }
 
 Keyboard KeyboardLoader::keyboard() const
 {
     Q_D(const KeyboardLoader);
-    TagKeyboardPtr keyboard(getTagKeyboard(d->active_id));
 
-    return getKeyboard(keyboard);
+    return d->activeViews().main;
 }
 
 Keyboard KeyboardLoader::nextKeyboard() const
 {
     Q_D(const KeyboardLoader);
 
-    const QStringList all_ids(ids());
+    const QString next_id(d->neighbourId(+1));
 
-    if (all_ids.isEmpty()) {
+    if (next_id.isEmpty()) {
         return Keyboard();
     }
 
-    int next_index(all_ids.indexOf(d->active_id) + 1);
+    const KeyboardViewsPtr views(d->prefetchedViews(next_id));
 
-    if (next_index >= all_ids.size()) {
-        next_index = 0;
+    if (views) {
+        return views->main;
     }
 
-    TagKeyboardPtr keyboard(getTagKeyboard(all_ids[next_index]));
+    LayoutTreePtr keyboard(getLayoutTree(next_id));
 
     return getKeyboard(keyboard);
 }
@@ -480,19 +1536,19 @@ Keyboard KeyboardLoader::previousKeyboard() const
 {
     Q_D(const KeyboardLoader);
 
-    const QStringList all_ids(ids());
+    const QString previous_id(d->neighbourId(-1));
 
-    if (all_ids.isEmpty()) {
+    if (previous_id.isEmpty()) {
         return Keyboard();
     }
 
-    int previous_index(all_ids.indexOf(d->active_id) - 1);
+    const KeyboardViewsPtr views(d->prefetchedViews(previous_id));
 
-    if (previous_index < 0) {
-        previous_index = 0;
+    if (views) {
+        return views->main;
     }
 
-    TagKeyboardPtr keyboard(getTagKeyboard(all_ids[previous_index]));
+    LayoutTreePtr keyboard(getLayoutTree(previous_id));
 
     return getKeyboard(keyboard);
 }
@@ -500,122 +1556,143 @@ Keyboard KeyboardLoader::previousKeyboard() const
 Keyboard KeyboardLoader::shiftedKeyboard() const
 {
     Q_D(const KeyboardLoader);
-    TagKeyboardPtr keyboard(getTagKeyboard(d->active_id));
 
-    return getKeyboard(keyboard, true);
+    return d->activeViews().shifted;
 }
 
 Keyboard KeyboardLoader::symbolsKeyboard(int page) const
 {
     Q_D(const KeyboardLoader);
+    const QVector<Keyboard> &symbols(d->activeViews().symbols);
 
-    return getImportedKeyboard(d->active_id, &LayoutParser::symviews, "symbols", "symbols_en.xml", page);
+    if (symbols.isEmpty() or page < 0) {
+        return Keyboard();
+    }
+
+    return symbols.at(page % symbols.size());
 }
 
 Keyboard KeyboardLoader::deadKeyboard(const Key &dead) const
 {
     Q_D(const KeyboardLoader);
-    TagKeyboardPtr keyboard(getTagKeyboard(d->active_id));
+    const KeyboardViews &views(d->activeViews());
+    const QString dead_label(dead.label().text());
 
-    return getKeyboard(keyboard, false, 0, dead.label().text());
+    if (dead_label.size() != 1) {
+        return views.main;
+    }
+
+    return views.dead.value(dead_label.at(0), views.main);
 }
 
 Keyboard KeyboardLoader::shiftedDeadKeyboard(const Key &dead) const
 {
     Q_D(const KeyboardLoader);
-    TagKeyboardPtr keyboard(getTagKeyboard(d->active_id));
+    const KeyboardViews &views(d->activeViews());
+    const QString dead_label(dead.label().text());
+
+    if (dead_label.size() != 1) {
+        return views.shifted;
+    }
 
-    return getKeyboard(keyboard, true, 0, dead.label().text());
+    return views.shifted_dead.value(dead_label.at(0), views.shifted);
 }
 
 Keyboard KeyboardLoader::extendedKeyboard(const Key &key) const
 {
-    // Hotfix for suppressing long-press on space bringing up extended keys if
-    // another key has empty label, in given layout.
-    // FIXME: Make extended keyboard/keyarea part of key model instead, to
-    // avoid wrong lookups.
-    if (key.action() == Key::ActionSpace) {
-        return Keyboard();
-    }
-
     Q_D(const KeyboardLoader);
-    const TagKeyboardPtr keyboard(getTagKeyboard(d->active_id));
-    bool shifted(false);
-    const QPair<TagKeyPtr, TagBindingPtr> pair(getTagKeyAndBinding(keyboard, key.label().text(), &shifted));
-    Keyboard skeyboard;
+    const KeyboardViews &views(d->activeViews());
+    int id(key.extendedKeysId());
+
+    if (id < 0) {
+        // Suppress long-press on space bringing up extended keys if another
+        // key has empty label, in given layout.
+        if (key.action() == Key::ActionSpace) {
+            return Keyboard();
+        }
 
-    if (pair.first and pair.second) {
-        const TagExtendedPtr extended(pair.first->extended());
+        id = views.extended_labels.value(key.label().text(), -1);
+    }
 
-        if (extended) {
-            const TagRowPtrs rows(extended->rows());
-            int row_index(0);
+    Keyboard skeyboard(views.extended.value(id));
+
+    // I don't like this prepending source key idea - it should be done
+    // in language layout file.
+    if (not skeyboard.keys.isEmpty()
+        and skeyboard.key_descriptions.last().row == 0
+        and not key.label().text().isEmpty()
+        and key.action() == Key::ActionInsert) {
+        Key first_key(skeyboard.keys.first());
+        KeyDescription first_desc(skeyboard.key_descriptions.first());
+
+        first_key.rLabel().setText(key.label().text());
+        first_key.setIcon(key.icon());
+        skeyboard.keys.prepend(first_key);
+        skeyboard.key_descriptions.prepend(first_desc);
+    }
 
-            Q_FOREACH (const TagRowPtr &row, rows) {
-                const TagRowElementPtrs elements(row->elements());
+    return skeyboard;
+}
 
-                Q_FOREACH (const TagRowElementPtr &element, elements) {
-                    switch (element->element_type()) {
-                    case TagRowElement::Key: {
-                        const TagKeyPtr key(element.staticCast<TagKey>());
-                        const TagBindingPtr binding(key->binding());
-                        TagBindingPtr the_binding;
+//! \brief Returns the ids of the layouts whose views are prefetched.
+QStringList KeyboardLoader::prefetchedIds() const
+{
+    Q_D(const KeyboardLoader);
+    QMutexLocker locker(&d->prefetched.mutex);
 
-                        if (shifted) {
-                            const TagModifiersPtrs all_modifiers(binding->modifiers());
+    return d->prefetched.views.keys();
+}
 
-                            Q_FOREACH(const TagModifiersPtr &modifiers, all_modifiers) {
-                                if (modifiers->keys() == TagModifiers::Shift) {
-                                    the_binding = modifiers->binding();
-                                }
-                            }
-                        }
-                        if (not the_binding) {
-                            the_binding = binding;
-                        }
+//! \brief Returns the main view of a prefetched layout.
+//!
+//! An empty keyboard is returned if the layout is not prefetched.
+Keyboard KeyboardLoader::prefetchedKeyboard(const QString &id) const
+{
+    Q_D(const KeyboardLoader);
+    const KeyboardViewsPtr views(d->prefetchedViews(id));
 
-                        QPair<Key, KeyDescription> key_and_desc(keyAndDescFromTags(key, the_binding, row_index));
+    return (views ? views->main : Keyboard());
+}
 
-                        skeyboard.keys.append(key_and_desc.first);
-                        skeyboard.key_descriptions.append(key_and_desc.second);
-                    } break;
+//! \brief Returns how often an activated layout had been prefetched.
+int KeyboardLoader::prefetchHits() const
+{
+    Q_D(const KeyboardLoader);
+    return d->prefetch_hits;
+}
 
-                    case TagRowElement::Spacer:
-                        break;
-                    }
-                }
-                ++row_index;
-            }
-            // I don't like this prepending source key idea - it should be done
-            // in language layout file.
-            if (row_index == 1
-                and not key.label().text().isEmpty()
-                and key.action() == Key::ActionInsert) {
-                Key first_key(skeyboard.keys.first());
-                KeyDescription first_desc(skeyboard.key_descriptions.first());
-
-                first_key.rLabel().setText(key.label().text());
-                first_key.setIcon(key.icon());
-                skeyboard.keys.prepend(first_key);
-                skeyboard.key_descriptions.prepend(first_desc);
-            }
-        }
-    }
-    return skeyboard;
+//! \brief Returns how often an activated layout had to be loaded on activation.
+int KeyboardLoader::prefetchMisses() const
+{
+    Q_D(const KeyboardLoader);
+    return d->prefetch_misses;
 }
 
 Keyboard KeyboardLoader::numberKeyboard() const
 {
     Q_D(const KeyboardLoader);
 
-    return getImportedKeyboard(d->active_id, &LayoutParser::numbers, "number", "number.xml");
+    return d->activeViews().number;
 }
 
 Keyboard KeyboardLoader::phoneNumberKeyboard() const
 {
     Q_D(const KeyboardLoader);
 
-    return getImportedKeyboard(d->active_id, &LayoutParser::phonenumbers, "phonenumber", "phonenumber.xml");
+    return d->activeViews().phone_number;
+}
+
+void KeyboardLoader::onLanguagesDirectoryChanged()
+{
+    Q_D(KeyboardLoader);
+
+    d->ids_valid = false;
+
+    // Imported layouts may have been added or removed.
+    ImportsCache &cache(getImportsCache());
+    QMutexLocker locker(&cache.mutex);
+
+    cache.resolved.clear();
 }
 
 } // namespace MaliitKeyboard
@@ -42,6 +42,9 @@ namespace MaliitKeyboard {
 
 class KeyboardLoaderPrivate;
 
+class KeyboardLoader;
+typedef QSharedPointer<KeyboardLoader> SharedKeyboardLoader;
+
 class KeyboardLoader
     : public QObject
 {
@@ -56,8 +59,10 @@ public:
     virtual QStringList ids() const;
     virtual QString activeId() const;
     virtual void setActiveId(const QString &id);
+    virtual void invalidateCache(const QString &id = QString());
 
     virtual QString title(const QString &id) const;
+    virtual QByteArray sourceHash(const QString &id) const;
 
     virtual Keyboard keyboard() const;
     virtual Keyboard nextKeyboard() const;
@@ -71,9 +76,18 @@ public:
     virtual Keyboard numberKeyboard() const;
     virtual Keyboard phoneNumberKeyboard() const;
 
+    virtual QStringList prefetchedIds() const;
+    virtual Keyboard prefetchedKeyboard(const QString &id) const;
+    int prefetchHits() const;
+    int prefetchMisses() const;
+
     Q_SIGNAL void keyboardsChanged() const;
+    //! Emitted when the set of prefetched layouts changed.
+    Q_SIGNAL void neighboursPrefetched() const;
 
 private:
+    Q_SLOT void onLanguagesDirectoryChanged();
+
     const QScopedPointer<KeyboardLoaderPrivate> d_ptr;
 };
 
@@ -30,9 +30,6 @@
  *
  */
 
-#include <algorithm>
-#include <tr1/functional>
-
 #include "layouthelper.h"
 #include "coreutils.h"
 
@@ -41,43 +38,51 @@ namespace Logic {
 
 namespace {
 
-bool removeKey(QVector<Key> *keys,
-               const Key &key)
+// Keys never overlap within a panel, so their origins identify them.
+quint64 originKey(const QPoint &origin)
 {
-    if (not keys) {
-        return false;
+    return (quint64(quint32(origin.x())) << 32) | quint32(origin.y());
+}
+
+// Returns the key as it should be shown with the given overrides applied.
+Key overridenKey(const Key &key,
+                 const KeyOverrides &overrides,
+                 const QString &id)
+{
+    const KeyOverrides::const_iterator override(overrides.find(id));
+
+    if (override == overrides.end()) {
+        return key;
     }
 
-    for (int index = 0; index < keys->count(); ++index) {
-        const Key &current(keys->at(index));
-        if (current.origin() == key.origin()
-                && current.label() == key.label()) {
-            keys->remove(index);
-            return true;
-        }
+    Key result(key);
+
+    if (not override->label().text().isEmpty()) {
+        result.rLabel().setText(override->label().text());
+    }
+
+    if (not override->icon().isEmpty()) {
+        result.setIcon(override->icon());
     }
 
-    return false;
+    return result;
 }
 
-struct KeyPredicate
+//! Active (pressed) keys of a panel, addressed by their index in the panel.
+struct ActiveKeys
 {
-    KeyPredicate(const QSet<QString> &changed_ids)
-        : m_changed_ids(changed_ids)
-    {}
+    QBitArray mask; //!< Set bits are active keys.
+    QVector<int> order; //!< Indices of the active keys, in press order.
+    QVector<Key> keys; //!< Active keys, in press order.
 
-    bool operator()(Key &key)
+    bool contains(int index) const
     {
-        return (m_changed_ids.constFind(CoreUtils::idFromKey(key)) != m_changed_ids.constEnd());
+        return (index < mask.size() && mask.testBit(index));
     }
-
-    const QSet<QString> &m_changed_ids;
 };
 
 } // namespace
 
-typedef std::tr1::function<void(const KeyArea &, const KeyOverrides &)> EmitFunc;
-
 class LayoutHelperPrivate
 {
 public:
@@ -94,24 +99,30 @@ public:
     // TODO: Make WordCandidates part of KeyArea
     WordRibbon ribbon;
 
-    // TODO: Store active keys in KeyArea
-    struct {
-        QVector<Key> left;
-        QVector<Key> right;
-        QVector<Key> center;
-        QVector<Key> extended;
-    } active_keys;
+    ActiveKeys active_keys[LayoutHelper::NumPanels];
 
-    Key magnifier_key;
+    KeyArea magnifier;
     KeyOverrides overriden_keys;
 
+    // Maps key ids to their indices in each panel, so that overrides only
+    // need to touch the affected keys:
+    QMultiHash<QString, int> key_index[LayoutHelper::NumPanels];
+    QHash<quint64, int> origin_index[LayoutHelper::NumPanels];
+
+    // Panel and word ribbon changes made during an update are only emitted
+    // when the update is committed:
+    int update_depth;
+    bool panel_dirty[LayoutHelper::NumPanels];
+    bool ribbon_dirty;
+
     explicit LayoutHelperPrivate();
 
     KeyArea lookup(LayoutHelper::Panel panel) const;
+    KeyArea overridenPanel(LayoutHelper::Panel panel) const;
     QPoint panelOrigin() const;
-    void overrideCheck(const QSet<QString> &changed_ids,
-                       KeyArea &key_area,
-                       const EmitFunc& func);
+    QVector<int> updateKeyIndices(LayoutHelper::Panel panel);
+    int indexOf(LayoutHelper::Panel panel,
+                const Key &key) const;
 };
 
 LayoutHelperPrivate::LayoutHelperPrivate()
@@ -125,9 +136,15 @@ LayoutHelperPrivate::LayoutHelperPrivate()
     , extended()
     , ribbon()
     , active_keys()
-    , magnifier_key()
+    , magnifier()
     , overriden_keys()
-{}
+    , update_depth(0)
+    , ribbon_dirty(false)
+{
+    for (int panel = 0; panel < LayoutHelper::NumPanels; ++panel) {
+        panel_dirty[panel] = false;
+    }
+}
 
 KeyArea LayoutHelperPrivate::lookup(LayoutHelper::Panel panel) const
 {
@@ -144,21 +161,91 @@ KeyArea LayoutHelperPrivate::lookup(LayoutHelper::Panel panel) const
     return KeyArea();
 }
 
+// Returns the panel as views should show it, with the overrides applied.
+// Panels without overridden keys are returned as they are.
+KeyArea LayoutHelperPrivate::overridenPanel(LayoutHelper::Panel panel) const
+{
+    KeyArea area(lookup(panel));
+    const QMultiHash<QString, int> &index(key_index[panel]);
+    QVector<Key> keys;
+
+    for (KeyOverrides::const_iterator o(overriden_keys.begin()), oe(overriden_keys.end()); o != oe; ++o) {
+        for (QMultiHash<QString, int>::const_iterator i(index.constFind(o.key())), e(index.constEnd());
+             i != e && i.key() == o.key(); ++i) {
+            if (keys.isEmpty()) {
+                keys = area.keys();
+            }
+
+            keys[i.value()] = overridenKey(keys.at(i.value()), overriden_keys, o.key());
+        }
+    }
+
+    if (not keys.isEmpty()) {
+        area.setKeys(keys);
+    }
+
+    return area;
+}
+
 QPoint LayoutHelperPrivate::panelOrigin() const
 {
     return QPoint(0, ribbon.area().size().height());
 }
 
-void LayoutHelperPrivate::overrideCheck(const QSet<QString> &changed_ids,
-                                  KeyArea &key_area,
-                                  const EmitFunc &func)
+//! \brief Rebuilds the key indices of a panel after it changed.
+//!
+//! Returns the former indices of the active keys which have no key at their
+//! position in the new panel, and are no longer active.
+QVector<int> LayoutHelperPrivate::updateKeyIndices(LayoutHelper::Panel panel)
 {
-    QVector<Key> &keys(key_area.rKeys());
-    KeyPredicate predicate(changed_ids);
+    QMultiHash<QString, int> &ids(key_index[panel]);
+    QHash<quint64, int> &origins(origin_index[panel]);
+    const QVector<Key> &keys(lookup(panel).keys());
+
+    ids.clear();
+    ids.reserve(keys.count());
+    origins.clear();
+    origins.reserve(keys.count());
+
+    for (int index = 0; index < keys.count(); ++index) {
+        const Key &key(keys.at(index));
+        const QString &id(CoreUtils::idFromKey(key));
+
+        if (not id.isEmpty()) {
+            ids.insert(id, index);
+        }
+
+        origins.insert(originKey(key.origin()), index);
+    }
 
-    if (std::find_if(keys.begin(), keys.end(), predicate) != keys.end()) {
-        func(key_area, overriden_keys);
+    // Keys that are still held keep their active state if the new panel has
+    // a key at the same position, e.g. shift while switching to upper case:
+    ActiveKeys &active(active_keys[panel]);
+    ActiveKeys remapped;
+    QVector<int> dropped;
+    remapped.mask.resize(keys.count());
+
+    for (int i = 0; i < active.keys.count(); ++i) {
+        const Key &key(active.keys.at(i));
+        const int index(origins.value(originKey(key.origin()), -1));
+
+        if (index >= 0 && not remapped.mask.testBit(index)) {
+            remapped.mask.setBit(index);
+            remapped.order.append(index);
+            remapped.keys.append(key);
+        } else {
+            dropped.append(active.order.at(i));
+        }
     }
+
+    active = remapped;
+    return dropped;
+}
+
+int LayoutHelperPrivate::indexOf(LayoutHelper::Panel panel,
+                                 const Key &key) const
+{
+    return origin_index[panel].value(originKey(key.origin()), -1);
 }
 
 LayoutHelper::LayoutHelper(QObject *parent)
@@ -259,6 +346,75 @@ QRect LayoutHelper::activeKeyAreaGeometry() const
     return QRect();
 }
 
+//! \brief Starts a batch of layout changes.
+//!
+//! Until the matching commitUpdate(), setting a panel or the word ribbon only
+//! marks it dirty. Updates can be nested.
+void LayoutHelper::beginUpdate()
+{
+    Q_D(LayoutHelper);
+    ++d->update_depth;
+}
+
+//! \brief Ends a batch of layout changes.
+//!
+//! When the outermost update is committed, every panel that was set during
+//! the update is emitted once, with its latest value.
+void LayoutHelper::commitUpdate()
+{
+    Q_D(LayoutHelper);
+
+    if (d->update_depth <= 0) {
+        qWarning() << __PRETTY_FUNCTION__
+                   << "No update to commit.";
+        return;
+    }
+
+    if (--d->update_depth > 0) {
+        return;
+    }
+
+    for (int panel = 0; panel < NumPanels; ++panel) {
+        if (d->panel_dirty[panel]) {
+            d->panel_dirty[panel] = false;
+            notifyPanelChanged(static_cast<Panel>(panel));
+        }
+    }
+
+    if (d->ribbon_dirty) {
+        d->ribbon_dirty = false;
+        Q_EMIT wordRibbonChanged(d->ribbon);
+    }
+}
+
+bool LayoutHelper::isUpdating() const
+{
+    Q_D(const LayoutHelper);
+    return (d->update_depth > 0);
+}
+
+void LayoutHelper::notifyPanelChanged(Panel panel)
+{
+    Q_D(LayoutHelper);
+
+    if (d->update_depth > 0) {
+        d->panel_dirty[panel] = true;
+        return;
+    }
+
+    // Views are given the panel with overrides already applied, so that
+    // patched keys do not revert whenever the panel changes:
+    const KeyArea &area(d->overridenPanel(panel));
+
+    switch (panel) {
+    case LeftPanel: Q_EMIT leftPanelChanged(area, d->overriden_keys); break;
+    case RightPanel: Q_EMIT rightPanelChanged(area, d->overriden_keys); break;
+    case CenterPanel: Q_EMIT centerPanelChanged(area, d->overriden_keys); break;
+    case ExtendedPanel: Q_EMIT extendedPanelChanged(area, d->overriden_keys); break;
+    case NumPanels: break;
+    }
+}
+
 KeyArea LayoutHelper::leftPanel() const
 {
     Q_D(const LayoutHelper);
@@ -271,7 +427,8 @@ void LayoutHelper::setLeftPanel(const KeyArea &left)
 
     if (d->left != left) {
         d->left = left;
-        Q_EMIT leftPanelChanged(d->left, d->overriden_keys);
+        updateKeyIndices(LeftPanel);
+        notifyPanelChanged(LeftPanel);
     }
 }
 
@@ -287,7 +444,8 @@ void LayoutHelper::setRightPanel(const KeyArea &right)
 
     if (d->right != right) {
         d->right = right;
-        Q_EMIT rightPanelChanged(d->right, d->overriden_keys);
+        updateKeyIndices(RightPanel);
+        notifyPanelChanged(RightPanel);
     }
 }
 
@@ -303,7 +461,8 @@ void LayoutHelper::setCenterPanel(const KeyArea &center)
 
     if (d->center != center) {
         d->center = center;
-        Q_EMIT centerPanelChanged(d->center, d->overriden_keys);
+        updateKeyIndices(CenterPanel);
+        notifyPanelChanged(CenterPanel);
     }
 }
 
@@ -319,7 +478,8 @@ void LayoutHelper::setExtendedPanel(const KeyArea &extended)
 
     if (d->extended != extended) {
         d->extended = extended;
-        Q_EMIT extendedPanelChanged(d->extended, d->overriden_keys);
+        updateKeyIndices(ExtendedPanel);
+        notifyPanelChanged(ExtendedPanel);
     }
 }
 
@@ -335,7 +495,12 @@ void LayoutHelper::setWordRibbon(const WordRibbon &ribbon)
 
     if (d->ribbon != ribbon) {
         d->ribbon = ribbon;
-        Q_EMIT wordRibbonChanged(d->ribbon);
+
+        if (d->update_depth > 0) {
+            d->ribbon_dirty = true;
+        } else {
+            Q_EMIT wordRibbonChanged(d->ribbon);
+        }
     }
 }
 
@@ -343,32 +508,64 @@ QVector<Key> LayoutHelper::activeKeys() const
 {
     Q_D(const LayoutHelper);
 
-    switch (d->active_panel) {
-    case LeftPanel: return d->active_keys.left;
-    case RightPanel: return d->active_keys.right;
-    case CenterPanel: return d->active_keys.center;
-    case ExtendedPanel: return d->active_keys.extended;
-    case NumPanels: break;
+    if (d->active_panel == NumPanels) {
+        return QVector<Key>();
     }
 
-    return QVector<Key>();
+    return d->active_keys[d->active_panel].keys;
+}
+
+//! \brief Returns whether the key at index in panel is currently pressed.
+bool LayoutHelper::isActiveKey(Panel panel,
+                               int index) const
+{
+    Q_D(const LayoutHelper);
+    return (panel != NumPanels && d->active_keys[panel].contains(index));
 }
 
+//! \brief Updates the key indices of a panel after it changed.
+//!
+//! Emits activeKeyRemoved for every active key that is dropped because the
+//! new panel has no key at its position.
+void LayoutHelper::updateKeyIndices(Panel panel)
+{
+    Q_D(LayoutHelper);
+
+    Q_FOREACH (int index, d->updateKeyIndices(panel)) {
+        Q_EMIT activeKeyRemoved(panel, index);
+    }
+}
+
+//! \brief Deactivates all active keys.
+//!
+//! Emits activeKeyRemoved for every key that was active, and nothing if no
+//! key was active.
 void LayoutHelper::clearActiveKeys()
 {
     Q_D(LayoutHelper);
 
-    d->active_keys.left.clear();
-    d->active_keys.right.clear();
-    d->active_keys.center.clear();
-    d->active_keys.extended.clear();
+    for (int panel = 0; panel < NumPanels; ++panel) {
+        ActiveKeys &active(d->active_keys[panel]);
 
-    QVector<Key> empty;
-    KeyOverrides empty_overrides;
-    Q_EMIT activeKeysChanged(empty, empty_overrides);
-    Q_EMIT activeExtendedKeysChanged(empty, empty_overrides);
+        if (active.order.isEmpty()) {
+            continue;
+        }
+
+        const QVector<int> order(active.order);
+        active.mask.fill(false);
+        active.order.clear();
+        active.keys.clear();
+
+        Q_FOREACH (int index, order) {
+            Q_EMIT activeKeyRemoved(static_cast<Panel>(panel), index);
+        }
+    }
 }
 
+//! \brief Marks key of the active panel as pressed.
+//!
+//! The key is looked up by its origin, so it can be a modified copy of the
+//! panel's key, e.g. with pressed state background.
 void LayoutHelper::appendActiveKey(const Key &key)
 {
     Q_D(LayoutHelper);
@@ -376,18 +573,24 @@ void LayoutHelper::appendActiveKey(const Key &key)
     switch (d->active_panel) {
     case LeftPanel:
     case RightPanel:
-    case NumPanels: break;
+    case NumPanels: return;
 
     case CenterPanel:
-        d->active_keys.center.append(key);
-        Q_EMIT activeKeysChanged(d->active_keys.center, d->overriden_keys);
-        break;
-
     case ExtendedPanel:
-        d->active_keys.extended.append(key);
-        Q_EMIT activeExtendedKeysChanged(d->active_keys.extended, d->overriden_keys);
         break;
     }
+
+    const int index(d->indexOf(d->active_panel, key));
+    ActiveKeys &active(d->active_keys[d->active_panel]);
+
+    if (index < 0 || active.contains(index)) {
+        return;
+    }
+
+    active.mask.setBit(index);
+    active.order.append(index);
+    active.keys.append(key);
+    Q_EMIT activeKeyAdded(d->active_panel, index);
 }
 
 void LayoutHelper::removeActiveKey(const Key &key)
@@ -397,49 +600,108 @@ void LayoutHelper::removeActiveKey(const Key &key)
     switch (d->active_panel) {
     case LeftPanel:
     case RightPanel:
-    case NumPanels: break;
+    case NumPanels: return;
 
     case CenterPanel:
-        if (removeKey(&d->active_keys.center, key)) {
-            Q_EMIT activeKeysChanged(d->active_keys.center, d->overriden_keys);
-        }
-        break;
-
     case ExtendedPanel:
-        if (removeKey(&d->active_keys.extended, key)) {
-            Q_EMIT activeExtendedKeysChanged(d->active_keys.extended, d->overriden_keys);
-        }
         break;
     }
+
+    const int index(d->indexOf(d->active_panel, key));
+    ActiveKeys &active(d->active_keys[d->active_panel]);
+
+    if (index < 0 || not active.contains(index)) {
+        return;
+    }
+
+    const int position(active.order.indexOf(index));
+    active.mask.clearBit(index);
+    active.order.remove(position);
+    active.keys.remove(position);
+    Q_EMIT activeKeyRemoved(d->active_panel, index);
+}
+
+//! \brief Returns the index of key in panel, or -1.
+//!
+//! Keys are identified by their origin, so key can be a modified copy of the
+//! panel's key.
+int LayoutHelper::keyIndex(Panel panel,
+                           const Key &key) const
+{
+    Q_D(const LayoutHelper);
+    return (panel != NumPanels ? d->indexOf(panel, key) : -1);
+}
+
+//! \brief Returns a key of a panel, as shown, with its override applied.
+Key LayoutHelper::panelKey(Panel panel,
+                           int index) const
+{
+    Q_D(const LayoutHelper);
+
+    if (panel == NumPanels) {
+        return Key();
+    }
+
+    const QVector<Key> &keys(d->lookup(panel).keys());
+
+    if (index < 0 or index >= keys.count()) {
+        return Key();
+    }
+
+    const Key &key(keys.at(index));
+    return overridenKey(key, d->overriden_keys, CoreUtils::idFromKey(key));
 }
 
 Key LayoutHelper::magnifierKey() const
 {
     Q_D(const LayoutHelper);
-    return d->magnifier_key;
+
+    if (not d->magnifier.hasKeys()) {
+        return Key();
+    }
+
+    Key key(d->magnifier.keys().first());
+    key.setOrigin(d->magnifier.origin());
+    key.rArea().setBackground(d->magnifier.area().background());
+
+    return key;
 }
 
 void LayoutHelper::setMagnifierKey(const Key &key)
+{
+    setMagnifier(magnifierKeyArea(key));
+}
+
+//! \brief Shows a magnifier key area, as returned by magnifierKeyArea().
+//!
+//! Comparing with the current magnifier is cheap if area is a copy of a
+//! precomputed magnifier, as both then share their content id.
+void LayoutHelper::setMagnifier(const KeyArea &area)
 {
     Q_D(LayoutHelper);
 
-    if (d->magnifier_key != key) {
-        d->magnifier_key = key;
+    if (d->magnifier != area) {
+        d->magnifier = area;
+        Q_EMIT magnifierChanged(d->magnifier);
+    }
+}
 
-        Key magnifier(d->magnifier_key);
-        magnifier.setOrigin(d->magnifier_key.origin());
+//! \brief Wraps a magnified key into the key area shown by the magnifier.
+//!
+//! The key area takes over the key's origin and background.
+KeyArea LayoutHelper::magnifierKeyArea(const Key &key)
+{
+    Key magnifier(key);
+    KeyArea area;
 
-        // FIXME: Avoid this silly conversion by changing the API (also in LayoutUpdater) to take a KeyArea instead.
-        KeyArea area;
-        area.setOrigin(magnifier.origin());
-        magnifier.setOrigin(QPoint());
+    area.setOrigin(magnifier.origin());
+    magnifier.setOrigin(QPoint());
 
-        area.setArea(magnifier.area());
-        magnifier.rArea().setBackground(QByteArray());
-        area.rKeys().append(magnifier);
+    area.setArea(magnifier.area());
+    magnifier.rArea().setBackground(QByteArray());
+    area.setKeys(QVector<Key>() << magnifier);
 
-        Q_EMIT magnifierChanged(area);
-    }
+    return area;
 }
 
 void LayoutHelper::clearMagnifierKey()
@@ -468,13 +730,30 @@ void LayoutHelper::onKeysOverriden(const KeyOverrides &overriden_keys,
         d->overriden_keys = overriden_keys;
     }
 
-    using std::tr1::placeholders::_1;
-    using std::tr1::placeholders::_2;
+    for (int panel = 0; panel < NumPanels; ++panel) {
+        // Not yet emitted, views will get the whole panel, with the new
+        // overrides applied, on commit:
+        if (d->panel_dirty[panel]) {
+            continue;
+        }
+
+        const QVector<Key> &keys(d->lookup(static_cast<Panel>(panel)).keys());
+        const QMultiHash<QString, int> &index(d->key_index[panel]);
 
-    d->overrideCheck(changed_ids, d->left, std::tr1::bind(&LayoutHelper::leftPanelChanged, this, _1, _2));
-    d->overrideCheck(changed_ids, d->right, std::tr1::bind(&LayoutHelper::rightPanelChanged, this, _1, _2));
-    d->overrideCheck(changed_ids, d->center, std::tr1::bind(&LayoutHelper::centerPanelChanged, this, _1, _2));
-    d->overrideCheck(changed_ids, d->extended, std::tr1::bind(&LayoutHelper::extendedPanelChanged, this, _1, _2));
+        Q_FOREACH (const QString &id, changed_ids) {
+            for (QMultiHash<QString, int>::const_iterator i(index.constFind(id)), e(index.constEnd());
+                 i != e && i.key() == id; ++i) {
+                const Key &key(overridenKey(keys.at(i.value()), d->overriden_keys, id));
+
+                switch (panel) {
+                case LeftPanel: Q_EMIT leftPanelKeyChanged(i.value(), key); break;
+                case RightPanel: Q_EMIT rightPanelKeyChanged(i.value(), key); break;
+                case CenterPanel: Q_EMIT centerPanelKeyChanged(i.value(), key); break;
+                case ExtendedPanel: Q_EMIT extendedPanelKeyChanged(i.value(), key); break;
+                }
+            }
+        }
+    }
 }
 
 }} // namespace Logic, MaliitKeyboard
@@ -103,48 +103,73 @@ public:
     KeyArea activeKeyArea() const;
     QRect activeKeyAreaGeometry() const;
 
+    void beginUpdate();
+    void commitUpdate();
+    bool isUpdating() const;
+
     KeyArea leftPanel() const;
     void setLeftPanel(const KeyArea &left);
     Q_SIGNAL void leftPanelChanged(const KeyArea &left,
                                    const Logic::KeyOverrides &overrides);
+    Q_SIGNAL void leftPanelKeyChanged(int index,
+                                      const Key &key);
 
     KeyArea rightPanel() const;
     void setRightPanel(const KeyArea &right);
     Q_SIGNAL void rightPanelChanged(const KeyArea &right,
                                     const Logic::KeyOverrides &overrides);
+    Q_SIGNAL void rightPanelKeyChanged(int index,
+                                       const Key &key);
 
     KeyArea centerPanel() const;
     void setCenterPanel(const KeyArea &center);
     Q_SIGNAL void centerPanelChanged(const KeyArea &center,
                                      const Logic::KeyOverrides &overrides);
+    Q_SIGNAL void centerPanelKeyChanged(int index,
+                                        const Key &key);
 
     KeyArea extendedPanel() const;
     void setExtendedPanel(const KeyArea &extended);
     Q_SIGNAL void extendedPanelChanged(const KeyArea &extended,
                                        const Logic::KeyOverrides &overrides);
+    Q_SIGNAL void extendedPanelKeyChanged(int index,
+                                          const Key &key);
     WordRibbon wordRibbon() const;
     void setWordRibbon(const WordRibbon &ribbon);
     Q_SIGNAL void wordRibbonChanged(const WordRibbon &ribbon);
 
     QVector<Key> activeKeys() const;
+    bool isActiveKey(Panel panel,
+                     int index) const;
     void clearActiveKeys();
     void appendActiveKey(const Key &key);
     void removeActiveKey(const Key &key);
-    Q_SIGNAL void activeKeysChanged(const QVector<Key> &keys,
-                                    const Logic::KeyOverrides &overrides);
-    Q_SIGNAL void activeExtendedKeysChanged(const QVector<Key> &keys,
-                                            const Logic::KeyOverrides &overrides);
+    int keyIndex(Panel panel,
+                 const Key &key) const;
+    Key panelKey(Panel panel,
+                 int index) const;
+    Q_SIGNAL void activeKeyAdded(Panel panel,
+                                 int index);
+    Q_SIGNAL void activeKeyRemoved(Panel panel,
+                                   int index);
 
     Key magnifierKey() const;
     void setMagnifierKey(const Key &key);
+    void setMagnifier(const KeyArea &area);
+    static KeyArea magnifierKeyArea(const Key &key);
     void clearMagnifierKey();
     Q_SIGNAL void magnifierChanged(const KeyArea &area);
 
 
+    //! Emits the *PanelKeyChanged signals for each panel key whose override
+    //! changed, with the override applied to the key.
     Q_SLOT void onKeysOverriden(const Logic::KeyOverrides &overriden_keys,
                                 bool update);
 
 private:
+    void updateKeyIndices(Panel panel);
+    void notifyPanelChanged(Panel panel);
+
     const QScopedPointer<LayoutHelperPrivate> d_ptr;
 };
 
@@ -34,6 +34,7 @@
 #include "style.h"
 
 #include "models/area.h"
+#include "models/keyarea.h"
 #include "models/keyboard.h"
 #include "models/keydescription.h"
 #include "models/wordribbon.h"
@@ -42,6 +43,7 @@
 #include "models/styleattributes.h"
 
 #include "logic/keyareaconverter.h"
+#include "logic/keyareastorage.h"
 #include "logic/state-machines/shiftmachine.h"
 #include "logic/state-machines/viewmachine.h"
 #include "logic/state-machines/deadkeymachine.h"
@@ -210,41 +212,210 @@ class LayoutUpdaterPrivate
 public:
     bool initialized;
     LayoutHelper *layout;
-    KeyboardLoader loader;
+    SharedKeyboardLoader loader;
     ShiftMachine shift_machine;
     ViewMachine view_machine;
     DeadkeyMachine deadkey_machine;
     SharedStyle style;
     bool word_ribbon_visible;
     LayoutHelper::Panel close_extended_on_release;
+    // Key areas of the active layout, valid for the orientation, style
+    // profile and screen size they were created with. Views other than the
+    // main and shifted one are kept by variant, like "symbols/1".
+    KeyArea main_key_area;
+    KeyArea shifted_key_area;
+    QHash<QString, KeyArea> variant_key_areas;
+    LayoutHelper::Orientation key_areas_orientation;
+    QString key_areas_profile;
+    QSize key_areas_screen_size;
+    SharedKeyAreaStorage key_area_storage;
+    // Magnifiers of the keys of the center panel, by key index. A magnifier
+    // is computed when its key is first pressed, and dropped whenever the
+    // center panel or the override of its key changes.
+    QVector<KeyArea> magnifiers;
+    int magnifiers_content_id;
 
     explicit LayoutUpdaterPrivate()
         : initialized(false)
         , layout(0)
-        , loader()
+        , loader(new KeyboardLoader)
         , shift_machine()
         , view_machine()
         , deadkey_machine()
         , style()
         , word_ribbon_visible(false)
         , close_extended_on_release(LayoutHelper::NumPanels) // NumPanels counts as invalid panel.
+        , main_key_area()
+        , shifted_key_area()
+        , variant_key_areas()
+        , key_areas_orientation(LayoutHelper::Landscape)
+        , key_areas_profile()
+        , key_areas_screen_size()
+        , key_area_storage(new KeyAreaStorage)
+        , magnifiers()
+        , magnifiers_content_id(0)
     {}
 
+    bool areKeyAreasValid() const
+    {
+        return (layout and style
+                and key_areas_orientation == layout->orientation()
+                and key_areas_profile == style->profile()
+                and key_areas_screen_size == layout->screenSize());
+    }
+
+    void validateKeyAreas()
+    {
+        if (not areKeyAreasValid()) {
+            clearKeyAreas();
+            key_areas_orientation = layout->orientation();
+            key_areas_profile = style->profile();
+            key_areas_screen_size = layout->screenSize();
+        }
+    }
+
+    void clearKeyAreas()
+    {
+        main_key_area = KeyArea();
+        shifted_key_area = KeyArea();
+        variant_key_areas.clear();
+        magnifiers.clear();
+    }
+
+    //! \brief Returns the magnifier for a key of the center panel.
+    KeyArea magnifier(const Key &key)
+    {
+        const KeyArea center(layout->centerPanel());
+        const int index(layout->keyIndex(LayoutHelper::CenterPanel, key));
+
+        if (index < 0 or index >= center.keys().count()) {
+            return LayoutHelper::magnifierKeyArea(magnifyKey(key, style->attributes(), layout->orientation(),
+                                                             center.rect()));
+        }
+
+        if (center.contentId() == 0
+            or center.contentId() != magnifiers_content_id
+            or magnifiers.count() != center.keys().count()) {
+            magnifiers.fill(KeyArea(), center.keys().count());
+            magnifiers_content_id = center.contentId();
+        }
+
+        KeyArea &magnifier(magnifiers[index]);
+
+        if (not magnifier.hasKeys()) {
+            magnifier = LayoutHelper::magnifierKeyArea(
+                magnifyKey(layout->panelKey(LayoutHelper::CenterPanel, index),
+                           style->attributes(), layout->orientation(), center.rect()));
+        }
+
+        return magnifier;
+    }
+
+    //! \brief Returns a symbols page of the active layout, converted only once.
+    KeyArea symbolsKeyArea(const KeyAreaConverter &converter,
+                           int page)
+    {
+        const QString variant(QString::fromLatin1("symbols/%1").arg(page));
+        QHash<QString, KeyArea>::const_iterator it(variant_key_areas.find(variant));
+
+        if (it == variant_key_areas.constEnd()) {
+            it = variant_key_areas.insert(variant, converter.symbolsKeyArea(page));
+        }
+
+        return *it;
+    }
+
+    //! \brief Returns the dead key view of the active layout for an accent,
+    //! converted only once.
+    KeyArea deadKeyArea(const KeyAreaConverter &converter,
+                        const Key &accent,
+                        bool shifted)
+    {
+        const QString variant(QString::fromLatin1(shifted ? "shifted-dead/%1" : "dead/%1")
+                              .arg(accent.label().text()));
+        QHash<QString, KeyArea>::const_iterator it(variant_key_areas.find(variant));
+
+        if (it == variant_key_areas.constEnd()) {
+            it = variant_key_areas.insert(variant, shifted ? converter.shiftedDeadKeyArea(accent)
+                                                           : converter.deadKeyArea(accent));
+        }
+
+        return *it;
+    }
+
+    QString keyAreasName(const QString &id) const
+    {
+        const QSize screen_size(layout->screenSize());
+
+        return QString::fromLatin1("%1/%2/%3/%4x%5")
+                .arg(id)
+                .arg(style->profile())
+                .arg(layout->orientation())
+                .arg(screen_size.width())
+                .arg(screen_size.height());
+    }
+
+    QByteArray keyAreasStamp(const QString &id) const
+    {
+        return (loader->sourceHash(id) + style->sourceHash());
+    }
+
+    //! \brief Makes sure that main and shifted key area of the active layout exist.
+    //!
+    //! Both are restored from the key area storage if possible. An entry may
+    //! hold the main key area only, when it was stored for a prefetched
+    //! layout. Missing key areas are converted, and the storage entry is
+    //! rebuilt in the background.
+    void updateKeyAreas(const KeyAreaConverter &converter)
+    {
+        if (main_key_area.hasKeys() and shifted_key_area.hasKeys()) {
+            return;
+        }
+
+        const QString id(loader->activeId());
+        const QString name(keyAreasName(id));
+        const QByteArray stamp(keyAreasStamp(id));
+        QVector<KeyArea> stored;
+
+        if (key_area_storage->load(name, stamp, &stored)) {
+            if (not main_key_area.hasKeys() and stored.size() >= 1) {
+                main_key_area = stored.at(0);
+            }
+
+            if (not shifted_key_area.hasKeys() and stored.size() >= 2) {
+                shifted_key_area = stored.at(1);
+            }
+
+            if (main_key_area.hasKeys() and shifted_key_area.hasKeys()) {
+                return;
+            }
+        }
+
+        if (not main_key_area.hasKeys()) {
+            main_key_area = converter.keyArea();
+        }
+
+        if (not shifted_key_area.hasKeys()) {
+            shifted_key_area = converter.shiftedKeyArea();
+        }
+
+        key_area_storage->store(name, stamp, QVector<KeyArea>() << main_key_area << shifted_key_area);
+    }
+
     bool inShiftedState() const
     {
-        return (shift_machine.inState(ShiftMachine::shift_state) or
-                shift_machine.inState(ShiftMachine::caps_lock_state) or
-                shift_machine.inState(ShiftMachine::latched_shift_state));
+        return (shift_machine.state() == ShiftMachine::LatchedShiftState or
+                shift_machine.state() == ShiftMachine::CapsLockState);
     }
 
     bool arePrimarySymbolsShown() const
     {
-        return view_machine.inState(ViewMachine::symbols0_state);
+        return (view_machine.state() == ViewMachine::Symbols0State);
     }
 
     bool areSecondarySymbolsShown() const
     {
-        return view_machine.inState(ViewMachine::symbols1_state);
+        return (view_machine.state() == ViewMachine::Symbols1State);
     }
 
     bool areSymbolsShown() const
@@ -254,8 +425,8 @@ public:
 
     bool inDeadkeyState() const
     {
-        return (deadkey_machine.inState(DeadkeyMachine::deadkey_state) or
-                deadkey_machine.inState(DeadkeyMachine::latched_deadkey_state));
+        return (deadkey_machine.state() == DeadkeyMachine::DeadkeyState or
+                deadkey_machine.state() == DeadkeyMachine::LatchedDeadkeyState);
     }
 
     const StyleAttributes * activeStyleAttributes() const
@@ -269,8 +440,11 @@ LayoutUpdater::LayoutUpdater(QObject *parent)
     : QObject(parent)
     , d_ptr(new LayoutUpdaterPrivate)
 {
-    connect(&d_ptr->loader, SIGNAL(keyboardsChanged()),
-            this,           SLOT(onKeyboardsChanged()),
+    connect(d_ptr->loader.data(), SIGNAL(keyboardsChanged()),
+            this,                 SLOT(onKeyboardsChanged()),
+            Qt::UniqueConnection);
+    connect(d_ptr->loader.data(), SIGNAL(neighboursPrefetched()),
+            this,                 SLOT(onNeighboursPrefetched()),
             Qt::UniqueConnection);
 }
 
@@ -289,31 +463,44 @@ void LayoutUpdater::init()
 QStringList LayoutUpdater::keyboardIds() const
 {
     Q_D(const LayoutUpdater);
-    return d->loader.ids();
+    return d->loader->ids();
 }
 
 QString LayoutUpdater::activeKeyboardId() const
 {
     Q_D(const LayoutUpdater);
-    return d->loader.activeId();
+    return d->loader->activeId();
 }
 
 void LayoutUpdater::setActiveKeyboardId(const QString &id)
 {
     Q_D(LayoutUpdater);
-    d->loader.setActiveId(id);
+    d->loader->setActiveId(id);
 }
 
 QString LayoutUpdater::keyboardTitle(const QString &id) const
 {
     Q_D(const LayoutUpdater);
-    return d->loader.title(id);
+    return d->loader->title(id);
 }
 
 void LayoutUpdater::setLayout(LayoutHelper *layout)
 {
     Q_D(LayoutUpdater);
+
+    if (d->layout) {
+        disconnect(d->layout, 0, this, 0);
+    }
+
     d->layout = layout;
+    d->magnifiers.clear();
+
+    if (d->layout) {
+        connect(d->layout, SIGNAL(centerPanelChanged(KeyArea,Logic::KeyOverrides)),
+                this,      SLOT(onCenterPanelChanged()));
+        connect(d->layout, SIGNAL(centerPanelKeyChanged(int,Key)),
+                this,      SLOT(onCenterPanelKeyChanged(int)));
+    }
 
     if (not d->initialized) {
         init();
@@ -326,12 +513,16 @@ void LayoutUpdater::setOrientation(LayoutHelper::Orientation orientation)
     Q_D(LayoutUpdater);
 
     if (d->layout && d->style && d->layout->orientation() != orientation) {
+        d->layout->beginUpdate();
         d->layout->setOrientation(orientation);
 
-        KeyAreaConverter converter(d->style->attributes(), &d->loader);
+        KeyAreaConverter converter(d->style->attributes(), d->loader.data());
         converter.setLayoutOrientation(orientation);
-        d->layout->setCenterPanel(d->inShiftedState() ? converter.shiftedKeyArea()
-                                                      : converter.keyArea());
+
+        d->validateKeyAreas();
+        d->updateKeyAreas(converter);
+        d->layout->setCenterPanel(d->inShiftedState() ? d->shifted_key_area
+                                                      : d->main_key_area);
 
         if (isWordRibbonVisible()) {
             WordRibbon ribbon(d->layout->wordRibbon());
@@ -340,6 +531,7 @@ void LayoutUpdater::setOrientation(LayoutHelper::Orientation orientation)
         }
 
         clearActiveKeysAndMagnifier();
+        d->layout->commitUpdate();
     }
 }
 
@@ -349,6 +541,41 @@ void LayoutUpdater::setStyle(const SharedStyle &style)
     d->style = style;
 }
 
+//! \brief Makes the updater use another keyboard loader.
+//!
+//! Updaters sharing a loader show the same layout, and load it only once.
+//! \param loader The loader to use. Must not be null.
+void LayoutUpdater::setKeyboardLoader(const SharedKeyboardLoader &loader)
+{
+    Q_D(LayoutUpdater);
+
+    if (loader.isNull() || loader == d->loader) {
+        return;
+    }
+
+    disconnect(d->loader.data(), 0, this, 0);
+    d->loader = loader;
+    d->clearKeyAreas();
+
+    connect(d->loader.data(), SIGNAL(keyboardsChanged()),
+            this,             SLOT(onKeyboardsChanged()),
+            Qt::UniqueConnection);
+    connect(d->loader.data(), SIGNAL(neighboursPrefetched()),
+            this,             SLOT(onNeighboursPrefetched()),
+            Qt::UniqueConnection);
+}
+
+//! \brief Makes the updater use another key area storage.
+//! \param storage The storage to use. Must not be null.
+void LayoutUpdater::setKeyAreaStorage(const SharedKeyAreaStorage &storage)
+{
+    Q_D(LayoutUpdater);
+
+    if (not storage.isNull()) {
+        d->key_area_storage = storage;
+    }
+}
+
 bool LayoutUpdater::isWordRibbonVisible() const
 {
     Q_D(const LayoutUpdater);
@@ -401,8 +628,7 @@ void LayoutUpdater::onKeyPressed(const Key &key)
                                                                 d->activeStyleAttributes()));
 
     if (d->layout->activePanel() == LayoutHelper::CenterPanel) {
-        d->layout->setMagnifierKey(magnifyKey(key, d->activeStyleAttributes(), d->layout->orientation(),
-                                              d->layout->centerPanel().rect()));
+        d->layout->setMagnifier(d->magnifier(key));
     }
 
     switch (key.action()) {
@@ -434,7 +660,7 @@ void LayoutUpdater::onKeyLongPressed(const Key &key)
     const LayoutHelper::Orientation orientation(d->layout->orientation());
     StyleAttributes * const extended_attributes(d->style->extendedKeysAttributes());
     const qreal vertical_offset(d->style->attributes()->verticalOffset(orientation));
-    KeyAreaConverter converter(extended_attributes, &d->loader);
+    KeyAreaConverter converter(extended_attributes, d->loader.data());
     converter.setLayoutOrientation(orientation);
     KeyArea ext_ka(converter.extendedKeyArea(key));
 
@@ -486,11 +712,11 @@ void LayoutUpdater::onKeyReleased(const Key &key)
         break;
 
     case Key::ActionInsert:
-        if (d->shift_machine.inState(ShiftMachine::latched_shift_state)) {
+        if (d->shift_machine.state() == ShiftMachine::LatchedShiftState) {
             Q_EMIT shiftCancelled();
         }
 
-        if (d->deadkey_machine.inState(DeadkeyMachine::latched_deadkey_state)) {
+        if (d->deadkey_machine.state() == DeadkeyMachine::LatchedDeadkeyState) {
             Q_EMIT deadkeyCancelled();
         }
 
@@ -544,7 +770,7 @@ void LayoutUpdater::onKeyAreaReleased(LayoutHelper::Panel panel)
 
 void LayoutUpdater::onKeyEntered(const Key &key)
 {
-    Q_D(const LayoutUpdater);
+    Q_D(LayoutUpdater);
 
     if (not d->layout) {
         return;
@@ -554,8 +780,7 @@ void LayoutUpdater::onKeyEntered(const Key &key)
                                                                 d->activeStyleAttributes()));
 
     if (d->layout->activePanel() == LayoutHelper::CenterPanel) {
-        d->layout->setMagnifierKey(magnifyKey(key, d->activeStyleAttributes(), d->layout->orientation(),
-                                              d->layout->centerPanel().rect()));
+        d->layout->setMagnifier(d->magnifier(key));
     }
 }
 
@@ -638,7 +863,7 @@ void LayoutUpdater::onExtendedKeysShown(const Key &main_key)
     const LayoutHelper::Orientation orientation(d->layout->orientation());
     StyleAttributes * const extended_attributes(d->style->extendedKeysAttributes());
     const qreal vertical_offset(d->style->attributes()->verticalOffset(orientation));
-    KeyAreaConverter converter(extended_attributes, &d->loader);
+    KeyAreaConverter converter(extended_attributes, d->loader.data());
     converter.setLayoutOrientation(orientation);
     KeyArea ext_ka(converter.extendedKeyArea(main_key));
 
@@ -692,9 +917,13 @@ void LayoutUpdater::onWordCandidateReleased(const WordCandidate &candidate)
     }
 }
 
+//! \brief Shows the view matching the state machines.
+//!
+//! The state machines call this synchronously on entering a state, so the
+//! layout is rebuilt before the key event that changed the state returns.
 void LayoutUpdater::syncLayoutToView()
 {
-    Q_D(const LayoutUpdater);
+    Q_D(LayoutUpdater);
 
     if (not d->layout) {
         return;
@@ -705,25 +934,91 @@ void LayoutUpdater::syncLayoutToView()
         return;
     }
 
+    d->layout->beginUpdate();
+
     if (d->inDeadkeyState()) {
         switchToAccentedView();
     } else {
         switchToMainView();
     }
+
+    d->layout->commitUpdate();
 }
 
 void LayoutUpdater::onKeyboardsChanged()
 {
     Q_D(LayoutUpdater);
 
-    // Resetting state machines should reset layout also.
-    // FIXME: Most probably reloading will happen three
-    // times, which is not what we want.
+    // Key areas of the new layout are restored from the key area storage,
+    // where a prefetched layout already has its main key area.
+    d->clearKeyAreas();
+
+    // Resetting state machines resets the layout also. Each machine syncs the
+    // layout when entering its initial state. Only the first sync converts
+    // the key areas, the others find them cached, and batching the updates
+    // makes the layout emit the result once.
+    if (d->layout) {
+        d->layout->beginUpdate();
+    }
+
     d->shift_machine.restart();
     d->deadkey_machine.restart();
     d->view_machine.restart();
 
-    Q_EMIT keyboardTitleChanged(d->loader.title(d->loader.activeId()));
+    if (d->layout) {
+        d->layout->commitUpdate();
+    }
+
+    Q_EMIT keyboardTitleChanged(d->loader->title(d->loader->activeId()));
+}
+
+//! \brief Converts the prefetched layouts into key areas.
+//!
+//! Runs while the keyboard is idle, after the loader built the views of the
+//! layouts next to the active one.
+void LayoutUpdater::onNeighboursPrefetched()
+{
+    Q_D(LayoutUpdater);
+
+    if (not d->layout || d->style.isNull()) {
+        return;
+    }
+
+    d->validateKeyAreas();
+
+    KeyAreaConverter converter(d->style->attributes(), d->loader.data());
+    converter.setLayoutOrientation(d->layout->orientation());
+
+    // The storage may be shared with other updaters, which then find the
+    // key areas converted here.
+    Q_FOREACH (const QString &id, d->loader->prefetchedIds()) {
+        const QString name(d->keyAreasName(id));
+        const QByteArray stamp(d->keyAreasStamp(id));
+        QVector<KeyArea> stored;
+
+        if (not d->key_area_storage->load(name, stamp, &stored)) {
+            d->key_area_storage->store(name, stamp,
+                                       QVector<KeyArea>() << converter.prefetchedKeyArea(id));
+        }
+    }
+}
+
+//! \brief Drops the magnifiers, the overrides of the keys may have changed
+//! together with the center panel.
+void LayoutUpdater::onCenterPanelChanged()
+{
+    Q_D(LayoutUpdater);
+    d->magnifiers.clear();
+}
+
+//! \brief Drops the magnifier of a key whose override changed.
+void LayoutUpdater::onCenterPanelKeyChanged(int index)
+{
+    Q_D(LayoutUpdater);
+
+    if (index >= 0 and index < d->magnifiers.count()) {
+        d->magnifiers[index] = KeyArea();
+    }
 }
 
 void LayoutUpdater::switchToMainView()
@@ -745,10 +1040,13 @@ void LayoutUpdater::switchToMainView()
         d->layout->setWordRibbon(ribbon);
     }
 
-    KeyAreaConverter converter(d->style->attributes(), &d->loader);
+    KeyAreaConverter converter(d->style->attributes(), d->loader.data());
     converter.setLayoutOrientation(orientation);
-    d->layout->setCenterPanel(d->inShiftedState() ? converter.shiftedKeyArea()
-                                                  : converter.keyArea());
+
+    d->validateKeyAreas();
+    d->updateKeyAreas(converter);
+    d->layout->setCenterPanel(d->inShiftedState() ? d->shifted_key_area
+                                                  : d->main_key_area);
 }
 
 void LayoutUpdater::switchToPrimarySymView()
@@ -760,9 +1058,11 @@ void LayoutUpdater::switchToPrimarySymView()
     }
 
     const LayoutHelper::Orientation orientation(d->layout->orientation());
-    KeyAreaConverter converter(d->style->attributes(), &d->loader);
+    KeyAreaConverter converter(d->style->attributes(), d->loader.data());
     converter.setLayoutOrientation(orientation);
-    d->layout->setCenterPanel(converter.symbolsKeyArea(0));
+
+    d->validateKeyAreas();
+    d->layout->setCenterPanel(d->symbolsKeyArea(converter, 0));
 
     // Reset shift state machine, also see switchToMainView.
     d->shift_machine.restart();
@@ -777,9 +1077,11 @@ void LayoutUpdater::switchToSecondarySymView()
     }
 
     const LayoutHelper::Orientation orientation(d->layout->orientation());
-    KeyAreaConverter converter(d->style->attributes(), &d->loader);
+    KeyAreaConverter converter(d->style->attributes(), d->loader.data());
     converter.setLayoutOrientation(orientation);
-    d->layout->setCenterPanel(converter.symbolsKeyArea(1));
+
+    d->validateKeyAreas();
+    d->layout->setCenterPanel(d->symbolsKeyArea(converter, 1));
 }
 
 void LayoutUpdater::switchToAccentedView()
@@ -792,11 +1094,12 @@ void LayoutUpdater::switchToAccentedView()
 
 
     const LayoutHelper::Orientation orientation(d->layout->orientation());
-    KeyAreaConverter converter(d->style->attributes(), &d->loader);
+    KeyAreaConverter converter(d->style->attributes(), d->loader.data());
     converter.setLayoutOrientation(orientation);
     const Key accent(d->deadkey_machine.accentKey());
-    d->layout->setCenterPanel(d->inShiftedState() ? converter.shiftedDeadKeyArea(accent)
-                                                  : converter.deadKeyArea(accent));
+
+    d->validateKeyAreas();
+    d->layout->setCenterPanel(d->deadKeyArea(converter, accent, d->inShiftedState()));
 }
 
 }} // namespace Logic, MaliitKeyboard
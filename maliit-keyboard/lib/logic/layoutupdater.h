@@ -34,6 +34,7 @@
 #define MALIIT_KEYBOARD_LAYOUTUPDATER_H
 
 #include "keyboardloader.h"
+#include "keyareastorage.h"
 
 #include "models/key.h"
 #include "models/wordcandidate.h"
@@ -72,6 +73,8 @@ public:
     Q_SLOT void setOrientation(LayoutHelper::Orientation orientation);
 
     void setStyle(const SharedStyle &style);
+    void setKeyboardLoader(const SharedKeyboardLoader &loader);
+    void setKeyAreaStorage(const SharedKeyAreaStorage &storage);
 
     bool isWordRibbonVisible() const;
     Q_SLOT void setWordRibbonVisible(bool visible);
@@ -114,6 +117,9 @@ private:
 
     Q_SLOT void syncLayoutToView();
     Q_SLOT void onKeyboardsChanged();
+    Q_SLOT void onNeighboursPrefetched();
+    Q_SLOT void onCenterPanelChanged();
+    Q_SLOT void onCenterPanelKeyChanged(int index);
 
     Q_SIGNAL void symKeyReleased();
     Q_SIGNAL void symSwitcherReleased();
@@ -6,6 +6,7 @@ HEADERS += \
     logic/layoutupdater.h \
     logic/keyboardloader.h \
     logic/keyareaconverter.h \
+    logic/keyareastorage.h \
     logic/style.h \
     logic/spellchecker.h \
     logic/abstracttexteditor.h \
@@ -21,6 +22,7 @@ SOURCES += \
     logic/layoutupdater.cpp \
     logic/keyboardloader.cpp \
     logic/keyareaconverter.cpp \
+    logic/keyareastorage.cpp \
     logic/style.cpp \
     logic/spellchecker.cpp \
     logic/abstracttexteditor.cpp \
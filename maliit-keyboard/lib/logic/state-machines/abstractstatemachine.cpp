@@ -42,25 +42,4 @@ AbstractStateMachine::AbstractStateMachine()
 AbstractStateMachine::~AbstractStateMachine()
 {}
 
-bool AbstractStateMachine::inState(const QString &name) const
-{
-    if (const QStateMachine *sm = dynamic_cast<const QStateMachine *>(this)) {
-        Q_FOREACH (QAbstractState *state, sm->configuration()) {
-            if (state->objectName() == name) {
-                return true;
-            }
-        }
-    }
-
-    return false;
-}
-
-void AbstractStateMachine::restart()
-{
-    if (QStateMachine *sm = dynamic_cast<QStateMachine *>(this)) {
-        sm->stop();
-        QTimer::singleShot(0, sm, SLOT(start()));
-    }
-}
-
 }} // namespace Logic, MaliitKeyboard
@@ -47,8 +47,8 @@ public:
     virtual ~AbstractStateMachine() = 0;
 
     virtual void setup(LayoutUpdater *updater) = 0;
-    virtual bool inState(const QString &name) const;
-    virtual void restart();
+    virtual bool inState(const QString &name) const = 0;
+    virtual void restart() = 0;
 };
 
 }} // namespace Logic, MaliitKeyboard
@@ -51,8 +51,26 @@ public:
     {}
 };
 
+namespace {
+
+const TableStateMachine::StateDescription g_states[DeadkeyMachine::StateCount] = {
+    { DeadkeyMachine::no_deadkey_state, "switchToMainView()" },
+    { DeadkeyMachine::deadkey_state, "switchToAccentedView()" },
+    { DeadkeyMachine::latched_deadkey_state, 0 }
+};
+
+const TableStateMachine::Transition g_transitions[] = {
+    { DeadkeyMachine::NoDeadkeyState, DeadkeyMachine::DeadkeyPressedEvent, DeadkeyMachine::DeadkeyState },
+    { DeadkeyMachine::DeadkeyState, DeadkeyMachine::DeadkeyCancelledEvent, DeadkeyMachine::NoDeadkeyState },
+    { DeadkeyMachine::DeadkeyState, DeadkeyMachine::DeadkeyReleasedEvent, DeadkeyMachine::LatchedDeadkeyState },
+    { DeadkeyMachine::LatchedDeadkeyState, DeadkeyMachine::DeadkeyCancelledEvent, DeadkeyMachine::NoDeadkeyState },
+    { DeadkeyMachine::LatchedDeadkeyState, DeadkeyMachine::DeadkeyPressedEvent, DeadkeyMachine::NoDeadkeyState }
+};
+
+} // unnamed namespace
+
 DeadkeyMachine::DeadkeyMachine(QObject *parent)
-    : QStateMachine(parent)
+    : TableStateMachine(parent)
     , d_ptr(new DeadkeyMachinePrivate)
 {}
 
@@ -67,38 +85,16 @@ void DeadkeyMachine::setup(LayoutUpdater *updater)
         return;
     }
 
-    setChildMode(QState::ExclusiveStates);
-
-    QState *no_deadkey = 0;
-    QState *deadkey = 0;
-    QState *latched_deadkey = 0;
-
-    // addState makes state machine to be a parent of passed state,
-    // so we don't have to care about deleting states explicitly.
-    addState(no_deadkey = new QState);
-    addState(deadkey = new QState);
-    addState(latched_deadkey = new QState);
-    setInitialState(no_deadkey);
-
-    no_deadkey->setObjectName(no_deadkey_state);
-    deadkey->setObjectName(deadkey_state);
-    latched_deadkey->setObjectName(latched_deadkey_state);
-
-    no_deadkey->addTransition(updater, SIGNAL(deadkeyPressed()), deadkey);
-    connect(no_deadkey, SIGNAL(entered()),
-            updater,    SLOT(switchToMainView()));
-
-
-    deadkey->addTransition(updater, SIGNAL(deadkeyCancelled()), no_deadkey);
-    deadkey->addTransition(updater, SIGNAL(deadkeyReleased()), latched_deadkey);
-    connect(deadkey, SIGNAL(entered()),
-            updater, SLOT(switchToAccentedView()));
+    setTables(updater,
+              g_states, StateCount,
+              g_transitions, sizeof(g_transitions) / sizeof(g_transitions[0]),
+              NoDeadkeyState);
 
-    latched_deadkey->addTransition(updater, SIGNAL(deadkeyCancelled()), no_deadkey);
-    latched_deadkey->addTransition(updater, SIGNAL(deadkeyPressed()), no_deadkey);
+    connectEvent(updater, SIGNAL(deadkeyPressed()), DeadkeyPressedEvent);
+    connectEvent(updater, SIGNAL(deadkeyReleased()), DeadkeyReleasedEvent);
+    connectEvent(updater, SIGNAL(deadkeyCancelled()), DeadkeyCancelledEvent);
 
-    // Defer to first main loop iteration:
-    QTimer::singleShot(0, this, SLOT(start()));
+    start();
 }
 
 void DeadkeyMachine::setAccentKey(const Key &accent_key)
@@ -34,7 +34,7 @@
 #ifndef MALIIT_KEYBOARD_DEADKEYMACHINE_H
 #define MALIIT_KEYBOARD_DEADKEYMACHINE_H
 
-#include "abstractstatemachine.h"
+#include "tablestatemachine.h"
 #include "models/key.h"
 
 #include <QtCore>
@@ -45,14 +45,26 @@ namespace Logic {
 class DeadkeyMachinePrivate;
 
 class DeadkeyMachine
-    : public QStateMachine
-    , public AbstractStateMachine
+    : public TableStateMachine
 {
     Q_OBJECT
     Q_DISABLE_COPY(DeadkeyMachine)
     Q_DECLARE_PRIVATE(DeadkeyMachine)
 
 public:
+    enum State {
+        NoDeadkeyState,
+        DeadkeyState,
+        LatchedDeadkeyState,
+        StateCount
+    };
+
+    enum Event {
+        DeadkeyPressedEvent,
+        DeadkeyReleasedEvent,
+        DeadkeyCancelledEvent
+    };
+
     explicit DeadkeyMachine(QObject *parent = 0);
     virtual ~DeadkeyMachine();
 
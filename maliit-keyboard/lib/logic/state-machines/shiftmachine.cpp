@@ -42,8 +42,26 @@ const char *const ShiftMachine::shift_state = "shift";
 const char *const ShiftMachine::latched_shift_state = "latched-shift";
 const char *const ShiftMachine::caps_lock_state = "caps-lock";
 
+namespace {
+
+const TableStateMachine::StateDescription g_states[ShiftMachine::StateCount] = {
+    { ShiftMachine::no_shift_state, "syncLayoutToView()" },
+    { ShiftMachine::latched_shift_state, "syncLayoutToView()" },
+    { ShiftMachine::caps_lock_state, "syncLayoutToView()" }
+};
+
+const TableStateMachine::Transition g_transitions[] = {
+    { ShiftMachine::NoShiftState, ShiftMachine::ShiftPressedEvent, ShiftMachine::LatchedShiftState },
+    { ShiftMachine::NoShiftState, ShiftMachine::AutoCapsActivatedEvent, ShiftMachine::LatchedShiftState },
+    { ShiftMachine::LatchedShiftState, ShiftMachine::ShiftCancelledEvent, ShiftMachine::NoShiftState },
+    { ShiftMachine::LatchedShiftState, ShiftMachine::ShiftReleasedEvent, ShiftMachine::CapsLockState },
+    { ShiftMachine::CapsLockState, ShiftMachine::ShiftReleasedEvent, ShiftMachine::NoShiftState }
+};
+
+} // unnamed namespace
+
 ShiftMachine::ShiftMachine(QObject *parent)
-    : QStateMachine(parent)
+    : TableStateMachine(parent)
 {}
 
 ShiftMachine::~ShiftMachine()
@@ -57,38 +75,17 @@ void ShiftMachine::setup(LayoutUpdater *updater)
         return;
     }
 
-    setChildMode(QState::ExclusiveStates);
-
-    QState *no_shift = 0;
-    QState *latched_shift = 0;
-    QState *caps_lock = 0;
-
-    // addState makes state machine to be a parent of passed state,
-    // so we don't have to care about deleting states explicitly.
-    addState(no_shift = new QState);
-    addState(latched_shift = new QState);
-    addState(caps_lock = new QState);
-    setInitialState(no_shift);
-
-    no_shift->setObjectName(no_shift_state);
-    latched_shift->setObjectName(latched_shift_state);
-    caps_lock->setObjectName(caps_lock_state);
-
-    connect(no_shift, SIGNAL(entered()),
-            updater,  SLOT(syncLayoutToView()));
-    connect(latched_shift, SIGNAL(entered()),
-            updater,       SLOT(syncLayoutToView()));
-    connect(caps_lock, SIGNAL(entered()),
-            updater,   SLOT(syncLayoutToView()));
+    setTables(updater,
+              g_states, StateCount,
+              g_transitions, sizeof(g_transitions) / sizeof(g_transitions[0]),
+              NoShiftState);
 
-    no_shift->addTransition(updater, SIGNAL(shiftPressed()), latched_shift);
-    no_shift->addTransition(updater, SIGNAL(autoCapsActivated()), latched_shift);
-    latched_shift->addTransition(updater, SIGNAL(shiftCancelled()), no_shift);
-    latched_shift->addTransition(updater, SIGNAL(shiftReleased()), caps_lock);
-    caps_lock->addTransition(updater, SIGNAL(shiftReleased()), no_shift);
+    connectEvent(updater, SIGNAL(shiftPressed()), ShiftPressedEvent);
+    connectEvent(updater, SIGNAL(autoCapsActivated()), AutoCapsActivatedEvent);
+    connectEvent(updater, SIGNAL(shiftCancelled()), ShiftCancelledEvent);
+    connectEvent(updater, SIGNAL(shiftReleased()), ShiftReleasedEvent);
 
-    // Defer to first main loop iteration:
-    QTimer::singleShot(0, this, SLOT(start()));
+    start();
 }
 
 }} // namespace Logic, MaliitKeyboard
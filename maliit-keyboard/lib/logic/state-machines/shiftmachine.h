@@ -34,7 +34,7 @@
 #ifndef MALIIT_KEYBOARD_SHIFTMACHINE_H
 #define MALIIT_KEYBOARD_SHIFTMACHINE_H
 
-#include "abstractstatemachine.h"
+#include "tablestatemachine.h"
 #include <QtCore>
 
 namespace MaliitKeyboard {
@@ -43,13 +43,26 @@ namespace Logic {
 class LayoutUpdater;
 
 class ShiftMachine
-    : public QStateMachine
-    , public AbstractStateMachine
+    : public TableStateMachine
 {
     Q_OBJECT
     Q_DISABLE_COPY(ShiftMachine)
 
 public:
+    enum State {
+        NoShiftState,
+        LatchedShiftState,
+        CapsLockState,
+        StateCount
+    };
+
+    enum Event {
+        ShiftPressedEvent,
+        AutoCapsActivatedEvent,
+        ShiftCancelledEvent,
+        ShiftReleasedEvent
+    };
+
     explicit ShiftMachine(QObject *parent = 0);
     virtual ~ShiftMachine();
 
@@ -0,0 +1,236 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "tablestatemachine.h"
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+//! \brief A signal connected through TableStateMachine::connectEvent().
+struct EventSignal
+{
+    const QObject *sender;
+    int signal_index;
+    int event;
+};
+
+class TableStateMachinePrivate
+{
+public:
+    const TableStateMachine::StateDescription *states;
+    int state_count;
+    const TableStateMachine::Transition *transitions;
+    int transition_count;
+    int initial_state;
+    int current_state;
+    QPointer<QObject> receiver;
+    QVector<QMetaMethod> entered_slots;
+    QVector<EventSignal> event_signals;
+
+    explicit TableStateMachinePrivate()
+        : states(0)
+        , state_count(0)
+        , transitions(0)
+        , transition_count(0)
+        , initial_state(-1)
+        , current_state(-1)
+        , receiver()
+        , entered_slots()
+        , event_signals()
+    {}
+};
+
+TableStateMachine::TableStateMachine(QObject *parent)
+    : QObject(parent)
+    , AbstractStateMachine()
+    , d_ptr(new TableStateMachinePrivate)
+{}
+
+TableStateMachine::~TableStateMachine()
+{}
+
+//! \brief Sets up states and transitions.
+//!
+//! Both tables must outlive the machine. Entered slots are resolved on
+//! receiver once, here.
+void TableStateMachine::setTables(QObject *receiver,
+                                  const StateDescription *states,
+                                  int state_count,
+                                  const Transition *transitions,
+                                  int transition_count,
+                                  int initial_state)
+{
+    Q_D(TableStateMachine);
+
+    d->states = states;
+    d->state_count = state_count;
+    d->transitions = transitions;
+    d->transition_count = transition_count;
+    d->initial_state = initial_state;
+    d->current_state = -1;
+    d->receiver = receiver;
+    d->entered_slots.fill(QMetaMethod(), state_count);
+
+    if (not receiver) {
+        return;
+    }
+
+    const QMetaObject *meta_object(receiver->metaObject());
+
+    for (int state = 0; state < state_count; ++state) {
+        const char *const slot(states[state].entered_slot);
+
+        if (not slot) {
+            continue;
+        }
+
+        const int index(meta_object->indexOfMethod(slot));
+
+        if (index < 0) {
+            qWarning() << __PRETTY_FUNCTION__
+                       << "No such slot:" << slot;
+            continue;
+        }
+
+        d->entered_slots[state] = meta_object->method(index);
+    }
+}
+
+//! \brief Makes signal of sender trigger event.
+//!
+//! All signals go to one slot, which looks the event up by sender and
+//! signal index.
+void TableStateMachine::connectEvent(QObject *sender,
+                                     const char *signal,
+                                     int event)
+{
+    Q_D(TableStateMachine);
+
+    // Skip the code SIGNAL() puts in front of the signature:
+    const QByteArray signature(QMetaObject::normalizedSignature(signal + 1));
+    const EventSignal event_signal = { sender, sender->metaObject()->indexOfSignal(signature), event };
+
+    if (event_signal.signal_index < 0) {
+        qWarning() << __PRETTY_FUNCTION__
+                   << "No such signal:" << signature;
+        return;
+    }
+
+    d->event_signals.append(event_signal);
+    connect(sender, signal,
+            this,   SLOT(onEventSignal()));
+}
+
+void TableStateMachine::onEventSignal()
+{
+    Q_D(TableStateMachine);
+
+    const QObject *const signal_sender(sender());
+    const int signal_index(senderSignalIndex());
+
+    Q_FOREACH (const EventSignal &event_signal, d->event_signals) {
+        if (event_signal.sender == signal_sender
+            and event_signal.signal_index == signal_index) {
+            processEvent(event_signal.event);
+            return;
+        }
+    }
+}
+
+bool TableStateMachine::inState(const QString &name) const
+{
+    Q_D(const TableStateMachine);
+
+    return (d->current_state >= 0
+            && name == QLatin1String(d->states[d->current_state].name));
+}
+
+//! \brief Enters the initial state again, right away.
+void TableStateMachine::restart()
+{
+    Q_D(TableStateMachine);
+    enterState(d->initial_state);
+}
+
+int TableStateMachine::state() const
+{
+    Q_D(const TableStateMachine);
+    return d->current_state;
+}
+
+//! \brief Enters the initial state, unless the machine is running already.
+void TableStateMachine::start()
+{
+    Q_D(TableStateMachine);
+
+    if (d->current_state < 0) {
+        enterState(d->initial_state);
+    }
+}
+
+void TableStateMachine::processEvent(int event)
+{
+    Q_D(TableStateMachine);
+
+    if (d->current_state < 0) {
+        return;
+    }
+
+    for (int index = 0; index < d->transition_count; ++index) {
+        const Transition &transition(d->transitions[index]);
+
+        if (transition.from == d->current_state && transition.event == event) {
+            enterState(transition.to);
+            return;
+        }
+    }
+}
+
+void TableStateMachine::enterState(int state)
+{
+    Q_D(TableStateMachine);
+
+    if (state < 0 || state >= d->state_count) {
+        return;
+    }
+
+    d->current_state = state;
+
+    const QMetaMethod &slot(d->entered_slots.at(state));
+
+    if (slot.isValid() && d->receiver) {
+        slot.invoke(d->receiver.data(), Qt::DirectConnection);
+    }
+}
+
+}} // namespace Logic, MaliitKeyboard
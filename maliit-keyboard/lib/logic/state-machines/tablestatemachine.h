@@ -0,0 +1,104 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef MALIIT_KEYBOARD_TABLESTATEMACHINE_H
+#define MALIIT_KEYBOARD_TABLESTATEMACHINE_H
+
+#include "abstractstatemachine.h"
+#include <QtCore>
+
+namespace MaliitKeyboard {
+namespace Logic {
+
+class TableStateMachinePrivate;
+
+//! \brief A small, synchronous state machine driven by static tables.
+//!
+//! Subclasses describe their states and transitions in static arrays and
+//! pass them to setTables(). Events are processed right away, without
+//! going through the event loop, and a transition only does a table scan
+//! plus the call of the entered slot of the target state.
+class TableStateMachine
+    : public QObject
+    , public AbstractStateMachine
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(TableStateMachine)
+    Q_DECLARE_PRIVATE(TableStateMachine)
+
+public:
+    struct StateDescription {
+        const char *name; //!< Name, as used by inState().
+        const char *entered_slot; //!< Normalized signature of the receiver
+                                  //!< slot to call on entering, or 0.
+    };
+
+    struct Transition {
+        int from; //!< State in which the transition applies.
+        int event; //!< Event that triggers the transition.
+        int to; //!< State to enter.
+    };
+
+    explicit TableStateMachine(QObject *parent = 0);
+    virtual ~TableStateMachine();
+
+    virtual bool inState(const QString &name) const;
+    virtual void restart();
+
+    //! Returns the current state, or -1 if the machine was not started.
+    int state() const;
+
+    Q_SLOT void start();
+    Q_SLOT void processEvent(int event);
+
+protected:
+    void setTables(QObject *receiver,
+                   const StateDescription *states,
+                   int state_count,
+                   const Transition *transitions,
+                   int transition_count,
+                   int initial_state);
+    void connectEvent(QObject *sender,
+                      const char *signal,
+                      int event);
+
+private:
+    void enterState(int state);
+    Q_SLOT void onEventSignal();
+
+    const QScopedPointer<TableStateMachinePrivate> d_ptr;
+};
+
+}} // namespace Logic, MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_TABLESTATEMACHINE_H
@@ -41,8 +41,26 @@ const char *const ViewMachine::main_state = "main";
 const char *const ViewMachine::symbols0_state = "symbols0";
 const char *const ViewMachine::symbols1_state = "symbols1";
 
+namespace {
+
+const TableStateMachine::StateDescription g_states[ViewMachine::StateCount] = {
+    { ViewMachine::main_state, "switchToMainView()" },
+    { ViewMachine::symbols0_state, "switchToPrimarySymView()" },
+    { ViewMachine::symbols1_state, "switchToSecondarySymView()" }
+};
+
+const TableStateMachine::Transition g_transitions[] = {
+    { ViewMachine::MainState, ViewMachine::SymKeyReleasedEvent, ViewMachine::Symbols0State },
+    { ViewMachine::Symbols0State, ViewMachine::SymKeyReleasedEvent, ViewMachine::MainState },
+    { ViewMachine::Symbols0State, ViewMachine::SymSwitcherReleasedEvent, ViewMachine::Symbols1State },
+    { ViewMachine::Symbols1State, ViewMachine::SymKeyReleasedEvent, ViewMachine::MainState },
+    { ViewMachine::Symbols1State, ViewMachine::SymSwitcherReleasedEvent, ViewMachine::Symbols0State }
+};
+
+} // unnamed namespace
+
 ViewMachine::ViewMachine(QObject *parent)
-    : QStateMachine(parent)
+    : TableStateMachine(parent)
 {}
 
 ViewMachine::~ViewMachine()
@@ -56,39 +74,15 @@ void ViewMachine::setup(LayoutUpdater *updater)
         return;
     }
 
-    setChildMode(QState::ExclusiveStates);
-
-    QState *main = 0;
-    QState *symbols0 = 0;
-    QState *symbols1 = 0;
-
-    // addState makes state machine to be a parent of passed state,
-    // so we don't have to care about deleting states explicitly.
-    addState(main = new QState);
-    addState(symbols0 = new QState);
-    addState(symbols1 = new QState);
-    setInitialState(main);
-
-    main->setObjectName(main_state);
-    symbols0->setObjectName(symbols0_state);
-    symbols1->setObjectName(symbols1_state);
-
-    main->addTransition(updater, SIGNAL(symKeyReleased()), symbols0);
-    connect(main,    SIGNAL(entered()),
-            updater, SLOT(switchToMainView()));
-
-    symbols0->addTransition(updater, SIGNAL(symKeyReleased()), main);
-    symbols0->addTransition(updater, SIGNAL(symSwitcherReleased()), symbols1);
-    connect(symbols0, SIGNAL(entered()),
-            updater,  SLOT(switchToPrimarySymView()));
+    setTables(updater,
+              g_states, StateCount,
+              g_transitions, sizeof(g_transitions) / sizeof(g_transitions[0]),
+              MainState);
 
-    symbols1->addTransition(updater, SIGNAL(symKeyReleased()), main);
-    symbols1->addTransition(updater, SIGNAL(symSwitcherReleased()), symbols0);
-    connect(symbols1, SIGNAL(entered()),
-            updater,  SLOT(switchToSecondarySymView()));
+    connectEvent(updater, SIGNAL(symKeyReleased()), SymKeyReleasedEvent);
+    connectEvent(updater, SIGNAL(symSwitcherReleased()), SymSwitcherReleasedEvent);
 
-    // Defer to first main loop iteration:
-    QTimer::singleShot(0, this, SLOT(start()));
+    start();
 }
 
 }} // namespace Logic, MaliitKeyboard
@@ -34,7 +34,7 @@
 #ifndef MALIIT_KEYBOARD_VIEWMACHINE_H
 #define MALIIT_KEYBOARD_VIEWMACHINE_H
 
-#include "abstractstatemachine.h"
+#include "tablestatemachine.h"
 #include <QtCore>
 
 namespace MaliitKeyboard {
@@ -43,13 +43,24 @@ namespace Logic {
 class LayoutUpdater;
 
 class ViewMachine
-    : public QStateMachine
-    , public AbstractStateMachine
+    : public TableStateMachine
 {
     Q_OBJECT
     Q_DISABLE_COPY(ViewMachine)
 
 public:
+    enum State {
+        MainState,
+        Symbols0State,
+        Symbols1State,
+        StateCount
+    };
+
+    enum Event {
+        SymKeyReleasedEvent,
+        SymSwitcherReleasedEvent
+    };
+
     explicit ViewMachine(QObject *parent = 0);
     virtual ~ViewMachine();
 
@@ -47,10 +47,86 @@ namespace MaliitKeyboard {
 namespace {
 const QString g_main_fn_format("%1/%2/main.ini");
 const QString g_extended_keys_fn_format("%1/%2/extended-keys.ini");
+const QString g_bundle_fn_format("%1/%2/style.bin");
 const QString g_profile_image_directory_path_format("%1/%2/images");
 const QString g_profile_sounds_directory_path_format("%1/%2/sounds");
 const QString g_profile_fonts_directory_path_format("%1/%2/fonts");
 
+//! \brief Size and modification time of the INI files of a profile, together
+//! with the hash of their contents.
+struct SourceHash
+{
+    QList<QPair<qint64, qint64> > stamps;
+    QByteArray hash;
+};
+
+QList<QPair<qint64, qint64> > getStamps(const QStringList &file_names)
+{
+    QList<QPair<qint64, qint64> > stamps;
+
+    Q_FOREACH (const QString &file_name, file_names) {
+        const QFileInfo file_info(file_name);
+
+        stamps.append(file_info.exists()
+                      ? qMakePair(file_info.size(), file_info.lastModified().toMSecsSinceEpoch())
+                      : qMakePair(qint64(-1), qint64(-1)));
+    }
+
+    return stamps;
+}
+
+//! \brief Returns StyleBundle::hashSources() of the INI files of a profile.
+//!
+//! The files are only hashed again once their size or modification time
+//! changed, so that switching back and forth between profiles does not read
+//! them every time.
+QByteArray getSourceHash(const QStringList &file_names)
+{
+    static QHash<QString, SourceHash> hashes;
+
+    SourceHash &entry(hashes[file_names.join(QChar('\n'))]);
+    const QList<QPair<qint64, qint64> > stamps(getStamps(file_names));
+
+    if (entry.hash.isEmpty() or entry.stamps != stamps) {
+        entry.stamps = stamps;
+        entry.hash = StyleBundle::hashSources(file_names);
+    }
+
+    return entry.hash;
+}
+
+//! \brief Returns the bundle compiled by maliit-keyboard-style-compiler, if
+//! there is one and it was compiled from the current INI files of the profile.
+//! \param source_hash The hash of the INI files, as returned by getSourceHash().
+SharedStyleBundle getStyleBundle(const QString &profile,
+                                 const QByteArray &source_hash)
+{
+    const QString bundle_file_name(g_bundle_fn_format
+                                   .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
+                                   .arg(profile));
+
+    if (not QFile::exists(bundle_file_name)) {
+        return SharedStyleBundle();
+    }
+
+    const SharedStyleBundle bundle(new StyleBundle(bundle_file_name));
+
+    if (not bundle->isValid()) {
+        return SharedStyleBundle();
+    }
+
+    // The bundle is matched by content, as installing the profile does not
+    // necessarily keep modification times.
+    if (bundle->sourceHash() != source_hash) {
+        qWarning() << __PRETTY_FUNCTION__
+                   << "Style bundle does not match the INI files, reading them instead:"
+                   << bundle_file_name;
+        return SharedStyleBundle();
+    }
+
+    return bundle;
+}
+
 } // unnamed namespace
 
 
@@ -63,12 +139,17 @@ public:
     QString style_name; //!< The active style name.
     QScopedPointer<StyleAttributes> attributes; //!< The main style attributes.
     QScopedPointer<StyleAttributes> extended_keys_attributes; //!< The extended keys style attributes.
+    QString directories[Style::Fonts + 1]; //!< The profile directories, indexed by Style::Directory.
+    SharedStyleBundle bundle; //!< The compiled profile, if it is used.
+    QByteArray source_hash; //!< The hash of the INI files of the profile.
 
     explicit StylePrivate()
         : profile()
         , style_name()
         , attributes()
         , extended_keys_attributes()
+        , bundle()
+        , source_hash()
     {}
 };
 
@@ -86,7 +167,9 @@ Style::~Style()
 
 //! \brief Sets the style profile.
 //!
-//! Invalidates previous StyleAttributes instances and creates new ones.
+//! Invalidates previous StyleAttributes instances and creates new ones, which
+//! resolve their style snapshots right away. The attributes are read from the
+//! compiled style bundle of the profile unless its INI files changed since.
 //! \param profile The name of the profile, must be a valid sub directory in
 //!                data/styles and contain at least a main.ini file.
 void Style::setProfile(const QString &profile)
@@ -97,22 +180,39 @@ void Style::setProfile(const QString &profile)
     StyleAttributes *attributes = 0;
     StyleAttributes *extended_keys_attributes = 0;
 
+    const QString styles_dir(CoreUtils::maliitKeyboardStyleProfilesDirectory());
+    SharedStyleBundle bundle;
+    QByteArray source_hash;
+
     if (not d->profile.isEmpty()) {
-        const QString main_file_name(g_main_fn_format
-                                     .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
-                                     .arg(profile));
-        const QString extended_keys_file_name(g_extended_keys_fn_format
-                                              .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
-                                              .arg(profile));
-
-        attributes =  new StyleAttributes(
-            new QSettings(main_file_name, QSettings::IniFormat));
-        extended_keys_attributes = new StyleAttributes(
-            new QSettings(extended_keys_file_name, QSettings::IniFormat));
+        const QString main_file_name(g_main_fn_format.arg(styles_dir).arg(profile));
+        const QString extended_keys_file_name(g_extended_keys_fn_format.arg(styles_dir).arg(profile));
+        source_hash = getSourceHash(QStringList() << main_file_name << extended_keys_file_name);
+        bundle = getStyleBundle(profile, source_hash);
+
+        if (bundle) {
+            attributes = new StyleAttributes(bundle, StyleBundle::MainTable);
+            extended_keys_attributes = new StyleAttributes(bundle, StyleBundle::ExtendedKeysTable);
+        } else {
+            attributes =  new StyleAttributes(
+                new QSettings(main_file_name, QSettings::IniFormat));
+            extended_keys_attributes = new StyleAttributes(
+                new QSettings(extended_keys_file_name, QSettings::IniFormat));
+        }
+
+        d->directories[Images] = g_profile_image_directory_path_format.arg(styles_dir).arg(profile);
+        d->directories[Sounds] = g_profile_sounds_directory_path_format.arg(styles_dir).arg(profile);
+        d->directories[Fonts] = g_profile_fonts_directory_path_format.arg(styles_dir).arg(profile);
+    } else {
+        for (int index = 0; index <= Fonts; ++index) {
+            d->directories[index].clear();
+        }
     }
 
     d->attributes.reset(attributes);
     d->extended_keys_attributes.reset(extended_keys_attributes);
+    d->bundle = bundle;
+    d->source_hash = source_hash;
 
     Q_EMIT profileChanged();
 }
@@ -126,6 +226,18 @@ QString Style::profile() const
 }
 
 
+//! \brief Returns the content hash of the INI files of the active profile.
+//!
+//! The hash is the same whether the attributes are read from the INI files
+//! or from the compiled bundle, so it identifies what was converted with
+//! this style.
+QByteArray Style::sourceHash() const
+{
+    Q_D(const Style);
+    return d->source_hash;
+}
+
+
 //! \brief Returns a list of available profiles.
 QStringList Style::availableProfiles() const
 {
@@ -142,28 +254,35 @@ QString Style::directory(Directory directory) const
 {
     Q_D(const Style);
 
-    if (d->profile.isEmpty()) {
-        return QString();
+    return d->directories[directory];
+}
+
+
+//! \brief Lists the files of a profile directory.
+//!
+//! Uses the asset index of the compiled style bundle if there is one, so
+//! that the directory does not need to be read.
+//! @param directory The directory enum value for which we want to know the
+//!                  files.
+//! @returns The file names, relative to the directory. Will be empty if for
+//! instance profile is empty.
+QStringList Style::files(Directory directory) const
+{
+    Q_D(const Style);
+
+    if (d->bundle) {
+        switch (directory) {
+        case Images: return d->bundle->assets(StyleBundle::ImageAsset);
+        case Sounds: return d->bundle->assets(StyleBundle::SoundAsset);
+        case Fonts: return d->bundle->assets(StyleBundle::FontAsset);
+        }
     }
 
-    switch (directory) {
-    case Images:
-        return g_profile_image_directory_path_format
-                .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
-                .arg(d->profile);
-
-    case Sounds:
-        return g_profile_sounds_directory_path_format
-                .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
-                .arg(d->profile);
-
-    case Fonts:
-        return g_profile_fonts_directory_path_format
-                .arg(CoreUtils::maliitKeyboardStyleProfilesDirectory())
-                .arg(d->profile);
+    if (d->directories[directory].isEmpty()) {
+        return QStringList();
     }
 
-    return QString();
+    return QDir(d->directories[directory]).entryList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
 }
 
 
@@ -64,9 +64,11 @@ public:
 
     void setProfile(const QString &profile);
     QString profile() const;
+    QByteArray sourceHash() const;
     QStringList availableProfiles() const;
 
     virtual QString directory(Directory directory) const;
+    QStringList files(Directory directory) const;
 
     StyleAttributes * attributes() const;
     StyleAttributes * extendedKeysAttributes() const;
@@ -33,45 +33,79 @@
 
 namespace MaliitKeyboard {
 
+class AreaData
+    : public QSharedData
+{
+public:
+    QSize size;
+    QByteArray background;
+    QMargins background_borders;
+};
+
+namespace {
+// Every key, key area and word ribbon holds an area, most of which are
+// replaced right after construction.
+const QSharedDataPointer<AreaData> &defaultAreaData()
+{
+    static const QSharedDataPointer<AreaData> data(new AreaData);
+    return data;
+}
+}
+
 Area::Area()
-    : m_size()
-    , m_background()
-    , m_background_borders()
+    : d(defaultAreaData())
+{}
+
+Area::Area(const Area &other)
+    : d(other.d)
+{}
+
+Area::~Area()
 {}
 
+Area &Area::operator=(const Area &other)
+{
+    d = other.d;
+    return *this;
+}
+
 void Area::setSize(const QSize &size)
 {
-    m_size = size;
+    d->size = size;
 }
 
 QSize Area::size() const
 {
-    return m_size;
+    return d->size;
 }
 
 void Area::setBackground(const QByteArray &background)
 {
-    m_background = background;
+    d->background = background;
 }
 
 QByteArray Area::background() const
 {
-    return m_background;
+    return d->background;
 }
 
 void Area::setBackgroundBorders(const QMargins &borders)
 {
-    m_background_borders = borders;
+    d->background_borders = borders;
 }
 
 QMargins Area::backgroundBorders() const
 {
-    return m_background_borders;
+    return d->background_borders;
 }
 
 bool operator==(const Area &lhs,
                 const Area &rhs)
 {
+    if (lhs.d == rhs.d) {
+        return true;
+    }
+
     return (lhs.size() == rhs.size()
             && lhs.background() == rhs.background()
             && lhs.backgroundBorders() == rhs.backgroundBorders());
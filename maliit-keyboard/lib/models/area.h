@@ -36,15 +36,23 @@
 
 namespace MaliitKeyboard {
 
+class AreaData;
+
+//! \brief Size and background of a key, key area or word ribbon. Implicitly
+//! shared.
 class Area
 {
 private:
-    QSize m_size;
-    QByteArray m_background;
-    QMargins m_background_borders;
+    QSharedDataPointer<AreaData> d;
+
+    friend bool operator==(const Area &lhs,
+                           const Area &rhs);
 
 public:
     explicit Area();
+    Area(const Area &other);
+    ~Area();
+    Area &operator=(const Area &other);
 
     void setSize(const QSize &size);
     QSize size() const;
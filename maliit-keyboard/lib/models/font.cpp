@@ -33,51 +33,107 @@
 
 namespace MaliitKeyboard {
 
+class FontData
+    : public QSharedData
+{
+public:
+    QByteArray name;
+    int size;
+    QByteArray color;
+    int stretch;
+
+    explicit FontData()
+        : name()
+        , size(0)
+        , color()
+        , stretch(100)
+    {}
+};
+
+namespace {
+// Fonts are mostly default constructed only to be assigned the font of the
+// style right after, so they start out on one shared FontData.
+const QSharedDataPointer<FontData> &defaultFontData()
+{
+    static const QSharedDataPointer<FontData> data(new FontData);
+    return data;
+}
+}
+
 Font::Font()
-    : m_name()
-    , m_size(0)
-    , m_color()
-    , m_stretch(100)
+    : d(defaultFontData())
+{}
+
+Font::Font(const Font &other)
+    : d(other.d)
+{}
+
+Font::~Font()
 {}
 
+Font &Font::operator=(const Font &other)
+{
+    d = other.d;
+    return *this;
+}
+
 QByteArray Font::name() const
 {
-    return m_name;
+    return d->name;
 }
 
 void Font::setName(const QByteArray &name)
 {
-    m_name = name;
+    d->name = name;
 }
 
 int Font::size() const
 {
-    return m_size;
+    return d->size;
 }
 
 void Font::setSize(int size)
 {
-    m_size = size;
+    d->size = size;
 }
 
 QByteArray Font::color() const
 {
-    return m_color;
+    return d->color;
 }
 
 void Font::setColor(const QByteArray &color)
 {
-    m_color = color;
+    d->color = color;
 }
 
 int Font::stretch() const
 {
-    return m_stretch;
+    return d->stretch;
 }
 
 void Font::setStretch(int stretch)
 {
-    m_stretch = stretch;
+    d->stretch = stretch;
+}
+
+bool operator==(const Font &lhs,
+                const Font &rhs)
+{
+    if (lhs.d == rhs.d) {
+        return true;
+    }
+
+    return (lhs.name() == rhs.name()
+            && lhs.size() == rhs.size()
+            && lhs.color() == rhs.color()
+            && lhs.stretch() == rhs.stretch());
+}
+
+bool operator!=(const Font &lhs,
+                const Font &rhs)
+{
+    return (not (lhs == rhs));
 }
 
 } // namespace MaliitKeyboard
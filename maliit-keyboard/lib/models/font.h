@@ -36,16 +36,22 @@
 
 namespace MaliitKeyboard {
 
+class FontData;
+
+//! \brief Font of a label. Implicitly shared.
 class Font
 {
 private:
-    QByteArray m_name;
-    int m_size;
-    QByteArray m_color;
-    int m_stretch;
+    QSharedDataPointer<FontData> d;
+
+    friend bool operator==(const Font &lhs,
+                           const Font &rhs);
 
 public:
     explicit Font();
+    Font(const Font &other);
+    ~Font();
+    Font &operator=(const Font &other);
 
     QByteArray name() const;
     void setName(const QByteArray &name);
@@ -60,6 +66,12 @@ public:
     void setStretch(int stretch);
 };
 
+bool operator==(const Font &lhs,
+                const Font &rhs);
+
+bool operator!=(const Font &lhs,
+                const Font &rhs);
+
 } // namespace MaliitKeyboard
 
 #endif // MALIIT_KEYBOARD_FONT_H
@@ -34,131 +34,198 @@
 
 namespace MaliitKeyboard {
 
+class KeyData
+    : public QSharedData
+{
+public:
+    QPoint origin;
+    Area area;
+    Label label;
+    Key::Action action;
+    Key::Style style;
+    QMargins margins;
+    QByteArray icon;
+    bool has_extended_keys: 1;
+    int flags_padding: 7;
+    int extended_keys_id;
+    QString command_sequence;
+
+    explicit KeyData()
+        : origin()
+        , area()
+        , label()
+        , action(Key::ActionInsert)
+        , style(Key::StyleNormalKey)
+        , margins()
+        , icon()
+        , has_extended_keys(false)
+        , flags_padding(0)
+        , extended_keys_id(-1)
+        , command_sequence()
+    {}
+};
+
+namespace {
+// Keys are default constructed for every slot of a QVector<Key>, before
+// being assigned, so they start out sharing one empty KeyData.
+const QSharedDataPointer<KeyData> &defaultKeyData()
+{
+    static const QSharedDataPointer<KeyData> data(new KeyData);
+    return data;
+}
+}
+
 Key::Key()
-    : m_origin()
-    , m_area()
-    , m_label()
-    , m_action(ActionInsert)
-    , m_style(StyleNormalKey)
-    , m_margins()
-    , m_icon()
-    , m_has_extended_keys(false)
+    : d(defaultKeyData())
+{}
+
+Key::Key(const Key &other)
+    : d(other.d)
 {}
 
+Key::~Key()
+{}
+
+Key &Key::operator=(const Key &other)
+{
+    d = other.d;
+    return *this;
+}
+
 bool Key::valid() const
 {
-    return (m_area.size().isValid()
-            && (not m_label.text().isEmpty() || m_action != Key::ActionCommit));
+    return (d->area.size().isValid()
+            && (not d->label.text().isEmpty() || d->action != Key::ActionCommit));
 }
 
 QRect Key::rect() const
 {
-    return QRect(m_origin, m_area.size());
+    return QRect(d->origin, d->area.size());
 }
 
 QPoint Key::origin() const
 {
-    return m_origin;
+    return d->origin;
 }
 
 void Key::setOrigin(const QPoint &origin)
 {
-    m_origin = origin;
+    d->origin = origin;
 }
 
 Area Key::area() const
 {
-    return m_area;
+    return d->area;
 }
 
+//! Detaches the key, so the returned reference is never shared with copies.
 Area & Key::rArea()
 {
-    return m_area;
+    return d->area;
 }
 
 void Key::setArea(const Area &area)
 {
-    m_area = area;
+    d->area = area;
 }
 
 Label Key::label() const
 {
-    return m_label;
+    return d->label;
 }
 
+//! Detaches the key, so the returned reference is never shared with copies.
 Label & Key::rLabel()
 {
-    return m_label;
+    return d->label;
 }
 
 void Key::setLabel(const Label &label)
 {
-    m_label = label;
+    d->label = label;
 }
 
 Key::Action Key::action() const
 {
-    return m_action;
+    return d->action;
 }
 
 void Key::setAction(Action action)
 {
-    m_action = action;
+    d->action = action;
 }
 
 Key::Style Key::style() const
 {
-    return m_style;
+    return d->style;
 }
 
 void Key::setStyle(Style style)
 {
-    m_style = style;
+    d->style = style;
 }
 
 QMargins Key::margins() const
 {
-    return m_margins;
+    return d->margins;
 }
 
 void Key::setMargins(const QMargins &margins)
 {
-    m_margins = margins;
+    d->margins = margins;
 }
 
 QByteArray Key::icon() const
 {
-    return m_icon;
+    return d->icon;
 }
 
 void Key::setIcon(const QByteArray &icon)
 {
-    m_icon = icon;
+    d->icon = icon;
 }
 
 bool Key::hasExtendedKeys() const
 {
-    return m_has_extended_keys;
+    return d->has_extended_keys;
 }
 
 void Key::setExtendedKeysEnabled(bool enable)
 {
-    m_has_extended_keys = enable;
+    d->has_extended_keys = enable;
+}
+
+//! \brief Returns the id of the key's extended keys in its layout.
+//!
+//! The id is -1 if the key was not created from a layout, in which case the
+//! extended keys are looked up by label.
+int Key::extendedKeysId() const
+{
+    return d->extended_keys_id;
+}
+
+void Key::setExtendedKeysId(int id)
+{
+    d->extended_keys_id = id;
 }
 
 QString Key::commandSequence() const
 {
-    return m_command_sequence;
+    return d->command_sequence;
 }
 
 void Key::setCommandSequence(const QString &command_sequence)
 {
-    m_command_sequence = command_sequence;
+    d->command_sequence = command_sequence;
 }
 
 bool operator==(const Key &lhs,
                 const Key &rhs)
 {
+    if (lhs.d == rhs.d) {
+        return true;
+    }
+
     return (lhs.origin() == rhs.origin()
             && lhs.area() == rhs.area()
             && lhs.label() == rhs.label()
@@ -40,6 +40,10 @@
 
 namespace MaliitKeyboard {
 
+class KeyData;
+
+//! \brief A key of a key area. Implicitly shared: copies are cheap and only
+//! detach when modified.
 class Key
 {
 public:
@@ -84,19 +88,16 @@ public:
     };
 
 private:
-    QPoint m_origin;
-    Area m_area;
-    Label m_label;
-    Action m_action;
-    Style m_style;
-    QMargins m_margins;
-    QByteArray m_icon;
-    bool m_has_extended_keys: 1;
-    int m_flags_padding: 7;
-    QString m_command_sequence;
+    QSharedDataPointer<KeyData> d;
+
+    friend bool operator==(const Key &lhs,
+                           const Key &rhs);
 
 public:
     explicit Key();
+    Key(const Key &other);
+    ~Key();
+    Key &operator=(const Key &other);
 
     // read-only properties:
     bool valid() const;
@@ -128,6 +129,9 @@ public:
     bool hasExtendedKeys() const;
     void setExtendedKeysEnabled(bool enable);
 
+    int extendedKeysId() const;
+    void setExtendedKeysId(int id);
+
     QString commandSequence() const;
     void setCommandSequence(const QString &command_sequence);
 };
@@ -32,12 +32,15 @@
 
 #include "keyarea.h"
 
+#include "coreutils.h"
+
 namespace MaliitKeyboard {
 
 KeyArea::KeyArea()
     : m_keys()
     , m_origin()
     , m_area()
+    , m_content_id(0)
 {}
 
 bool KeyArea::hasKeys() const
@@ -50,6 +53,15 @@ QRect KeyArea::rect() const
     return QRect(m_origin, m_area.size());
 }
 
+//! \brief Returns the id of keys and area, see CoreUtils::nextContentId().
+//!
+//! The origin is not part of the content, so moving a key area keeps its id.
+//! rKeys() and rArea() drop the id.
+int KeyArea::contentId() const
+{
+    return m_content_id;
+}
+
 QPoint KeyArea::origin() const
 {
     return m_origin;
@@ -67,11 +79,13 @@ QVector<Key> KeyArea::keys() const
 
 QVector<Key> & KeyArea::rKeys()
 {
+    m_content_id = 0;
     return m_keys;
 }
 
 void KeyArea::setKeys(const QVector<Key> &keys)
 {
+    m_content_id = CoreUtils::nextContentId();
     m_keys = keys;
 }
 
@@ -82,19 +96,25 @@ Area KeyArea::area() const
 
 Area & KeyArea::rArea()
 {
+    m_content_id = 0;
     return m_area;
 }
 
 void KeyArea::setArea(const Area &area)
 {
+    m_content_id = CoreUtils::nextContentId();
     m_area = area;
 }
 
 bool operator==(const KeyArea &lhs,
                 const KeyArea &rhs)
 {
+    if (lhs.contentId() != 0 and rhs.contentId() != 0) {
+        return (lhs.contentId() == rhs.contentId());
+    }
+
     return (lhs.area() == rhs.area()
-            && lhs.keys() == rhs.keys());
+            and lhs.keys() == rhs.keys());
 }
 
 bool operator!=(const KeyArea &lhs,
@@ -44,6 +44,7 @@ private:
     QVector<Key> m_keys;
     QPoint m_origin;
     Area m_area;
+    int m_content_id;
     qreal m_margin;
 
 public:
@@ -51,6 +52,7 @@ public:
 
     bool hasKeys() const;
     QRect rect() const;
+    int contentId() const;
 
     QPoint origin() const;
     void setOrigin(const QPoint &origin);
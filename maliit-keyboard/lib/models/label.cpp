@@ -33,46 +33,77 @@
 
 namespace MaliitKeyboard {
 
+class LabelData
+    : public QSharedData
+{
+public:
+    QString text;
+    Font font;
+    QRect rect;
+};
+
+namespace {
+// A default constructed label is empty, it only gets data of its own once
+// text, rect or font are set.
+const QSharedDataPointer<LabelData> &defaultLabelData()
+{
+    static const QSharedDataPointer<LabelData> data(new LabelData);
+    return data;
+}
+}
+
 Label::Label()
-    : m_text()
-    , m_font()
-    , m_rect()
+    : d(defaultLabelData())
 {}
 
+Label::Label(const Label &other)
+    : d(other.d)
+{}
+
+Label::~Label()
+{}
+
+Label &Label::operator=(const Label &other)
+{
+    d = other.d;
+    return *this;
+}
+
 QString Label::text() const
 {
-    return m_text;
+    return d->text;
 }
 
 void Label::setText(const QString &text)
 {
-    m_text = text;
+    d->text = text;
 }
 
 Font Label::font() const
 {
-    return m_font;
+    return d->font;
 }
 
-void Label::setFont(const Font &label)
+void Label::setFont(const Font &font)
 {
-    m_font = label;
+    d->font = font;
 }
 
 QRect Label::rect() const
 {
-    return m_rect;
+    return d->rect;
 }
 
 void Label::setRect(const QRect &rect)
 {
-    m_rect = rect;
+    d->rect = rect;
 }
 
 bool operator==(const Label &lhs,
                 const Label &rhs)
 {
-    return (lhs.rect() == rhs.rect() && lhs.text() == rhs.text());
+    return (lhs.d == rhs.d
+            || (lhs.rect() == rhs.rect() && lhs.text() == rhs.text()));
 }
 
 bool operator!=(const Label &lhs,
@@ -37,15 +37,22 @@
 
 namespace MaliitKeyboard {
 
+class LabelData;
+
+//! \brief Text and font of a key or word candidate. Implicitly shared.
 class Label
 {
 private:
-    QString m_text;
-    Font m_font;
-    QRect m_rect;
+    QSharedDataPointer<LabelData> d;
+
+    friend bool operator==(const Label &lhs,
+                           const Label &rhs);
 
 public:
     explicit Label();
+    Label(const Label &other);
+    ~Label();
+    Label &operator=(const Label &other);
 
     QString text() const;
     void setText(const QString &text);
@@ -50,6 +50,63 @@ QUrl toUrl(const QString &directory,
     return QUrl();
 
 }
+
+// Returns the model roles whose values differ between two keys, so that
+// views only need to re-evaluate the affected bindings.
+QVector<int> changedRoles(const Key &old_key,
+                          const Key &new_key)
+{
+    QVector<int> roles;
+
+    if (old_key.rect() != new_key.rect()) {
+        roles << Layout::RoleKeyRectangle << Layout::RoleKeyReactiveArea;
+    } else if (old_key.margins() != new_key.margins()) {
+        roles << Layout::RoleKeyRectangle;
+    }
+
+    const Area &old_area(old_key.area());
+    const Area &new_area(new_key.area());
+
+    if (old_area.background() != new_area.background()) {
+        roles << Layout::RoleKeyBackground;
+    }
+
+    if (old_area.backgroundBorders() != new_area.backgroundBorders()) {
+        roles << Layout::RoleKeyBackgroundBorders;
+    }
+
+    const Label &old_label(old_key.label());
+    const Label &new_label(new_key.label());
+
+    if (old_label.text() != new_label.text()) {
+        roles << Layout::RoleKeyText;
+    }
+
+    const Font &old_font(old_label.font());
+    const Font &new_font(new_label.font());
+
+    if (old_font.name() != new_font.name()) {
+        roles << Layout::RoleKeyFont;
+    }
+
+    if (old_font.color() != new_font.color()) {
+        roles << Layout::RoleKeyFontColor;
+    }
+
+    if (old_font.size() != new_font.size()) {
+        roles << Layout::RoleKeyFontSize;
+    }
+
+    if (old_font.stretch() != new_font.stretch()) {
+        roles << Layout::RoleKeyFontStretch;
+    }
+
+    if (old_key.icon() != new_key.icon()) {
+        roles << Layout::RoleKeyIcon;
+    }
+
+    return roles;
+}
 }
 
 
@@ -108,9 +165,15 @@ void Layout::setScaleRatio(qreal ratio)
         return;
     }
 
-    beginResetModel();
     d_ptr->scaleRatio = ratio;
-    endResetModel();
+
+    if (rowCount() > 0) {
+        Q_EMIT dataChanged(index(0, 0), index(rowCount() - 1, 0),
+                           QVector<int>() << RoleKeyRectangle
+                                          << RoleKeyReactiveArea
+                                          << RoleKeyBackgroundBorders);
+    }
+
     Q_EMIT widthChanged(width());
     Q_EMIT heightChanged(height());
 }
@@ -133,11 +196,17 @@ QString Layout::title() const
 }
 
 
+//! \brief Replaces the key area shown by this model.
+//!
+//! Instead of resetting the model, the old and new keys are compared row by
+//! row: rows are only inserted or removed when the key count changes, and
+//! dataChanged is emitted with just the roles that differ. This keeps QML
+//! delegates alive across shift toggles and view switches.
 void Layout::setKeyArea(const KeyArea &area)
 {
-    beginResetModel();
-
     Q_D(Layout);
+
+    const bool content_changed(area.contentId() == 0 || d->key_area.contentId() != area.contentId());
     const bool geometry_changed(d->key_area.rect() != area.rect());
     const bool background_changed(d->key_area.area().background() != area.area().background());
     const bool background_borders_changed(d->key_area.area().backgroundBorders() != area.area().backgroundBorders());
@@ -145,7 +214,53 @@ void Layout::setKeyArea(const KeyArea &area)
                                || (not d->key_area.keys().isEmpty() && area.keys().isEmpty()));
     const bool origin_changed(d->key_area.origin() != area.origin());
 
-    d->key_area = area;
+    // Cheap, keys are implicitly shared:
+    const QVector<Key> old_keys(d->key_area.keys());
+    const QVector<Key> &new_keys(area.keys());
+    const int old_count(old_keys.count());
+    const int new_count(new_keys.count());
+
+    if (new_count < old_count) {
+        beginRemoveRows(QModelIndex(), new_count, old_count - 1);
+        d->key_area = area;
+        endRemoveRows();
+    } else if (new_count > old_count) {
+        beginInsertRows(QModelIndex(), old_count, new_count - 1);
+        d->key_area = area;
+        endInsertRows();
+    } else {
+        d->key_area = area;
+    }
+
+    if (content_changed) {
+        int first = -1;
+        int last = -1;
+        QVector<int> roles;
+
+        for (int index = 0, count = qMin(old_count, new_count); index < count; ++index) {
+            const QVector<int> &key_roles(changedRoles(old_keys.at(index), new_keys.at(index)));
+
+            if (key_roles.isEmpty()) {
+                continue;
+            }
+
+            if (first < 0) {
+                first = index;
+            }
+
+            last = index;
+
+            Q_FOREACH (int role, key_roles) {
+                if (not roles.contains(role)) {
+                    roles.append(role);
+                }
+            }
+        }
+
+        if (first >= 0) {
+            Q_EMIT dataChanged(this->index(first, 0), this->index(last, 0), roles);
+        }
+    }
 
     if (origin_changed) {
         Q_EMIT originChanged(d->key_area.origin());
@@ -167,8 +282,6 @@ void Layout::setKeyArea(const KeyArea &area)
     if (visible_changed) {
         Q_EMIT visibleChanged(not d->key_area.keys().isEmpty());
     }
-
-    endResetModel();
 }
 
 
@@ -183,8 +296,19 @@ void Layout::replaceKey(int index,
                         const Key &key)
 {
     Q_D(Layout);
+
+    if (index < 0 || index >= d->key_area.keys().count()) {
+        qWarning() << __PRETTY_FUNCTION__
+                   << "Invalid index:" << index;
+        return;
+    }
+
+    const QVector<int> &roles(changedRoles(d->key_area.keys().at(index), key));
     d->key_area.rKeys().replace(index, key);
-    Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0));
+
+    if (not roles.isEmpty()) {
+        Q_EMIT dataChanged(this->index(index, 0), this->index(index, 0), roles);
+    }
 }
 
 
@@ -238,10 +362,13 @@ void Layout::setImageDirectory(const QString &directory)
 
     if (d->image_directory != directory) {
         d->image_directory = directory;
-        // TODO: Make sure we don't accidentially invalidate the whole model twice
-        beginResetModel();
-        backgroundChanged(background());
-        endResetModel();
+        Q_EMIT backgroundChanged(background());
+
+        if (rowCount() > 0) {
+            Q_EMIT dataChanged(index(0, 0), index(rowCount() - 1, 0),
+                               QVector<int>() << RoleKeyBackground
+                                              << RoleKeyIcon);
+        }
     }
 }
 
@@ -98,8 +98,8 @@ public:
     Q_SLOT void setKeyArea(const KeyArea &area);
     KeyArea keyArea() const;
 
-    void replaceKey(int index,
-                    const Key &key);
+    Q_SLOT void replaceKey(int index,
+                           const Key &key);
 
     Q_SLOT bool isVisible() const;
     Q_SIGNAL void visibleChanged(bool changed);
@@ -13,6 +13,7 @@ HEADERS += \
     models/wordribbon.h \
     models/text.h \
     models/styleattributes.h \
+    models/stylebundle.h \
 
 SOURCES += \
     models/area.cpp \
@@ -25,5 +26,6 @@ SOURCES += \
     models/wordribbon.cpp \
     models/text.cpp \
     models/styleattributes.cpp \
+    models/stylebundle.cpp \
 
 DEPENDPATH += $$MODELS_DIR
@@ -34,7 +34,8 @@
 
 //! \class StyleAttributes
 //! This class allows to query style attributes, such as image names and font
-//! sizes. Styling attributes are read from INI files.
+//! sizes. Styling attributes are read from INI files, or from a style bundle
+//! compiled from them.
 
 namespace MaliitKeyboard {
 namespace {
@@ -166,38 +167,174 @@ QByteArray buildKey(Logic::LayoutHelper::Orientation orientation,
 }
 
 
-//! \brief Looks up values in a QSettings store.
-//! @param orientation The layout orientation (landscape or portrait).
-//! @param style_name Style name, maps to INI file sections. If section does
-//!                   not exist, lookup will be repeated in 'default' section.
-//! @param attribute_name The attribute name we want to look up.
-//! @returns A value. QVariant can be invalid.
-QVariant lookup(const QScopedPointer<const QSettings> &store,
-                Logic::LayoutHelper::Orientation orientation,
-                const QByteArray &style_name,
-                const QByteArray &attribute_name)
+//! \brief Returns whether an INI file section holds a style.
+bool isStyleSection(const QString &section)
 {
-    const QVariant &result(store->value(buildKey(orientation, style_name, attribute_name)));
-
-    if (not result.isValid()) {
-        return store->value(buildKey(orientation, QByteArray("default"), attribute_name));
-    }
-
-    return result;
+    return (section != "background"
+            && section != "icon"
+            && section != "sound"
+            && section != "font");
 }
 
 } // namespace
 
 
+//! \class StyleSnapshot
+//! Key area conversion reads these fields for every key, instead of looking
+//! each value up in QSettings (and again in the 'default' section on a miss).
+
+StyleSnapshot::StyleSnapshot()
+    : font()
+    , small_font()
+    , key_background_borders()
+    , custom_icons()
+    , key_area_background()
+    , key_area_background_borders()
+    , key_area_width(0)
+    , key_height(0)
+    , key_top_row_height(0)
+    , key_bottom_row_height(0)
+    , key_margin(0)
+    , key_area_padding(0)
+    , vertical_offset(0)
+    , word_ribbon_height(0)
+{
+    for (int index = 0; index < WidthCount; ++index) {
+        key_widths[index] = 0;
+    }
+}
+
+
 //! @param store The settings store which is used to look up all attributes.
 //!              Must not be null. StyleAttribute instance takes ownership.
 StyleAttributes::StyleAttributes(const QSettings *store)
     : m_store(store)
+    , m_bundle()
+    , m_bundle_table(StyleBundle::MainTable)
     , m_style_name()
+    , m_cache()
+    , m_style_cache()
+    , m_cache_hits(0)
+    , m_cache_misses(0)
 {
     if (m_store.isNull()) {
         qFatal("QSettings store cannot be null!");
     }
+
+    buildSnapshots();
+}
+
+
+//! @param bundle The compiled style profile which is used to look up all
+//!               attributes. Must be valid.
+//! @param table The bundle table holding the attributes.
+StyleAttributes::StyleAttributes(const SharedStyleBundle &bundle,
+                                 StyleBundle::Table table)
+    : m_store()
+    , m_bundle(bundle)
+    , m_bundle_table(table)
+    , m_style_name()
+    , m_cache()
+    , m_style_cache()
+    , m_cache_hits(0)
+    , m_cache_misses(0)
+{
+    if (m_bundle.isNull() || not m_bundle->isValid()) {
+        qFatal("Style bundle must be valid!");
+    }
+
+    buildSnapshots();
+}
+
+
+//! \brief Reads a value from the INI file or the style bundle, without
+//! caching.
+QVariant StyleAttributes::storeValue(const QString &key) const
+{
+    return (m_bundle ? m_bundle->value(m_bundle_table, key)
+                     : m_store->value(key));
+}
+
+
+//! \brief Returns all keys of the INI file or the style bundle.
+QStringList StyleAttributes::storeKeys() const
+{
+    return (m_bundle ? m_bundle->keys(m_bundle_table)
+                     : m_store->allKeys());
+}
+
+
+//! \brief Resolves the snapshots of all style sections, and of the 'default'
+//! section, for both orientations.
+void StyleAttributes::buildSnapshots()
+{
+    QHash<QByteArray, QByteArray> custom_icons;
+    QStringList style_names(QString("default"));
+
+    Q_FOREACH (const QString &key, storeKeys()) {
+        if (key.startsWith("icon/")) {
+            custom_icons.insert(key.mid(5).toUtf8(), storeValue(key).toByteArray());
+        }
+
+        const int separator(key.indexOf('/'));
+        const QString section(key.left(separator));
+
+        if (separator > 0 && isStyleSection(section) && not style_names.contains(section)) {
+            style_names.append(section);
+        }
+    }
+
+    const Logic::LayoutHelper::Orientation orientations[] = {
+        Logic::LayoutHelper::Landscape, Logic::LayoutHelper::Portrait
+    };
+
+    Q_FOREACH (const QString &style_name, style_names) {
+        setStyleName(style_name);
+
+        for (int o = 0; o < 2; ++o) {
+            const Logic::LayoutHelper::Orientation orientation(orientations[o]);
+            StyleSnapshot snapshot;
+
+            snapshot.font.setName(fontName(orientation));
+            snapshot.font.setSize(fontSize(orientation));
+            snapshot.font.setColor(fontColor(orientation));
+            snapshot.small_font = snapshot.font;
+            snapshot.small_font.setSize(smallFontSize(orientation));
+
+            for (int width = 0; width < StyleSnapshot::WidthCount; ++width) {
+                snapshot.key_widths[width] = keyWidth(orientation, static_cast<KeyDescription::Width>(width));
+            }
+
+            for (int state = 0; state < StyleSnapshot::StateCount; ++state) {
+                const KeyDescription::State s(static_cast<KeyDescription::State>(state));
+
+                for (int style = 0; style < StyleSnapshot::KeyStyleCount; ++style) {
+                    snapshot.key_backgrounds[style][state] = keyBackground(static_cast<Key::Style>(style), s);
+                }
+
+                for (int icon_type = 0; icon_type < StyleSnapshot::IconCount; ++icon_type) {
+                    snapshot.icons[icon_type][state] = icon(static_cast<KeyDescription::Icon>(icon_type), s);
+                }
+            }
+
+            snapshot.key_background_borders = keyBackgroundBorders();
+            snapshot.custom_icons = custom_icons;
+            snapshot.key_area_background = keyAreaBackground();
+            snapshot.key_area_background_borders = keyAreaBackgroundBorders();
+            snapshot.key_area_width = keyAreaWidth(orientation);
+            snapshot.key_height = keyHeight(orientation);
+            snapshot.key_top_row_height = keyTopRowHeight(orientation);
+            snapshot.key_bottom_row_height = keyBottomRowHeight(orientation);
+            snapshot.key_margin = keyMargin(orientation);
+            snapshot.key_area_padding = keyAreaPadding(orientation);
+            snapshot.vertical_offset = verticalOffset(orientation);
+            snapshot.word_ribbon_height = wordRibbonHeight(orientation);
+
+            m_snapshots[orientation].insert(style_name, snapshot);
+        }
+    }
+
+    setStyleName(QString());
 }
 
 //! \brief Destructor
@@ -222,11 +359,105 @@ void StyleAttributes::setStyleName(const QString &name)
     m_style_name = name;
 }
 
+
+//! \brief Looks up a value that does not depend on the style name, such as
+//! "background/key-area".
+//! @param key The full key, including the INI file section.
+//! @returns A value. QVariant can be invalid.
+QVariant StyleAttributes::value(const QByteArray &key) const
+{
+    const QHash<QByteArray, QVariant>::const_iterator it(m_cache.find(key));
+
+    if (it != m_cache.constEnd()) {
+        ++m_cache_hits;
+        return it.value();
+    }
+
+    ++m_cache_misses;
+    const QVariant result(storeValue(key));
+    m_cache.insert(key, result);
+
+    return result;
+}
+
+
+//! \brief Looks up a value of the active style.
+//! @param orientation The layout orientation (landscape or portrait).
+//! @param attribute_name The attribute name we want to look up. If the
+//!                       section of the active style name does not hold the
+//!                       attribute, it is looked up in the 'default' section.
+//! @returns A value. QVariant can be invalid.
+QVariant StyleAttributes::lookup(Logic::LayoutHelper::Orientation orientation,
+                                 const QByteArray &attribute_name) const
+{
+    // The style cache holds the values of all styles, so that it survives
+    // style name changes, which happen for each view that is converted. It
+    // lives as long as this instance, i.e. until the profile changes.
+    const QByteArray cache_key(buildKey(orientation, m_style_name.toLocal8Bit(), attribute_name));
+    const QHash<QByteArray, QVariant>::const_iterator it(m_style_cache.find(cache_key));
+
+    if (it != m_style_cache.constEnd()) {
+        ++m_cache_hits;
+        return it.value();
+    }
+
+    ++m_cache_misses;
+    QVariant result(storeValue(cache_key));
+
+    if (not result.isValid()) {
+        result = storeValue(buildKey(orientation, QByteArray("default"), attribute_name));
+    }
+
+    m_style_cache.insert(cache_key, result);
+
+    return result;
+}
+
+
+//! \brief Returns how many attribute lookups were answered from the cache.
+int StyleAttributes::cacheHits() const
+{
+    return m_cache_hits;
+}
+
+
+//! \brief Returns how many attribute lookups had to query the INI file.
+int StyleAttributes::cacheMisses() const
+{
+    return m_cache_misses;
+}
+
+//! \brief Returns the file the attributes are read from.
+QString StyleAttributes::fileName() const
+{
+    return (m_bundle ? m_bundle->fileName() : m_store->fileName());
+}
+
+//! \brief Returns the resolved style attributes for a style name.
+//!
+//! Style names without a section of their own resolve to the 'default'
+//! section, just like the single attribute lookups.
+//! \param style_name The style name, maps to INI file sections.
+//! \param orientation The layout orientation (landscape or portrait).
+const StyleSnapshot &StyleAttributes::snapshot(const QString &style_name,
+                                               Logic::LayoutHelper::Orientation orientation) const
+{
+    const QHash<QString, StyleSnapshot> &snapshots(m_snapshots[orientation]);
+    QHash<QString, StyleSnapshot>::const_iterator it(snapshots.find(style_name));
+
+    if (it == snapshots.constEnd()) {
+        it = snapshots.find(QString("default"));
+    }
+
+    return it.value();
+}
+
+
 //! \brief Looks up the background image name for word ribbons.
 //! @returns Value of "background\word-ribbon".
 QByteArray StyleAttributes::wordRibbonBackground() const
 {
-    return m_store->value("background/word-ribbon").toByteArray();
+    return value("background/word-ribbon").toByteArray();
 }
 
 
@@ -234,7 +465,7 @@ QByteArray StyleAttributes::wordRibbonBackground() const
 //! @returns Value of "background\key-area".
 QByteArray StyleAttributes::keyAreaBackground() const
 {
-    return m_store->value("background/key-area").toByteArray();
+    return value("background/key-area").toByteArray();
 }
 
 
@@ -242,7 +473,7 @@ QByteArray StyleAttributes::keyAreaBackground() const
 //! @returns Value of "background\magnifier-key"
 QByteArray StyleAttributes::magnifierKeyBackground() const
 {
-    return m_store->value("background/magnifier-key").toByteArray();
+    return value("background/magnifier-key").toByteArray();
 }
 
 
@@ -258,7 +489,7 @@ QByteArray StyleAttributes::keyBackground(Key::Style style,
     key.append(fromKeyStyle(style));
     key.append(fromKeyState(state));
 
-    return m_store->value(key).toByteArray();
+    return value(key).toByteArray();
 }
 
 
@@ -266,7 +497,7 @@ QByteArray StyleAttributes::keyBackground(Key::Style style,
 //! @returns Value of "background\word-ribbon-borders".
 QMargins StyleAttributes::wordRibbonBackgroundBorders() const
 {
-    return fromByteArray(m_store->value("background/word-ribbon-borders").toByteArray());
+    return fromByteArray(value("background/word-ribbon-borders").toByteArray());
 }
 
 
@@ -274,7 +505,7 @@ QMargins StyleAttributes::wordRibbonBackgroundBorders() const
 //! @returns Value of "background\key-area-borders".
 QMargins StyleAttributes::keyAreaBackgroundBorders() const
 {
-    return fromByteArray(m_store->value("background/key-area-borders").toByteArray());
+    return fromByteArray(value("background/key-area-borders").toByteArray());
 }
 
 
@@ -282,7 +513,7 @@ QMargins StyleAttributes::keyAreaBackgroundBorders() const
 //! @returns Value of "background\magnifier-key-borders".
 QMargins StyleAttributes::magnifierKeyBackgroundBorders() const
 {
-    return fromByteArray(m_store->value("background/magnifier-key-borders").toByteArray());
+    return fromByteArray(value("background/magnifier-key-borders").toByteArray());
 }
 
 
@@ -290,7 +521,7 @@ QMargins StyleAttributes::magnifierKeyBackgroundBorders() const
 //! @returns Value of "background\key-borders".
 QMargins StyleAttributes::keyBackgroundBorders() const
 {
-    return fromByteArray(m_store->value("background/key-borders").toByteArray());
+    return fromByteArray(value("background/key-borders").toByteArray());
 }
 
 
@@ -305,7 +536,7 @@ QByteArray StyleAttributes::icon(KeyDescription::Icon icon,
     key.append(fromKeyIcon(icon));
     key.append(fromKeyState(state));
 
-    return m_store->value(key).toByteArray();
+    return value(key).toByteArray();
 }
 
 
@@ -317,7 +548,7 @@ QByteArray StyleAttributes::customIcon(const QString &icon_name) const
     QByteArray key("icon/");
     key.append(icon_name.toUtf8());
 
-    return m_store->value(key).toByteArray();
+    return value(key).toByteArray();
 }
 
 
@@ -327,9 +558,7 @@ QByteArray StyleAttributes::customIcon(const QString &icon_name) const
 //! Pure" if there was no such value in style.ini.
 QByteArray StyleAttributes::fontName(Logic::LayoutHelper::Orientation orientation) const
 {
-    const QByteArray font_name(lookup(m_store, orientation,
-                                      m_style_name.toLocal8Bit(),
-                                      QByteArray("font-name")).toByteArray());
+    const QByteArray font_name(lookup(orientation, QByteArray("font-name")).toByteArray());
 
     if (font_name.isEmpty()) {
         return "Nokia Pure";
@@ -344,7 +573,7 @@ QByteArray StyleAttributes::fontName(Logic::LayoutHelper::Orientation orientatio
 //! \returns Value of "font\font-files"
 QStringList StyleAttributes::fontFiles() const
 {
-    return m_store->value("font/font-files").toStringList();
+    return value("font/font-files").toStringList();
 }
 
 
@@ -353,9 +582,7 @@ QStringList StyleAttributes::fontFiles() const
 //! @returns Value of "${style}\${orientation}\font-color".
 QByteArray StyleAttributes::fontColor(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("font-color")).toByteArray();
+    return lookup(orientation, QByteArray("font-color")).toByteArray();
 }
 
 
@@ -364,9 +591,7 @@ QByteArray StyleAttributes::fontColor(Logic::LayoutHelper::Orientation orientati
 //! @returns Value of "${style}\${orientation}\font-size".
 qreal StyleAttributes::fontSize(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("font-size")).toReal();
+    return lookup(orientation, QByteArray("font-size")).toReal();
 }
 
 
@@ -375,9 +600,7 @@ qreal StyleAttributes::fontSize(Logic::LayoutHelper::Orientation orientation) co
 //! @returns Value of "${style}\${orientation}\small-font-size".
 qreal StyleAttributes::smallFontSize(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("small-font-size")).toReal();
+    return lookup(orientation, QByteArray("small-font-size")).toReal();
 }
 
 
@@ -386,9 +609,7 @@ qreal StyleAttributes::smallFontSize(Logic::LayoutHelper::Orientation orientatio
 //! @returns Value of "${style}\${orientation}\candidates-font-size".
 qreal StyleAttributes::candidateFontSize(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("candidate-font-size")).toReal();
+    return lookup(orientation, QByteArray("candidate-font-size")).toReal();
 }
 
 
@@ -397,9 +618,7 @@ qreal StyleAttributes::candidateFontSize(Logic::LayoutHelper::Orientation orient
 //! @returns Value of "${style}\${orientation}\magnifier-font-size".
 qreal StyleAttributes::magnifierFontSize(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("magnifier-font-size")).toReal();
+    return lookup(orientation, QByteArray("magnifier-font-size")).toReal();
 }
 
 
@@ -412,9 +631,7 @@ qreal StyleAttributes::magnifierFontSize(Logic::LayoutHelper::Orientation orient
 //! @returns Value of "${style}\${orientation}\candidate-font-stretch".
 qreal StyleAttributes::candidateFontStretch(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("candidate-font-stretch")).toReal();
+    return lookup(orientation, QByteArray("candidate-font-stretch")).toReal();
 }
 
 
@@ -423,9 +640,7 @@ qreal StyleAttributes::candidateFontStretch(Logic::LayoutHelper::Orientation ori
 //! @returns Value of "${style}\${orientation}\word-ribbon-height".
 qreal StyleAttributes::wordRibbonHeight(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("word-ribbon-height")).toReal();
+    return lookup(orientation, QByteArray("word-ribbon-height")).toReal();
 }
 
 
@@ -434,9 +649,7 @@ qreal StyleAttributes::wordRibbonHeight(Logic::LayoutHelper::Orientation orienta
 //! @returns Value of "${style}\${orientation}\magnifier-key-height".
 qreal StyleAttributes::magnifierKeyHeight(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("magnifier-key-height")).toReal();
+    return lookup(orientation, QByteArray("magnifier-key-height")).toReal();
 }
 
 
@@ -445,9 +658,7 @@ qreal StyleAttributes::magnifierKeyHeight(Logic::LayoutHelper::Orientation orien
 //! @returns Value of "${style}\${orientation}\key-height".
 qreal StyleAttributes::keyHeight(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-height")).toReal();
+    return lookup(orientation, QByteArray("key-height")).toReal();
 }
 
 
@@ -456,9 +667,7 @@ qreal StyleAttributes::keyHeight(Logic::LayoutHelper::Orientation orientation) c
 //! @returns Value of "${style}\${orientation}\key-height".
 qreal StyleAttributes::keyTopRowHeight(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-top-row-height")).toReal();
+    return lookup(orientation, QByteArray("key-top-row-height")).toReal();
 }
 
 
@@ -467,9 +676,7 @@ qreal StyleAttributes::keyTopRowHeight(Logic::LayoutHelper::Orientation orientat
 //! @returns Value of "${style}\${orientation}\key-height".
 qreal StyleAttributes::keyBottomRowHeight(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-bottom-row-height")).toReal();
+    return lookup(orientation, QByteArray("key-bottom-row-height")).toReal();
 }
 
 
@@ -478,9 +685,7 @@ qreal StyleAttributes::keyBottomRowHeight(Logic::LayoutHelper::Orientation orien
 //! @returns Value of "${style}\${orientation}\magnifier-key-width".
 qreal StyleAttributes::magnifierKeyWidth(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("magnifier-key-width")).toReal();
+    return lookup(orientation, QByteArray("magnifier-key-width")).toReal();
 }
 
 
@@ -491,9 +696,7 @@ qreal StyleAttributes::magnifierKeyWidth(Logic::LayoutHelper::Orientation orient
 qreal StyleAttributes::keyWidth(Logic::LayoutHelper::Orientation orientation,
                                 KeyDescription::Width width) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-width").append(fromKeyWidth(width))).toReal();
+    return lookup(orientation, QByteArray("key-width").append(fromKeyWidth(width))).toReal();
 }
 
 
@@ -502,9 +705,7 @@ qreal StyleAttributes::keyWidth(Logic::LayoutHelper::Orientation orientation,
 //! @returns Value of "${style}\${orientation}\key-area-width".
 qreal StyleAttributes::keyAreaWidth(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-area-width")).toReal();
+    return lookup(orientation, QByteArray("key-area-width")).toReal();
 }
 
 
@@ -517,9 +718,7 @@ qreal StyleAttributes::keyAreaWidth(Logic::LayoutHelper::Orientation orientation
 //! @returns Value of "${style}\${orientation}\key-margins".
 qreal StyleAttributes::keyMargin(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-margins")).toReal();
+    return lookup(orientation, QByteArray("key-margins")).toReal();
 }
 
 //! \brief Looks up the key area paddings.
@@ -532,9 +731,7 @@ qreal StyleAttributes::keyMargin(Logic::LayoutHelper::Orientation orientation) c
 //! @returns Value of "${style}\${orientation}\key-area-paddings".
 qreal StyleAttributes::keyAreaPadding(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("key-area-paddings")).toReal();
+    return lookup(orientation, QByteArray("key-area-paddings")).toReal();
 }
 
 
@@ -546,9 +743,7 @@ qreal StyleAttributes::keyAreaPadding(Logic::LayoutHelper::Orientation orientati
 //! @returns Value of "${style}\${orientation}\vertical-offset".
 qreal StyleAttributes::verticalOffset(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("vertical-offset")).toReal();
+    return lookup(orientation, QByteArray("vertical-offset")).toReal();
 }
 
 
@@ -557,9 +752,7 @@ qreal StyleAttributes::verticalOffset(Logic::LayoutHelper::Orientation orientati
 //! @returns Value of "${style}\${orientation}\magnifier-key-label-vertical-offset".
 qreal StyleAttributes::magnifierKeyLabelVerticalOffset(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("magnifier-key-label-vertical-offset")).toReal();
+    return lookup(orientation, QByteArray("magnifier-key-label-vertical-offset")).toReal();
 }
 
 
@@ -571,9 +764,7 @@ qreal StyleAttributes::magnifierKeyLabelVerticalOffset(Logic::LayoutHelper::Orie
 //! @returns Value of "${style}\${orientation}\safety-margin".
 qreal StyleAttributes::safetyMargin(Logic::LayoutHelper::Orientation orientation) const
 {
-    return lookup(m_store, orientation,
-                  m_style_name.toLocal8Bit(),
-                  QByteArray("safety-margin")).toReal();
+    return lookup(orientation, QByteArray("safety-margin")).toReal();
 }
 
 
@@ -581,7 +772,7 @@ qreal StyleAttributes::safetyMargin(Logic::LayoutHelper::Orientation orientation
 //! @returns Value of "sound/key-press".
 QByteArray StyleAttributes::keyPressSound() const
 {
-    return m_store->value("sound/key-press").toByteArray();
+    return value("sound/key-press").toByteArray();
 }
 
 
@@ -589,7 +780,7 @@ QByteArray StyleAttributes::keyPressSound() const
 //! @returns Value of "sound/key-release".
 QByteArray StyleAttributes::keyReleaseSound() const
 {
-    return m_store->value("sound/key-release").toByteArray();
+    return value("sound/key-release").toByteArray();
 }
 
 
@@ -597,7 +788,7 @@ QByteArray StyleAttributes::keyReleaseSound() const
 //! @returns Value of "sound/layout-change".
 QByteArray StyleAttributes::layoutChangeSound() const
 {
-    return m_store->value("sound/layout-change").toByteArray();
+    return value("sound/layout-change").toByteArray();
 }
 
 
@@ -605,7 +796,7 @@ QByteArray StyleAttributes::layoutChangeSound() const
 //! @returns Value of "sound/keyboard-hide".
 QByteArray StyleAttributes::keyboardHideSound() const
 {
-    return m_store->value("sound/keyboard-hide").toByteArray();
+    return value("sound/keyboard-hide").toByteArray();
 }
 
 } // namespace MaliitKeyboard
@@ -34,23 +34,82 @@
 #define MALIIT_KEYBOARD_STYLEATTRIBUTES_H
 
 #include "models/keydescription.h"
+#include "models/key.h"
+#include "models/font.h"
+#include "models/stylebundle.h"
 #include "logic/layouthelper.h"
 
 #include <QtCore>
 
 namespace MaliitKeyboard {
 
+//! \brief The style attributes needed to convert a keyboard into a key area,
+//! resolved for one style name and orientation.
+struct StyleSnapshot
+{
+    enum {
+        WidthCount = KeyDescription::Stretched + 1,
+        IconCount = KeyDescription::CustomIcon + 1,
+        StateCount = KeyDescription::HighlightedState + 1,
+        KeyStyleCount = Key::StyleActivated + 1
+    };
+
+    Font font; //!< Font for single character labels.
+    Font small_font; //!< Font for longer labels.
+    qreal key_widths[WidthCount]; //!< Key widths, indexed by KeyDescription::Width.
+    QByteArray key_backgrounds[KeyStyleCount][StateCount]; //!< Indexed by Key::Style and KeyDescription::State.
+    QMargins key_background_borders;
+    QByteArray icons[IconCount][StateCount]; //!< Indexed by KeyDescription::Icon and KeyDescription::State.
+    QHash<QByteArray, QByteArray> custom_icons; //!< Custom icon name to icon file.
+    QByteArray key_area_background;
+    QMargins key_area_background_borders;
+    qreal key_area_width;
+    qreal key_height;
+    qreal key_top_row_height;
+    qreal key_bottom_row_height;
+    qreal key_margin;
+    qreal key_area_padding;
+    qreal vertical_offset;
+    qreal word_ribbon_height;
+
+    explicit StyleSnapshot();
+};
+
 class StyleAttributes
 {
 private:
     const QScopedPointer<const QSettings> m_store;
+    const SharedStyleBundle m_bundle;
+    const StyleBundle::Table m_bundle_table;
     QString m_style_name;
+    mutable QHash<QByteArray, QVariant> m_cache; // style independent values
+    mutable QHash<QByteArray, QVariant> m_style_cache; // values of all styles, by style name
+    mutable int m_cache_hits;
+    mutable int m_cache_misses;
+    QHash<QString, StyleSnapshot> m_snapshots[2]; // indexed by orientation
+
+    void buildSnapshots();
+    QVariant storeValue(const QString &key) const;
+    QStringList storeKeys() const;
+    QVariant value(const QByteArray &key) const;
+    QVariant lookup(Logic::LayoutHelper::Orientation orientation,
+                    const QByteArray &attribute_name) const;
 
 public:
     explicit StyleAttributes(const QSettings *store);
+    explicit StyleAttributes(const SharedStyleBundle &bundle,
+                             StyleBundle::Table table);
     virtual ~StyleAttributes();
 
     virtual void setStyleName(const QString &name);
+    QString fileName() const;
+
+    int cacheHits() const;
+    int cacheMisses() const;
+
+    const StyleSnapshot &snapshot(const QString &style_name,
+                                  Logic::LayoutHelper::Orientation orientation) const;
+
     QByteArray wordRibbonBackground() const;
     QByteArray keyAreaBackground() const;
     QByteArray magnifierKeyBackground() const;
@@ -0,0 +1,518 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "stylebundle.h"
+
+#include <cstring>
+
+namespace MaliitKeyboard {
+
+//! \class StyleBundleWriter
+//! Used by maliit-keyboard-style-compiler at build time. Style loads the
+//! resulting bundle through StyleBundle instead of parsing the INI files of a
+//! profile.
+
+//! \class StyleBundle
+//! Values are found by binary search on the sorted key tables, without
+//! parsing any text. Numbers are stored as numbers, so that converting them
+//! does not involve string parsing either.
+
+namespace {
+
+// The bundle is written and read in host byte order. The byte order marker
+// lets a reader reject a bundle produced on a machine of other endianness.
+const quint32 bundle_magic(0x42534b4d); // "MKSB"
+const quint16 bundle_version(2);
+const quint16 bundle_byte_order(0x0102);
+const int bundle_alignment(8);
+const int bundle_hash_size(20); // SHA-1
+
+enum ValueType {
+    StringValue,
+    StringListValue,
+    NumberValue
+};
+
+struct TableRef
+{
+    quint32 offset;
+    quint32 count;
+};
+
+struct Range
+{
+    quint32 first;
+    quint32 count;
+};
+
+struct StringRef
+{
+    quint32 offset;
+    quint32 length;
+};
+
+struct Header
+{
+    quint32 magic;
+    quint16 version;
+    quint16 byte_order;
+    quint32 size;
+    quint32 reserved;
+    char source_hash[bundle_hash_size];
+    TableRef strings;
+    TableRef list_items;
+    TableRef entries[StyleBundleWriter::TableCount];
+    TableRef assets;
+};
+
+struct EntryRecord
+{
+    StringRef key;
+    quint32 type;
+    quint32 reserved;
+    double number;
+    StringRef value;
+    Range list;
+};
+
+struct AssetRecord
+{
+    quint32 type;
+    quint32 reserved;
+    StringRef file_name;
+};
+
+template <typename T>
+void appendTable(QByteArray *data,
+                 const QVector<T> &table,
+                 TableRef *entry)
+{
+    while (data->size() % bundle_alignment) {
+        data->append('\0');
+    }
+
+    entry->offset = data->size();
+    entry->count = table.size();
+    data->append(reinterpret_cast<const char *>(table.constData()), table.size() * sizeof(T));
+}
+
+template <typename T>
+bool isValidTable(const TableRef &table,
+                  qint64 size)
+{
+    return ((table.offset % bundle_alignment) == 0
+            and quint64(table.offset) + quint64(table.count) * sizeof(T) <= quint64(size));
+}
+
+const Header *header(const uchar *data)
+{
+    return reinterpret_cast<const Header *>(data);
+}
+
+template <typename T>
+const T *records(const uchar *data,
+                 const TableRef &table)
+{
+    return reinterpret_cast<const T *>(data + table.offset);
+}
+
+//! \brief Returns a string of the bundle without copying it. The result must
+//! not outlive the bundle.
+QString rawString(const uchar *data,
+                  const StringRef &ref)
+{
+    const TableRef &strings(header(data)->strings);
+
+    if (ref.length == 0
+        or quint64(ref.offset) + quint64(ref.length) > strings.count) {
+        return QString();
+    }
+
+    return QString::fromRawData(records<QChar>(data, strings) + ref.offset, ref.length);
+}
+
+QString string(const uchar *data,
+               const StringRef &ref)
+{
+    const QString raw(rawString(data, ref));
+    return QString(raw.constData(), raw.size());
+}
+
+} // unnamed namespace
+
+class StyleBundleWriterPrivate
+{
+public:
+    QVector<ushort> strings;
+    QHash<QString, StringRef> interned_strings;
+    QVector<StringRef> list_items;
+    QVector<EntryRecord> entries[StyleBundleWriter::TableCount];
+    QVector<AssetRecord> assets;
+    QByteArray source_hash;
+
+    explicit StyleBundleWriterPrivate();
+
+    StringRef addString(const QString &string);
+};
+
+StyleBundleWriterPrivate::StyleBundleWriterPrivate()
+    : strings()
+    , interned_strings()
+    , list_items()
+    , assets()
+    , source_hash()
+{}
+
+StringRef StyleBundleWriterPrivate::addString(const QString &string)
+{
+    QHash<QString, StringRef>::const_iterator it(interned_strings.find(string));
+
+    if (it != interned_strings.constEnd()) {
+        return *it;
+    }
+
+    StringRef ref;
+
+    ref.offset = strings.size();
+    ref.length = string.size();
+
+    for (int index(0); index < string.size(); ++index) {
+        strings.append(string.at(index).unicode());
+    }
+
+    interned_strings.insert(string, ref);
+    return ref;
+}
+
+StyleBundleWriter::StyleBundleWriter()
+    : d_ptr(new StyleBundleWriterPrivate)
+{}
+
+StyleBundleWriter::~StyleBundleWriter()
+{}
+
+//! \brief Stores all attributes of an INI file, replacing previous ones of
+//! the same table.
+//! \param table The table the attributes are stored in.
+//! \param settings The INI file.
+void StyleBundleWriter::addTable(Table table,
+                                 const QSettings &settings)
+{
+    Q_D(StyleBundleWriter);
+
+    QVector<EntryRecord> &entries(d->entries[table]);
+    QStringList keys(settings.allKeys());
+
+    // Sorted the same way StyleBundle::value() compares keys.
+    qSort(keys);
+    entries.clear();
+
+    Q_FOREACH (const QString &key, keys) {
+        const QVariant value(settings.value(key));
+        EntryRecord record = EntryRecord();
+
+        record.key = d->addString(key);
+
+        if (value.type() == QVariant::StringList) {
+            const QStringList items(value.toStringList());
+
+            record.type = StringListValue;
+            record.list.first = d->list_items.size();
+            record.list.count = items.size();
+
+            Q_FOREACH (const QString &item, items) {
+                d->list_items.append(d->addString(item));
+            }
+        } else {
+            bool is_number(false);
+            const QString string(value.toString());
+
+            record.number = string.toDouble(&is_number);
+            record.type = (is_number ? NumberValue : StringValue);
+            record.value = d->addString(string);
+        }
+
+        entries.append(record);
+    }
+}
+
+//! \brief Adds asset files to the index of the bundle.
+//! \param type The asset type.
+//! \param file_names The file names, relative to the asset directory.
+void StyleBundleWriter::addAssets(AssetType type,
+                                  const QStringList &file_names)
+{
+    Q_D(StyleBundleWriter);
+
+    Q_FOREACH (const QString &file_name, file_names) {
+        AssetRecord record = AssetRecord();
+
+        record.type = type;
+        record.file_name = d->addString(file_name);
+        d->assets.append(record);
+    }
+}
+
+//! \brief Sets the hash of the source files, as returned by
+//! StyleBundle::hashSources().
+void StyleBundleWriter::setSourceHash(const QByteArray &source_hash)
+{
+    Q_D(StyleBundleWriter);
+    d->source_hash = source_hash.left(bundle_hash_size);
+}
+
+QByteArray StyleBundleWriter::data() const
+{
+    Q_D(const StyleBundleWriter);
+
+    Header header = Header();
+    QByteArray bundle(sizeof(Header), '\0');
+
+    appendTable(&bundle, d->strings, &header.strings);
+    appendTable(&bundle, d->list_items, &header.list_items);
+
+    for (int table(0); table < TableCount; ++table) {
+        appendTable(&bundle, d->entries[table], &header.entries[table]);
+    }
+
+    appendTable(&bundle, d->assets, &header.assets);
+
+    header.magic = bundle_magic;
+    header.version = bundle_version;
+    header.byte_order = bundle_byte_order;
+    header.size = bundle.size();
+    std::memcpy(header.source_hash, d->source_hash.constData(), d->source_hash.size());
+
+    bundle.replace(0, sizeof(Header), reinterpret_cast<const char *>(&header), sizeof(Header));
+    return bundle;
+}
+
+//! \brief Hashes the contents of the source files of a bundle.
+//!
+//! Only the contents are hashed, so that copying the files, which may not
+//! keep their modification times, does not change the hash. Missing files
+//! hash like empty ones.
+QByteArray StyleBundle::hashSources(const QStringList &file_names)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    Q_FOREACH (const QString &file_name, file_names) {
+        QFile file(file_name);
+        const QByteArray contents(file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray());
+        const quint64 size(contents.size());
+
+        hash.addData(reinterpret_cast<const char *>(&size), sizeof(size));
+        hash.addData(contents);
+    }
+
+    return hash.result();
+}
+
+//! \param file_name The bundle file, which is mapped into memory.
+StyleBundle::StyleBundle(const QString &file_name)
+    : m_file(file_name)
+    , m_buffer()
+    , m_data(0)
+    , m_size(0)
+{
+    if (not m_file.open(QIODevice::ReadOnly)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not open file:" << file_name << ", error:" << m_file.errorString();
+        return;
+    }
+
+    const uchar *data(m_file.map(0, m_file.size()));
+
+    if (not data) {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not map file:" << file_name << ", error:" << m_file.errorString();
+        return;
+    }
+
+    init(data, m_file.size());
+}
+
+//! \param data The bundle data, as returned by StyleBundleWriter::data().
+StyleBundle::StyleBundle(const QByteArray &data)
+    : m_file()
+    , m_buffer(data)
+    , m_data(0)
+    , m_size(0)
+{
+    init(reinterpret_cast<const uchar *>(m_buffer.constData()), m_buffer.size());
+}
+
+void StyleBundle::init(const uchar *data,
+                       qint64 size)
+{
+    if (not data or size < qint64(sizeof(Header))) {
+        return;
+    }
+
+    const Header *h(header(data));
+    bool valid(h->magic == bundle_magic
+               and h->version == bundle_version
+               and h->byte_order == bundle_byte_order
+               and qint64(h->size) == size
+               and isValidTable<ushort>(h->strings, size)
+               and isValidTable<StringRef>(h->list_items, size)
+               and isValidTable<AssetRecord>(h->assets, size));
+
+    for (int table(0); valid and table < StyleBundleWriter::TableCount; ++table) {
+        valid = isValidTable<EntryRecord>(h->entries[table], size);
+
+        const EntryRecord *entries(records<EntryRecord>(data, h->entries[table]));
+
+        for (quint32 index(0); valid and index < h->entries[table].count; ++index) {
+            valid = (quint64(entries[index].list.first) + quint64(entries[index].list.count)
+                     <= h->list_items.count);
+        }
+    }
+
+    if (not valid) {
+        qWarning() << __PRETTY_FUNCTION__ << "Invalid or incompatible style bundle.";
+        return;
+    }
+
+    m_data = data;
+    m_size = size;
+}
+
+bool StyleBundle::isValid() const
+{
+    return (m_data != 0);
+}
+
+//! \brief Returns the mapped file, or an empty string for in-memory bundles.
+QString StyleBundle::fileName() const
+{
+    return m_file.fileName();
+}
+
+//! \brief Returns the hash of the source files the bundle was compiled from.
+QByteArray StyleBundle::sourceHash() const
+{
+    return (isValid() ? QByteArray(header(m_data)->source_hash, bundle_hash_size)
+                      : QByteArray());
+}
+
+//! \brief Looks up a value, similar to QSettings::value().
+//! \param table The table to look in.
+//! \param key The key, including its INI file section.
+//! \returns A value. QVariant is invalid if there is no such key.
+QVariant StyleBundle::value(Table table,
+                            const QString &key) const
+{
+    if (not isValid()) {
+        return QVariant();
+    }
+
+    const TableRef &entry_table(header(m_data)->entries[table]);
+    const EntryRecord *entries(records<EntryRecord>(m_data, entry_table));
+    quint32 first(0);
+    quint32 last(entry_table.count);
+
+    while (first < last) {
+        const quint32 middle(first + (last - first) / 2);
+        const int comparison(rawString(m_data, entries[middle].key).compare(key));
+
+        if (comparison < 0) {
+            first = middle + 1;
+        } else if (comparison > 0) {
+            last = middle;
+        } else {
+            const EntryRecord &entry(entries[middle]);
+
+            switch (entry.type) {
+            case NumberValue:
+                return QVariant(entry.number);
+
+            case StringListValue: {
+                const StringRef *items(records<StringRef>(m_data, header(m_data)->list_items));
+                QStringList result;
+
+                for (quint32 index(0); index < entry.list.count; ++index) {
+                    result.append(string(m_data, items[entry.list.first + index]));
+                }
+
+                return QVariant(result);
+            }
+
+            default:
+                return QVariant(string(m_data, entry.value));
+            }
+        }
+    }
+
+    return QVariant();
+}
+
+//! \brief Returns all keys of a table, similar to QSettings::allKeys().
+QStringList StyleBundle::keys(Table table) const
+{
+    QStringList result;
+
+    if (not isValid()) {
+        return result;
+    }
+
+    const TableRef &entry_table(header(m_data)->entries[table]);
+    const EntryRecord *entries(records<EntryRecord>(m_data, entry_table));
+
+    for (quint32 index(0); index < entry_table.count; ++index) {
+        result.append(string(m_data, entries[index].key));
+    }
+
+    return result;
+}
+
+//! \brief Returns the file names of all assets of a type.
+QStringList StyleBundle::assets(AssetType type) const
+{
+    QStringList result;
+
+    if (not isValid()) {
+        return result;
+    }
+
+    const TableRef &asset_table(header(m_data)->assets);
+    const AssetRecord *assets(records<AssetRecord>(m_data, asset_table));
+
+    for (quint32 index(0); index < asset_table.count; ++index) {
+        if (assets[index].type == quint32(type)) {
+            result.append(string(m_data, assets[index].file_name));
+        }
+    }
+
+    return result;
+}
+
+} // namespace MaliitKeyboard
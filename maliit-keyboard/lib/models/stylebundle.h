@@ -0,0 +1,122 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#ifndef MALIIT_KEYBOARD_STYLEBUNDLE_H
+#define MALIIT_KEYBOARD_STYLEBUNDLE_H
+
+#include <QtCore>
+
+namespace MaliitKeyboard {
+
+class StyleBundleWriterPrivate;
+
+//! \brief Serializes a style profile into a binary style bundle.
+//!
+//! A bundle holds the attributes of main.ini and extended-keys.ini as sorted
+//! key tables with typed values, plus the file names of the image, sound and
+//! font assets of the profile.
+class StyleBundleWriter
+{
+    Q_DISABLE_COPY(StyleBundleWriter)
+    Q_DECLARE_PRIVATE(StyleBundleWriter)
+
+public:
+    enum Table {
+        MainTable,
+        ExtendedKeysTable,
+        TableCount
+    };
+
+    enum AssetType {
+        ImageAsset,
+        SoundAsset,
+        FontAsset
+    };
+
+    explicit StyleBundleWriter();
+    ~StyleBundleWriter();
+
+    void addTable(Table table,
+                  const QSettings &settings);
+    void addAssets(AssetType type,
+                   const QStringList &file_names);
+    void setSourceHash(const QByteArray &source_hash);
+    QByteArray data() const;
+
+private:
+    const QScopedPointer<StyleBundleWriterPrivate> d_ptr;
+};
+
+class StyleBundle;
+typedef QSharedPointer<const StyleBundle> SharedStyleBundle;
+
+//! \brief Read-only access to a binary style bundle.
+//!
+//! The bundle is read in place: either from a mapped file, which stays
+//! mapped for the lifetime of the StyleBundle, or from a copy of the given
+//! data. A bundle with a wrong magic, version or byte order is rejected as a
+//! whole.
+class StyleBundle
+{
+    Q_DISABLE_COPY(StyleBundle)
+
+public:
+    typedef StyleBundleWriter::Table Table;
+    typedef StyleBundleWriter::AssetType AssetType;
+
+    explicit StyleBundle(const QString &file_name);
+    explicit StyleBundle(const QByteArray &data);
+
+    static QByteArray hashSources(const QStringList &file_names);
+
+    bool isValid() const;
+    QString fileName() const;
+    QByteArray sourceHash() const;
+    QVariant value(Table table,
+                   const QString &key) const;
+    QStringList keys(Table table) const;
+    QStringList assets(AssetType type) const;
+
+private:
+    QFile m_file;
+    QByteArray m_buffer;
+    const uchar *m_data;
+    qint64 m_size;
+
+    void init(const uchar *data,
+              qint64 size);
+};
+
+} // namespace MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_STYLEBUNDLE_H
@@ -32,12 +32,15 @@
 
 #include "wordribbon.h"
 
+#include "coreutils.h"
+
 namespace MaliitKeyboard {
 
 WordRibbon::WordRibbon()
     : m_candidates()
     , m_origin()
     , m_area()
+    , m_content_id(0)
 {}
 
 bool WordRibbon::valid() const
@@ -50,6 +53,15 @@ QRect WordRibbon::rect() const
     return QRect(m_origin, m_area.size());
 }
 
+//! \brief Returns the id of candidates and area, see CoreUtils::nextContentId().
+//!
+//! Appending or clearing candidates assigns a new id, rCandidates() and
+//! rArea() drop it.
+int WordRibbon::contentId() const
+{
+    return m_content_id;
+}
+
 QPoint WordRibbon::origin() const
 {
     return m_origin;
@@ -62,6 +74,7 @@ void WordRibbon::setOrigin(const QPoint &origin)
 
 void WordRibbon::appendCandidate(const WordCandidate &candidate)
 {
+    m_content_id = CoreUtils::nextContentId();
     m_candidates.append(candidate);
 }
 
@@ -72,11 +85,13 @@ QVector<WordCandidate> WordRibbon::candidates() const
 
 QVector<WordCandidate> & WordRibbon::rCandidates()
 {
+    m_content_id = 0;
     return m_candidates;
 }
 
 void WordRibbon::clearCandidates()
 {
+    m_content_id = CoreUtils::nextContentId();
     m_candidates.clear();
 }
 
@@ -87,19 +102,25 @@ Area WordRibbon::area() const
 
 Area & WordRibbon::rArea()
 {
+    m_content_id = 0;
     return m_area;
 }
 
 void WordRibbon::setArea(const Area &area)
 {
+    m_content_id = CoreUtils::nextContentId();
     m_area = area;
 }
 
 bool operator==(const WordRibbon &lhs,
                 const WordRibbon &rhs)
 {
+    if (lhs.contentId() != 0 and rhs.contentId() != 0) {
+        return (lhs.contentId() == rhs.contentId());
+    }
+
     return (lhs.area() == rhs.area()
-            && lhs.candidates() == rhs.candidates());
+            and lhs.candidates() == rhs.candidates());
 }
 
 bool operator!=(const WordRibbon &lhs,
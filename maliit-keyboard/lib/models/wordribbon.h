@@ -47,12 +47,14 @@ private:
     QVector<WordCandidate> m_candidates;
     QPoint m_origin;
     Area m_area;
+    int m_content_id;
 
 public:
     explicit WordRibbon();
 
     bool valid() const;
     QRect rect() const;
+    int contentId() const;
 
     QPoint origin() const;
     void setOrigin(const QPoint &origin);
@@ -0,0 +1,940 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "layoutimage.h"
+
+#include <QCryptographicHash>
+#include <QDebug>
+#include <QFile>
+#include <QVector>
+
+#include <cstring>
+
+namespace MaliitKeyboard {
+
+namespace {
+
+// The image is written and read in host byte order. The byte order marker
+// lets a reader reject an image produced on a machine of other endianness.
+const quint32 image_magic(0x494c4b4d); // "MKLI"
+const quint16 image_version(2);
+const quint16 image_byte_order(0x0102);
+const int image_alignment(8);
+const int image_hash_size(20); // SHA-1
+
+enum BindingFlags {
+    BindingDead = 1 << 0,
+    BindingQuickPick = 1 << 1,
+    BindingRtl = 1 << 2,
+    BindingEnlarge = 1 << 3
+};
+
+struct Table
+{
+    quint32 offset;
+    quint32 count;
+};
+
+struct Range
+{
+    quint32 first;
+    quint32 count;
+};
+
+struct StringRef
+{
+    quint32 offset;
+    quint32 length;
+};
+
+struct Header
+{
+    quint32 magic;
+    quint16 version;
+    quint16 byte_order;
+    quint32 size;
+    quint32 reserved;
+    Table entries;
+    Table strings;
+    Table keyboards;
+    Table layouts;
+    Table sections;
+    Table rows;
+    Table elements;
+    Table bindings;
+    Table modifiers;
+    Table imports;
+};
+
+struct EntryRecord
+{
+    char source_hash[image_hash_size];
+    StringRef id;
+    quint32 keyboard;
+    quint32 reserved;
+};
+
+struct KeyboardRecord
+{
+    StringRef version;
+    StringRef title;
+    StringRef language;
+    StringRef catalog;
+    quint32 autocapitalization;
+    quint32 reserved;
+    Range layouts;
+    Range imports;
+};
+
+struct ImportRecord
+{
+    quint32 type;
+    StringRef file;
+};
+
+struct LayoutRecord
+{
+    quint16 type;
+    quint16 orientation;
+    quint32 uniform_font_size;
+    Range sections;
+};
+
+struct SectionRecord
+{
+    StringRef id;
+    StringRef style;
+    quint16 movable;
+    quint16 type;
+    Range rows;
+};
+
+struct RowRecord
+{
+    quint32 height;
+    Range elements;
+};
+
+struct ElementRecord
+{
+    quint16 type;
+    quint16 style;
+    quint16 width;
+    quint16 rtl;
+    StringRef id;
+    quint32 binding;
+    quint32 has_extended;
+    Range extended_rows;
+};
+
+struct BindingRecord
+{
+    quint16 action;
+    quint16 flags;
+    StringRef label;
+    StringRef secondary_label;
+    StringRef accents;
+    StringRef accented_labels;
+    StringRef cycle_set;
+    StringRef sequence;
+    StringRef icon;
+    Range modifiers;
+};
+
+struct ModifiersRecord
+{
+    quint32 keys;
+    quint32 binding;
+};
+
+template <typename T>
+Range reserve(QVector<T> *table,
+              int count)
+{
+    Range range;
+
+    range.first = table->size();
+    range.count = count;
+    table->resize(table->size() + count);
+
+    return range;
+}
+
+template <typename T>
+void appendTable(QByteArray *data,
+                 const QVector<T> &table,
+                 Table *entry)
+{
+    while (data->size() % image_alignment) {
+        data->append('\0');
+    }
+
+    entry->offset = data->size();
+    entry->count = table.size();
+    data->append(reinterpret_cast<const char *>(table.constData()), table.size() * sizeof(T));
+}
+
+template <typename T>
+bool isValidTable(const Table &table,
+                  qint64 size)
+{
+    return ((table.offset % image_alignment) == 0
+            and quint64(table.offset) + quint64(table.count) * sizeof(T) <= quint64(size));
+}
+
+bool isValidRange(const Range &range,
+                  const Table &table)
+{
+    return (quint64(range.first) + quint64(range.count) <= table.count);
+}
+
+} // unnamed namespace
+
+class LayoutImageWriterPrivate
+{
+public:
+    QVector<EntryRecord> entries;
+    QVector<ushort> strings;
+    QHash<QString, StringRef> interned_strings;
+    QVector<KeyboardRecord> keyboards;
+    QVector<LayoutRecord> layouts;
+    QVector<SectionRecord> sections;
+    QVector<RowRecord> rows;
+    QVector<ElementRecord> elements;
+    QVector<BindingRecord> bindings;
+    QVector<ModifiersRecord> modifiers;
+    QVector<ImportRecord> imports;
+
+    explicit LayoutImageWriterPrivate();
+
+    StringRef addString(const QString &string);
+    Range addRows(const LayoutTree &tree,
+                  const LayoutTree::Children &tree_rows);
+    Range addElements(const LayoutTree &tree,
+                      const LayoutTree::Children &tree_elements);
+    quint32 addBinding(const LayoutTree &tree,
+                       int tree_binding);
+};
+
+LayoutImageWriterPrivate::LayoutImageWriterPrivate()
+    : entries()
+    , strings()
+    , interned_strings()
+    , keyboards()
+    , layouts()
+    , sections()
+    , rows()
+    , elements()
+    , bindings()
+    , modifiers()
+    , imports()
+{}
+
+StringRef LayoutImageWriterPrivate::addString(const QString &string)
+{
+    QHash<QString, StringRef>::const_iterator it(interned_strings.find(string));
+
+    if (it != interned_strings.constEnd()) {
+        return *it;
+    }
+
+    StringRef ref;
+
+    ref.offset = strings.size();
+    ref.length = string.size();
+
+    for (int index(0); index < string.size(); ++index) {
+        strings.append(string.at(index).unicode());
+    }
+
+    interned_strings.insert(string, ref);
+    return ref;
+}
+
+// Children of a node are reserved as one block before they are filled, so
+// that they stay adjacent in their table even when they have children of
+// their own. As a side effect every child is stored after its parent.
+Range LayoutImageWriterPrivate::addRows(const LayoutTree &tree,
+                                        const LayoutTree::Children &tree_rows)
+{
+    const Range range(reserve(&rows, tree_rows.count));
+    quint32 offset(0);
+
+    for (int index(tree_rows.first); index != -1; index = tree.row(index).next) {
+        const LayoutTree::Row &tree_row(tree.row(index));
+        RowRecord record = RowRecord();
+
+        record.height = tree_row.height;
+        record.elements = addElements(tree, tree_row.elements);
+        rows[range.first + offset++] = record;
+    }
+
+    return range;
+}
+
+Range LayoutImageWriterPrivate::addElements(const LayoutTree &tree,
+                                            const LayoutTree::Children &tree_elements)
+{
+    const Range range(reserve(&elements, tree_elements.count));
+    quint32 offset(0);
+
+    for (int index(tree_elements.first); index != -1; index = tree.element(index).next) {
+        const LayoutTree::Element &tree_element(tree.element(index));
+        ElementRecord record = ElementRecord();
+
+        record.type = tree_element.type;
+
+        if (tree_element.type == LayoutTree::Element::Key) {
+            record.style = tree_element.style;
+            record.width = tree_element.width;
+            record.rtl = tree_element.rtl;
+            record.id = addString(tree.string(tree_element.id));
+            record.binding = addBinding(tree, tree_element.binding);
+
+            if (tree_element.extended) {
+                record.has_extended = 1;
+                record.extended_rows = addRows(tree, tree_element.extended_rows);
+            }
+        }
+
+        elements[range.first + offset++] = record;
+    }
+
+    return range;
+}
+
+quint32 LayoutImageWriterPrivate::addBinding(const LayoutTree &tree,
+                                             int tree_binding)
+{
+    const quint32 binding_index(reserve(&bindings, 1).first);
+    const LayoutTree::Binding &binding(tree.binding(tree_binding));
+    BindingRecord record = BindingRecord();
+    quint32 offset(0);
+
+    record.action = binding.action;
+    record.flags = ((binding.dead ? BindingDead : 0)
+                    | (binding.quick_pick ? BindingQuickPick : 0)
+                    | (binding.rtl ? BindingRtl : 0)
+                    | (binding.enlarge ? BindingEnlarge : 0));
+    record.label = addString(tree.string(binding.label));
+    record.secondary_label = addString(tree.string(binding.secondary_label));
+    record.accents = addString(tree.string(binding.accents));
+    record.accented_labels = addString(tree.string(binding.accented_labels));
+    record.cycle_set = addString(tree.string(binding.cycle_set));
+    record.sequence = addString(tree.string(binding.sequence));
+    record.icon = addString(tree.string(binding.icon));
+    record.modifiers = reserve(&modifiers, binding.modifiers.count);
+
+    for (int index(binding.modifiers.first); index != -1; index = tree.modifiers(index).next) {
+        ModifiersRecord modifiers_record = ModifiersRecord();
+
+        modifiers_record.keys = tree.modifiers(index).keys;
+        modifiers_record.binding = addBinding(tree, tree.modifiers(index).binding);
+        modifiers[record.modifiers.first + offset++] = modifiers_record;
+    }
+
+    bindings[binding_index] = record;
+    return binding_index;
+}
+
+LayoutImageWriter::LayoutImageWriter()
+    : d_ptr(new LayoutImageWriterPrivate)
+{}
+
+LayoutImageWriter::~LayoutImageWriter()
+{}
+
+void LayoutImageWriter::addKeyboard(const QString &id,
+                                    const LayoutTreePtr &tree,
+                                    const QByteArray &source_hash)
+{
+    Q_D(LayoutImageWriter);
+
+    if (id.isEmpty() or not tree) {
+        return;
+    }
+
+    const LayoutTree::Keyboard &keyboard(tree->keyboard());
+    KeyboardRecord record = KeyboardRecord();
+    EntryRecord entry = EntryRecord();
+    quint32 offset(0);
+
+    record.version = d->addString(tree->string(keyboard.version));
+    record.title = d->addString(tree->string(keyboard.title));
+    record.language = d->addString(tree->string(keyboard.language));
+    record.catalog = d->addString(tree->string(keyboard.catalog));
+    record.autocapitalization = keyboard.autocapitalization;
+
+    record.imports = reserve(&d->imports, keyboard.imports.count);
+
+    for (int index(keyboard.imports.first); index != -1; index = tree->import(index).next) {
+        ImportRecord import_record = ImportRecord();
+
+        import_record.type = tree->import(index).type;
+        import_record.file = d->addString(tree->string(tree->import(index).file));
+        d->imports[record.imports.first + offset++] = import_record;
+    }
+
+    record.layouts = reserve(&d->layouts, keyboard.layouts.count);
+    offset = 0;
+
+    for (int index(keyboard.layouts.first); index != -1; index = tree->layout(index).next) {
+        const LayoutTree::Layout &tree_layout(tree->layout(index));
+        LayoutRecord layout_record = LayoutRecord();
+        quint32 section_offset(0);
+
+        layout_record.type = tree_layout.type;
+        layout_record.orientation = tree_layout.orientation;
+        layout_record.uniform_font_size = tree_layout.uniform_font_size;
+        layout_record.sections = reserve(&d->sections, tree_layout.sections.count);
+
+        for (int section_index(tree_layout.sections.first); section_index != -1;
+             section_index = tree->section(section_index).next) {
+            const LayoutTree::Section &tree_section(tree->section(section_index));
+            SectionRecord section_record = SectionRecord();
+
+            section_record.id = d->addString(tree->string(tree_section.id));
+            section_record.style = d->addString(tree->string(tree_section.style));
+            section_record.movable = tree_section.movable;
+            section_record.type = tree_section.type;
+            section_record.rows = d->addRows(*tree, tree_section.rows);
+            d->sections[layout_record.sections.first + section_offset++] = section_record;
+        }
+
+        d->layouts[record.layouts.first + offset++] = layout_record;
+    }
+
+    std::memcpy(entry.source_hash, source_hash.constData(), qMin(source_hash.size(), image_hash_size));
+    entry.id = d->addString(id);
+    entry.keyboard = d->keyboards.size();
+
+    d->keyboards.append(record);
+    d->entries.append(entry);
+}
+
+QByteArray LayoutImageWriter::data() const
+{
+    Q_D(const LayoutImageWriter);
+
+    Header header = Header();
+    QByteArray image(sizeof(Header), '\0');
+
+    appendTable(&image, d->entries, &header.entries);
+    appendTable(&image, d->strings, &header.strings);
+    appendTable(&image, d->keyboards, &header.keyboards);
+    appendTable(&image, d->layouts, &header.layouts);
+    appendTable(&image, d->sections, &header.sections);
+    appendTable(&image, d->rows, &header.rows);
+    appendTable(&image, d->elements, &header.elements);
+    appendTable(&image, d->bindings, &header.bindings);
+    appendTable(&image, d->modifiers, &header.modifiers);
+    appendTable(&image, d->imports, &header.imports);
+
+    header.magic = image_magic;
+    header.version = image_version;
+    header.byte_order = image_byte_order;
+    header.size = image.size();
+
+    image.replace(0, sizeof(Header), reinterpret_cast<const char *>(&header), sizeof(Header));
+    return image;
+}
+
+namespace {
+
+//! \brief Rebuilds a layout tree from the records of an image.
+//!
+//! Every index read from the image is checked against its table, and child
+//! records are required to come after their parents, so a damaged image can
+//! neither make the reader access memory outside of it nor loop forever.
+class ImageReader
+{
+public:
+    explicit ImageReader(const uchar *data);
+
+    bool failed() const;
+    QString string(const StringRef &ref);
+    const KeyboardRecord *keyboardRecord(quint32 index);
+    LayoutTreePtr readKeyboard(quint32 index);
+
+private:
+    typedef int (LayoutTree::*AppendRowFunc)(int, const LayoutTree::Row &);
+
+    const uchar *m_data;
+    const Header *m_header;
+    bool m_failed;
+    QSharedPointer<LayoutTree> m_tree;
+
+    template <typename T>
+    const T *record(const Table &table,
+                    quint32 index);
+    int intern(const StringRef &ref);
+    void readRows(const Range &range,
+                  int parent,
+                  AppendRowFunc append_row);
+    void readElements(const Range &range,
+                      int row,
+                      quint32 row_index);
+    const BindingRecord *bindingRecord(quint32 index);
+    LayoutTree::Binding readBinding(const BindingRecord *binding_record);
+    void readModifiers(const BindingRecord *binding_record,
+                       quint32 index,
+                       int binding);
+    LayoutTreePtr fail();
+};
+
+ImageReader::ImageReader(const uchar *data)
+    : m_data(data)
+    , m_header(reinterpret_cast<const Header *>(data))
+    , m_failed(false)
+    , m_tree()
+{}
+
+bool ImageReader::failed() const
+{
+    return m_failed;
+}
+
+template <typename T>
+const T *ImageReader::record(const Table &table,
+                             quint32 index)
+{
+    if (index >= table.count) {
+        m_failed = true;
+        return 0;
+    }
+
+    return reinterpret_cast<const T *>(m_data + table.offset) + index;
+}
+
+QString ImageReader::string(const StringRef &ref)
+{
+    if (ref.length == 0) {
+        return QString();
+    }
+
+    if (quint64(ref.offset) + quint64(ref.length) > m_header->strings.count) {
+        m_failed = true;
+        return QString();
+    }
+
+    return QString(reinterpret_cast<const QChar *>(m_data + m_header->strings.offset) + ref.offset,
+                   ref.length);
+}
+
+int ImageReader::intern(const StringRef &ref)
+{
+    return m_tree->intern(string(ref));
+}
+
+const KeyboardRecord *ImageReader::keyboardRecord(quint32 index)
+{
+    return record<KeyboardRecord>(m_header->keyboards, index);
+}
+
+LayoutTreePtr ImageReader::fail()
+{
+    m_failed = true;
+    return LayoutTreePtr();
+}
+
+LayoutTreePtr ImageReader::readKeyboard(quint32 index)
+{
+    const KeyboardRecord *keyboard_record(record<KeyboardRecord>(m_header->keyboards, index));
+
+    if (not keyboard_record
+        or not isValidRange(keyboard_record->layouts, m_header->layouts)
+        or not isValidRange(keyboard_record->imports, m_header->imports)) {
+        return fail();
+    }
+
+    m_tree = QSharedPointer<LayoutTree>(new LayoutTree);
+
+    LayoutTree::Keyboard &keyboard(m_tree->rKeyboard());
+
+    keyboard.version = intern(keyboard_record->version);
+    keyboard.title = intern(keyboard_record->title);
+    keyboard.language = intern(keyboard_record->language);
+    keyboard.catalog = intern(keyboard_record->catalog);
+    keyboard.autocapitalization = keyboard_record->autocapitalization;
+
+    for (quint32 offset(0); offset < keyboard_record->imports.count; ++offset) {
+        const ImportRecord *import_record(record<ImportRecord>(m_header->imports,
+                                                               keyboard_record->imports.first + offset));
+        LayoutTree::Import import;
+
+        if (import_record->type > LayoutTree::Import::PhoneNumber) {
+            return fail();
+        }
+
+        import.type = static_cast<LayoutTree::Import::Type>(import_record->type);
+        import.file = intern(import_record->file);
+        m_tree->appendImport(import);
+    }
+
+    for (quint32 offset(0); offset < keyboard_record->layouts.count; ++offset) {
+        const LayoutRecord *layout_record(record<LayoutRecord>(m_header->layouts,
+                                                               keyboard_record->layouts.first + offset));
+
+        if (not isValidRange(layout_record->sections, m_header->sections)) {
+            return fail();
+        }
+
+        LayoutTree::Layout layout;
+
+        layout.type = static_cast<LayoutTree::Layout::Type>(layout_record->type);
+        layout.orientation = static_cast<LayoutTree::Layout::Orientation>(layout_record->orientation);
+        layout.uniform_font_size = layout_record->uniform_font_size;
+
+        const int tree_layout(m_tree->appendLayout(layout));
+
+        for (quint32 section_offset(0); section_offset < layout_record->sections.count; ++section_offset) {
+            const SectionRecord *section_record(record<SectionRecord>(m_header->sections,
+                                                                      layout_record->sections.first + section_offset));
+            LayoutTree::Section section;
+
+            section.id = intern(section_record->id);
+            section.style = intern(section_record->style);
+            section.movable = section_record->movable;
+            section.type = static_cast<LayoutTree::Section::Type>(section_record->type);
+
+            readRows(section_record->rows, m_tree->appendSection(tree_layout, section),
+                     &LayoutTree::appendRow);
+        }
+    }
+
+    return (m_failed ? LayoutTreePtr() : m_tree);
+}
+
+void ImageReader::readRows(const Range &range,
+                           int parent,
+                           AppendRowFunc append_row)
+{
+    if (m_failed or not isValidRange(range, m_header->rows)) {
+        m_failed = true;
+        return;
+    }
+
+    for (quint32 offset(0); offset < range.count; ++offset) {
+        const quint32 row_index(range.first + offset);
+        const RowRecord *row_record(record<RowRecord>(m_header->rows, row_index));
+        LayoutTree::Row row;
+
+        row.height = static_cast<LayoutTree::Row::Height>(row_record->height);
+        readElements(row_record->elements, ((*m_tree).*append_row)(parent, row), row_index);
+
+        if (m_failed) {
+            return;
+        }
+    }
+}
+
+void ImageReader::readElements(const Range &range,
+                               int row,
+                               quint32 row_index)
+{
+    if (m_failed or not isValidRange(range, m_header->elements)) {
+        m_failed = true;
+        return;
+    }
+
+    for (quint32 offset(0); offset < range.count; ++offset) {
+        const ElementRecord *element_record(record<ElementRecord>(m_header->elements, range.first + offset));
+        LayoutTree::Element element;
+
+        if (element_record->type == LayoutTree::Element::Spacer) {
+            element.type = LayoutTree::Element::Spacer;
+            m_tree->appendElement(row, element);
+            continue;
+        }
+
+        const BindingRecord *binding_record(bindingRecord(element_record->binding));
+
+        if (not binding_record) {
+            return;
+        }
+
+        element.style = static_cast<LayoutTree::Element::Style>(element_record->style);
+        element.width = static_cast<LayoutTree::Element::Width>(element_record->width);
+        element.rtl = element_record->rtl;
+        element.id = intern(element_record->id);
+
+        const int key(m_tree->appendElement(row, element));
+
+        readModifiers(binding_record, element_record->binding,
+                      m_tree->setKeyBinding(key, readBinding(binding_record)));
+
+        if (element_record->has_extended) {
+            // Extended rows are written after the row holding their key.
+            if (element_record->extended_rows.first <= row_index) {
+                m_failed = true;
+                return;
+            }
+
+            readRows(element_record->extended_rows, key, &LayoutTree::appendExtendedRow);
+        }
+
+        if (m_failed) {
+            return;
+        }
+    }
+}
+
+const BindingRecord *ImageReader::bindingRecord(quint32 index)
+{
+    const BindingRecord *binding_record(record<BindingRecord>(m_header->bindings, index));
+
+    if (not binding_record or not isValidRange(binding_record->modifiers, m_header->modifiers)) {
+        m_failed = true;
+        return 0;
+    }
+
+    return binding_record;
+}
+
+LayoutTree::Binding ImageReader::readBinding(const BindingRecord *binding_record)
+{
+    LayoutTree::Binding binding;
+
+    binding.action = static_cast<LayoutTree::Binding::Action>(binding_record->action);
+    binding.label = intern(binding_record->label);
+    binding.secondary_label = intern(binding_record->secondary_label);
+    binding.accents = intern(binding_record->accents);
+    binding.accented_labels = intern(binding_record->accented_labels);
+    binding.cycle_set = intern(binding_record->cycle_set);
+    binding.sequence = intern(binding_record->sequence);
+    binding.icon = intern(binding_record->icon);
+    binding.dead = binding_record->flags & BindingDead;
+    binding.quick_pick = binding_record->flags & BindingQuickPick;
+    binding.rtl = binding_record->flags & BindingRtl;
+    binding.enlarge = binding_record->flags & BindingEnlarge;
+
+    return binding;
+}
+
+void ImageReader::readModifiers(const BindingRecord *binding_record,
+                                quint32 index,
+                                int binding)
+{
+    for (quint32 offset(0); offset < binding_record->modifiers.count; ++offset) {
+        const ModifiersRecord *modifiers_record(record<ModifiersRecord>(m_header->modifiers,
+                                                                        binding_record->modifiers.first + offset));
+
+        // Modifier bindings are written after the binding they belong to.
+        if (modifiers_record->binding <= index) {
+            m_failed = true;
+            return;
+        }
+
+        const BindingRecord *modifiers_binding_record(bindingRecord(modifiers_record->binding));
+
+        if (not modifiers_binding_record) {
+            return;
+        }
+
+        LayoutTree::Modifiers modifiers;
+
+        modifiers.keys = static_cast<LayoutTree::Modifiers::Keys>(modifiers_record->keys);
+
+        const int tree_modifiers(m_tree->appendModifiers(binding, modifiers));
+
+        readModifiers(modifiers_binding_record, modifiers_record->binding,
+                      m_tree->setModifiersBinding(tree_modifiers, readBinding(modifiers_binding_record)));
+
+        if (m_failed) {
+            return;
+        }
+    }
+}
+
+} // unnamed namespace
+
+LayoutImage::LayoutImage()
+    : m_data(0)
+    , m_size(0)
+    , m_entries()
+{}
+
+LayoutImage::LayoutImage(const uchar *data,
+                         qint64 size)
+    : m_data(0)
+    , m_size(0)
+    , m_entries()
+{
+    if (not data or size < qint64(sizeof(Header))) {
+        return;
+    }
+
+    const Header *header(reinterpret_cast<const Header *>(data));
+
+    if (header->magic != image_magic
+        or header->version != image_version
+        or header->byte_order != image_byte_order
+        or qint64(header->size) != size
+        or not isValidTable<EntryRecord>(header->entries, size)
+        or not isValidTable<ushort>(header->strings, size)
+        or not isValidTable<KeyboardRecord>(header->keyboards, size)
+        or not isValidTable<LayoutRecord>(header->layouts, size)
+        or not isValidTable<SectionRecord>(header->sections, size)
+        or not isValidTable<RowRecord>(header->rows, size)
+        or not isValidTable<ElementRecord>(header->elements, size)
+        or not isValidTable<BindingRecord>(header->bindings, size)
+        or not isValidTable<ModifiersRecord>(header->modifiers, size)
+        or not isValidTable<ImportRecord>(header->imports, size)) {
+        qWarning() << __PRETTY_FUNCTION__ << "Invalid or incompatible layout image.";
+        return;
+    }
+
+    ImageReader reader(data);
+    const EntryRecord *entries(reinterpret_cast<const EntryRecord *>(data + header->entries.offset));
+
+    for (quint32 index(0); index < header->entries.count; ++index) {
+        m_entries.insert(reader.string(entries[index].id), index);
+    }
+
+    if (reader.failed()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Damaged layout image.";
+        m_entries.clear();
+        return;
+    }
+
+    m_data = data;
+    m_size = size;
+}
+
+//! \brief Hashes the contents of a layout file.
+//!
+//! Compiled entries are matched against their XML files by content, as
+//! packaging does not necessarily keep modification times. An empty array
+//! is returned if the file cannot be read.
+QByteArray LayoutImage::hashFile(const QString &file_name)
+{
+    QFile file(file_name);
+
+    if (not file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+
+    return QCryptographicHash::hash(file.readAll(), QCryptographicHash::Sha1);
+}
+
+bool LayoutImage::isValid() const
+{
+    return (m_data != 0);
+}
+
+QStringList LayoutImage::ids() const
+{
+    return m_entries.keys();
+}
+
+bool LayoutImage::contains(const QString &id) const
+{
+    return m_entries.contains(id);
+}
+
+//! \brief Returns the hash of the XML file a layout was compiled from, as
+//! returned by hashFile().
+QByteArray LayoutImage::sourceHash(const QString &id) const
+{
+    const QHash<QString, int>::const_iterator it(m_entries.find(id));
+
+    if (it == m_entries.constEnd()) {
+        return QByteArray();
+    }
+
+    const Header *header(reinterpret_cast<const Header *>(m_data));
+    const EntryRecord *entries(reinterpret_cast<const EntryRecord *>(m_data + header->entries.offset));
+
+    return QByteArray(entries[*it].source_hash, image_hash_size);
+}
+
+namespace {
+
+//! \brief Reads one string attribute of the keyboard of an entry.
+QString readKeyboardString(const uchar *data,
+                           quint32 entry_index,
+                           StringRef KeyboardRecord::*member)
+{
+    const Header *header(reinterpret_cast<const Header *>(data));
+    const EntryRecord *entries(reinterpret_cast<const EntryRecord *>(data + header->entries.offset));
+    ImageReader reader(data);
+    const KeyboardRecord *keyboard_record(reader.keyboardRecord(entries[entry_index].keyboard));
+    const QString result(keyboard_record ? reader.string(keyboard_record->*member) : QString());
+
+    return (reader.failed() ? QString() : result);
+}
+
+} // unnamed namespace
+
+bool LayoutImage::isLanguage(const QString &id) const
+{
+    return (not language(id).isEmpty());
+}
+
+QString LayoutImage::title(const QString &id) const
+{
+    const QHash<QString, int>::const_iterator it(m_entries.find(id));
+
+    return (it == m_entries.constEnd() ? QString()
+                                       : readKeyboardString(m_data, *it, &KeyboardRecord::title));
+}
+
+QString LayoutImage::language(const QString &id) const
+{
+    const QHash<QString, int>::const_iterator it(m_entries.find(id));
+
+    return (it == m_entries.constEnd() ? QString()
+                                       : readKeyboardString(m_data, *it, &KeyboardRecord::language));
+}
+
+LayoutTreePtr LayoutImage::tree(const QString &id) const
+{
+    const QHash<QString, int>::const_iterator it(m_entries.find(id));
+
+    if (it == m_entries.constEnd()) {
+        return LayoutTreePtr();
+    }
+
+    const Header *header(reinterpret_cast<const Header *>(m_data));
+    const EntryRecord *entries(reinterpret_cast<const EntryRecord *>(m_data + header->entries.offset));
+    ImageReader reader(m_data);
+    const LayoutTreePtr tree(reader.readKeyboard(entries[*it].keyboard));
+
+    if (reader.failed()) {
+        qWarning() << __PRETTY_FUNCTION__ << "Damaged entry in layout image:" << id;
+        return LayoutTreePtr();
+    }
+
+    return tree;
+}
+
+} // namespace MaliitKeyboard
@@ -0,0 +1,105 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LAYOUTIMAGE_H
+#define MALIIT_KEYBOARD_LAYOUTIMAGE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QScopedPointer>
+#include <QString>
+#include <QStringList>
+
+#include "layouttree.h"
+
+namespace MaliitKeyboard {
+
+class LayoutImageWriterPrivate;
+
+//! \brief Serializes parsed layouts into a binary layout image.
+//!
+//! An image holds any number of layouts, each registered under its id. All
+//! strings go into one interned string table, and keyboards, layouts,
+//! sections, rows, row elements, bindings, modifiers and imports are stored
+//! as flat arrays referencing each other by index.
+class LayoutImageWriter
+{
+    Q_DISABLE_COPY(LayoutImageWriter)
+    Q_DECLARE_PRIVATE(LayoutImageWriter)
+
+public:
+    explicit LayoutImageWriter();
+    ~LayoutImageWriter();
+
+    void addKeyboard(const QString &id,
+                     const LayoutTreePtr &tree,
+                     const QByteArray &source_hash);
+    QByteArray data() const;
+
+private:
+    const QScopedPointer<LayoutImageWriterPrivate> d_ptr;
+};
+
+//! \brief Read-only access to a binary layout image.
+//!
+//! Layouts are rebuilt from the image as LayoutTree instances, which do not
+//! reference the image and hold copies of its strings. The image itself is
+//! not copied, so the memory passed to the constructor has to stay valid for
+//! as long as the LayoutImage is used. An image with a wrong magic, version
+//! or byte order is rejected as a whole.
+class LayoutImage
+{
+public:
+    explicit LayoutImage();
+    explicit LayoutImage(const uchar *data,
+                         qint64 size);
+
+    static QByteArray hashFile(const QString &file_name);
+
+    bool isValid() const;
+    QStringList ids() const;
+    bool contains(const QString &id) const;
+    QByteArray sourceHash(const QString &id) const;
+    bool isLanguage(const QString &id) const;
+    QString title(const QString &id) const;
+    QString language(const QString &id) const;
+    LayoutTreePtr tree(const QString &id) const;
+
+private:
+    const uchar *m_data;
+    qint64 m_size;
+    QHash<QString, int> m_entries;
+};
+
+} // namespace MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_LAYOUTIMAGE_H
@@ -40,7 +40,7 @@ namespace MaliitKeyboard {
 
 LayoutParser::LayoutParser(QIODevice *device)
     : m_xml(device)
-    , m_keyboard()
+    , m_tree()
     , m_imports()
     , m_symviews()
     , m_numbers()
@@ -62,6 +62,24 @@ bool LayoutParser::parse()
     return not m_xml.hasError();
 }
 
+//! \brief Parses only the attributes of the root element.
+//!
+//! The resulting tree has no layouts and no imports. Reading stops at the
+//! root element, so this is cheap enough to be done for every layout file
+//! when only the title or language are needed.
+bool LayoutParser::parseHeader()
+{
+    goToRootElement();
+
+    if (not m_xml.isStartElement() || m_xml.name() != QLatin1String("keyboard")) {
+        error(QString::fromLatin1("Expected '<keyboard>', but got '<%1>'.").arg(m_xml.name().toString()));
+    } else if (not m_xml.hasError()) {
+        parseKeyboardAttributes();
+    }
+
+    return not m_xml.hasError();
+}
+
 bool LayoutParser::isLanguageFile()
 {
     goToRootElement();
@@ -103,15 +121,7 @@ void LayoutParser::error(const QString &message)
 
 void LayoutParser::parseKeyboard()
 {
-    const QXmlStreamAttributes attributes(m_xml.attributes());
-    const QString version(attributes.value(QLatin1String("version")).toString());
-    const QString actual_version(version.isEmpty() ? "1.0" : version);
-    const QString title(attributes.value(QLatin1String("title")).toString());
-    const QString language(attributes.value(QLatin1String("language")).toString());
-    const QString catalog(attributes.value(QLatin1String("catalog")).toString());
-    const bool autocapitalization(boolValue(attributes.value(QLatin1String("autocapitalization")), true));
-    m_keyboard = TagKeyboardPtr(new TagKeyboard(actual_version, title, language,
-                                                catalog, autocapitalization));
+    parseKeyboardAttributes();
 
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
@@ -124,6 +134,24 @@ void LayoutParser::parseKeyboard()
             error(QString::fromLatin1("Expected '<layout>' or '<import>', but got '<%1>'.").arg(name.toString()));
         }
     }
+
+}
+
+void LayoutParser::parseKeyboardAttributes()
+{
+    const QXmlStreamAttributes attributes(m_xml.attributes());
+    const QString version(attributes.value(QLatin1String("version")).toString());
+    const QString actual_version(version.isEmpty() ? "1.0" : version);
+
+    m_tree = QSharedPointer<LayoutTree>(new LayoutTree);
+
+    LayoutTree::Keyboard &keyboard(m_tree->rKeyboard());
+
+    keyboard.version = m_tree->intern(actual_version);
+    keyboard.title = m_tree->intern(attributes.value(QLatin1String("title")).toString());
+    keyboard.language = m_tree->intern(attributes.value(QLatin1String("language")).toString());
+    keyboard.catalog = m_tree->intern(attributes.value(QLatin1String("catalog")).toString());
+    keyboard.autocapitalization = boolValue(attributes.value(QLatin1String("autocapitalization")), true);
 }
 
 bool LayoutParser::boolValue(const QStringRef &value, bool defaultValue) {
@@ -153,6 +181,11 @@ void LayoutParser::parseImport()
         parseNewStyleImport();
     } else {
         if (validateOldStyleImport()) {
+            LayoutTree::Import import;
+
+            import.type = LayoutTree::Import::OldStyle;
+            import.file = m_tree->intern(file);
+            m_tree->appendImport(import);
             m_imports.append(file);
         }
     }
@@ -167,13 +200,13 @@ void LayoutParser::parseNewStyleImport()
 
         if (name == QLatin1String("symview")) {
             found_anything = true;
-            parseImportChild(&m_symviews);
+            parseImportChild(&m_symviews, LayoutTree::Import::Symview);
         } else if (name == QLatin1String("number")) {
             found_anything = true;
-            parseImportChild(&m_numbers);
+            parseImportChild(&m_numbers, LayoutTree::Import::Number);
         } else if (name == QLatin1String("phonenumber")) {
             found_anything = true;
-            parseImportChild(&m_phonenumbers);
+            parseImportChild(&m_phonenumbers, LayoutTree::Import::PhoneNumber);
         } else {
             error(QString::fromLatin1("Expected '<symview>' or '<number>' or '<phonenumber>', but got '<%1>'.").arg(name.toString()));
         }
@@ -183,7 +216,8 @@ void LayoutParser::parseNewStyleImport()
     }
 }
 
-void LayoutParser::parseImportChild(QStringList *target_list)
+void LayoutParser::parseImportChild(QStringList *target_list,
+                                    LayoutTree::Import::Type type)
 {
     const QXmlStreamAttributes attributes(m_xml.attributes());
     const QString src(attributes.value(QLatin1String("src")).toString());
@@ -191,6 +225,11 @@ void LayoutParser::parseImportChild(QStringList *target_list)
     if (src.isEmpty()) {
         error(QString::fromLatin1("Expected non-empty 'src' attribute in '<%1>'.").arg(m_xml.name().toString()));
     } else if (target_list) {
+        LayoutTree::Import import;
+
+        import.type = type;
+        import.file = m_tree->intern(src);
+        m_tree->appendImport(import);
         target_list->append(src);
     }
 
@@ -242,11 +281,13 @@ void LayoutParser::parseLayout()
     static const QStringList orientationValues(QString::fromLatin1("landscape,portrait").split(','));
 
     const QXmlStreamAttributes attributes(m_xml.attributes());
-    const TagLayout::LayoutType type(enumValue("type", typeValues, TagLayout::General));
-    const TagLayout::LayoutOrientation orientation(enumValue("orientation", orientationValues, TagLayout::Landscape));
-    const bool uniform_font_size(boolValue(attributes.value(QLatin1String("uniform-font-size")), false));
-    TagLayoutPtr new_layout(TagLayoutPtr(new TagLayout(type, orientation, uniform_font_size)));
-    m_keyboard->appendLayout(new_layout);
+    LayoutTree::Layout layout;
+
+    layout.type = enumValue("type", typeValues, LayoutTree::Layout::General);
+    layout.orientation = enumValue("orientation", orientationValues, LayoutTree::Layout::Landscape);
+    layout.uniform_font_size = boolValue(attributes.value(QLatin1String("uniform-font-size")), false);
+
+    const int new_layout(m_tree->appendLayout(layout));
 
     bool found_section(false);
 
@@ -290,24 +331,26 @@ E LayoutParser::enumValue(const char * const attribute, const QStringList &value
     return static_cast<E>(index);
 }
 
-void LayoutParser::parseSection(const TagLayoutPtr &layout)
+void LayoutParser::parseSection(int layout)
 {
     static const QStringList typeValues(QString::fromLatin1("sloppy,non-sloppy").split(','));
 
     const QXmlStreamAttributes attributes(m_xml.attributes());
     const QString id(attributes.value(QLatin1String("id")).toString());
-    const bool movable(boolValue(attributes.value(QLatin1String("movable")), true));
-    const TagSection::SectionType type(enumValue("type", typeValues, TagSection::Sloppy));
-    const QString style(attributes.value(QLatin1String("style")).toString());
+    LayoutTree::Section section;
+
+    section.movable = boolValue(attributes.value(QLatin1String("movable")), true);
+    section.type = enumValue("type", typeValues, LayoutTree::Section::Sloppy);
+    section.style = m_tree->intern(attributes.value(QLatin1String("style")).toString());
 
     if (id.isEmpty()) {
         error("Expected non-empty 'id' attribute in '<section>'.");
         return;
     }
 
+    section.id = m_tree->intern(id);
 
-    TagSectionPtr new_section(new TagSection(id, movable, type, style));
-    layout->appendSection(new_section);
+    const int new_section(m_tree->appendSection(layout, section));
 
     bool found_row(false);
 
@@ -315,7 +358,7 @@ void LayoutParser::parseSection(const TagLayoutPtr &layout)
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("row")) {
-            parseRow(new_section);
+            parseRow(m_tree->appendRow(new_section, parseRowAttributes()));
             found_row = true;
         } else {
             error(QString::fromLatin1("Expected '<row>', but got '<%1>'.").arg(name.toString()));
@@ -328,53 +371,59 @@ void LayoutParser::parseSection(const TagLayoutPtr &layout)
 
 }
 
-void LayoutParser::parseRow(const TagRowContainerPtr &row_container)
+LayoutTree::Row LayoutParser::parseRowAttributes()
 {
     static const QStringList heightValues(QString::fromLatin1("small,medium,large,x-large,xx-large").split(','));
 
-    const TagRow::Height height(enumValue("height", heightValues, TagRow::Medium));
-    TagRowPtr new_row(new TagRow(height));
+    LayoutTree::Row row;
+
+    row.height = enumValue("height", heightValues, LayoutTree::Row::Medium);
 
-    row_container->appendRow (new_row);
+    return row;
+}
 
+void LayoutParser::parseRow(int row)
+{
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("key")) {
-            parseKey(new_row);
+            parseKey(row);
         } else if (name == QLatin1String("spacer")) {
-            parseSpacer(new_row);
+            parseSpacer(row);
         } else {
             error(QString::fromLatin1("Expected '<key>' or '<spacer>', but got '<%1>'.").arg(name.toString()));
         }
     }
 }
 
-void LayoutParser::parseKey(const TagRowPtr &row)
+void LayoutParser::parseKey(int row)
 {
     static const QStringList styleValues(QString::fromLatin1("normal,special,deadkey,digits,activated").split(','));
     static const QStringList widthValues(QString::fromLatin1("xx-small,x-small,small,medium,large,x-large,xx-large,stretched").split(','));
 
     const QXmlStreamAttributes attributes(m_xml.attributes());
-    const TagKey::Style style(enumValue("style", styleValues, TagKey::Normal));
-    const TagKey::Width width(enumValue("width", widthValues, TagKey::Medium));
-    const bool rtl(boolValue(attributes.value(QLatin1String("rtl")), false));
-    const QString id(attributes.value(QLatin1String("id")).toString());
-    TagKeyPtr new_key(new TagKey(style, width, rtl, id));
+    LayoutTree::Element key;
 
-    row->appendElement(new_key);
+    key.type = LayoutTree::Element::Key;
+    key.style = enumValue("style", styleValues, LayoutTree::Element::Normal);
+    key.width = enumValue("width", widthValues, LayoutTree::Element::Medium);
+    key.rtl = boolValue(attributes.value(QLatin1String("rtl")), false);
+    key.id = m_tree->intern(attributes.value(QLatin1String("id")).toString());
+
+    const int new_key(m_tree->appendElement(row, key));
 
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("binding")) {
-            if (not new_key->binding()) {
-                parseBinding(new_key);
+            if (m_tree->element(new_key).binding == -1) {
+                parseBinding(m_tree->setKeyBinding(new_key, parseBindingAttributes()));
             } else {
                 error(QString::fromLatin1("Expected only one '<binding>', but got another one."));
             }
         } else if (name == QLatin1String("extended")) {
-            if (not new_key->extended()) {
+            if (not m_tree->element(new_key).extended) {
                 parseExtended(new_key);
             } else {
                 error(QString::fromLatin1("Expected only one '<extended>', but got another one."));
@@ -384,12 +433,12 @@ void LayoutParser::parseKey(const TagRowPtr &row)
         }
     }
 
-    if (not new_key->binding()) {
+    if (m_tree->element(new_key).binding == -1) {
         error(QString::fromLatin1("Expected exactly one '<binding>' but got none."));
     }
 }
 
-void LayoutParser::parseBinding(const TagBindingContainerPtr &binding_container)
+LayoutTree::Binding LayoutParser::parseBindingAttributes()
 {
     static const QStringList actionValues(QString::fromLatin1(
         "insert,shift,backspace,space,cycle,layout-menu,sym,return,commit,"
@@ -400,51 +449,53 @@ void LayoutParser::parseBinding(const TagBindingContainerPtr &binding_container)
     Q_ASSERT(actionValues.count() == Key::NumActions);
 
     const QXmlStreamAttributes attributes(m_xml.attributes());
-    const TagBinding::Action action(enumValue("action", actionValues, TagBinding::Insert));
-    const QString label(attributes.value(QLatin1String("label")).toString());
-    const QString secondary_label(attributes.value(QLatin1String("secondary_label")).toString());
-    const QString accents(attributes.value(QLatin1String("accents")).toString());
-    const QString accented_labels(attributes.value(QLatin1String("accented_labels")).toString());
-    const QString cycleset(attributes.value(QLatin1String("cycleset")).toString());
-    const QString sequence(attributes.value(QLatin1String("sequence")).toString());
-    const QString icon(attributes.value(QLatin1String("icon")).toString());
-    const bool dead(boolValue(attributes.value(QLatin1String("dead")), false));
-    const bool quick_pick(boolValue(attributes.value(QLatin1String("quick_pick")), false));
-    const bool rtl(boolValue(attributes.value(QLatin1String("rtl")), false));
-    const bool enlarge(boolValue(attributes.value(QLatin1String("enlarge")), false));
-    TagBindingPtr new_binding(new TagBinding(action, label, secondary_label, accents,
-                                             accented_labels, cycleset, sequence, icon,
-                                             dead, quick_pick, rtl, enlarge));
-
-    binding_container->setBinding(new_binding);
+    LayoutTree::Binding binding;
+
+    binding.action = enumValue("action", actionValues, LayoutTree::Binding::Insert);
+    binding.label = m_tree->intern(attributes.value(QLatin1String("label")).toString());
+    binding.secondary_label = m_tree->intern(attributes.value(QLatin1String("secondary_label")).toString());
+    binding.accents = m_tree->intern(attributes.value(QLatin1String("accents")).toString());
+    binding.accented_labels = m_tree->intern(attributes.value(QLatin1String("accented_labels")).toString());
+    binding.cycle_set = m_tree->intern(attributes.value(QLatin1String("cycleset")).toString());
+    binding.sequence = m_tree->intern(attributes.value(QLatin1String("sequence")).toString());
+    binding.icon = m_tree->intern(attributes.value(QLatin1String("icon")).toString());
+    binding.dead = boolValue(attributes.value(QLatin1String("dead")), false);
+    binding.quick_pick = boolValue(attributes.value(QLatin1String("quick_pick")), false);
+    binding.rtl = boolValue(attributes.value(QLatin1String("rtl")), false);
+    binding.enlarge = boolValue(attributes.value(QLatin1String("enlarge")), false);
+
+    return binding;
+}
 
+void LayoutParser::parseBinding(int binding)
+{
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("modifiers")) {
-            parseModifiers(new_binding);
+            parseModifiers(binding);
         } else {
             error(QString::fromLatin1("Expected '<modifiers>', but got '<%1>'.").arg(name.toString()));
         }
     }
 }
 
-void LayoutParser::parseModifiers(const TagBindingPtr &binding)
+void LayoutParser::parseModifiers(int binding)
 {
     static const QStringList keys_values(QString::fromLatin1("alt,shift,altshift").split(','));
 
-    const QXmlStreamAttributes attributes(m_xml.attributes());
-    const TagModifiers::Keys keys(enumValue("keys", keys_values, TagModifiers::Shift));
-    TagModifiersPtr new_modifiers(new TagModifiers(keys));
+    LayoutTree::Modifiers modifiers;
+
+    modifiers.keys = enumValue("keys", keys_values, LayoutTree::Modifiers::Shift);
 
-    binding->appendModifiers(new_modifiers);
+    const int new_modifiers(m_tree->appendModifiers(binding, modifiers));
 
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("binding")) {
-            if (not new_modifiers->binding()) {
-                parseBinding(new_modifiers);
+            if (m_tree->modifiers(new_modifiers).binding == -1) {
+                parseBinding(m_tree->setModifiersBinding(new_modifiers, parseBindingAttributes()));
             } else {
                 error(QString::fromLatin1("Expected only one '<binding>', but got another one."));
             }
@@ -453,23 +504,20 @@ void LayoutParser::parseModifiers(const TagBindingPtr &binding)
         }
     }
 
-    if (not new_modifiers->binding()) {
+    if (m_tree->modifiers(new_modifiers).binding == -1) {
         error(QString::fromLatin1("Expected exactly one '<binding>', but got none."));
     }
 }
 
-void LayoutParser::parseExtended(const TagKeyPtr &key)
+void LayoutParser::parseExtended(int key)
 {
     bool found_row(false);
-    TagExtendedPtr new_extended(new TagExtended);
-
-    key->setExtended(new_extended);
 
     while (m_xml.readNextStartElement()) {
         const QStringRef name(m_xml.name());
 
         if (name == QLatin1String("row")) {
-            parseRow(new_extended);
+            parseRow(m_tree->appendExtendedRow(key, parseRowAttributes()));
             found_row = true;
         } else {
             error(QString::fromLatin1("Expected '<row>', but got '<%1>'.").arg(name.toString()));
@@ -481,9 +529,12 @@ void LayoutParser::parseExtended(const TagKeyPtr &key)
     }
 }
 
-void LayoutParser::parseSpacer(const TagRowPtr &row)
+void LayoutParser::parseSpacer(int row)
 {
-    row->appendElement(TagSpacerPtr(new TagSpacer));
+    LayoutTree::Element spacer;
+
+    spacer.type = LayoutTree::Element::Spacer;
+    m_tree->appendElement(row, spacer);
     m_xml.skipCurrentElement();
 }
 
@@ -499,9 +550,9 @@ const QString LayoutParser::errorString() const
     return m_xml.errorString();
 }
 
-const TagKeyboardPtr LayoutParser::keyboard() const
+const LayoutTreePtr LayoutParser::tree() const
 {
-    return m_keyboard;
+    return m_tree;
 }
 
 const QStringList LayoutParser::imports() const
@@ -37,20 +37,7 @@
 #include <QXmlStreamReader>
 #include <QStringList>
 
-#include "alltagtypes.h"
-
-#include "tagbindingcontainer.h"
-#include "tagbinding.h"
-#include "tagextended.h"
-#include "tagkeyboard.h"
-#include "tagkey.h"
-#include "taglayout.h"
-#include "tagmodifiers.h"
-#include "tagrowcontainer.h"
-#include "tagrowelement.h"
-#include "tagrow.h"
-#include "tagsection.h"
-#include "tagspacer.h"
+#include "layouttree.h"
 
 namespace MaliitKeyboard {
 
@@ -60,11 +47,12 @@ public:
     explicit LayoutParser(QIODevice *device);
 
     bool parse();
+    bool parseHeader();
     bool isLanguageFile();
 
     const QString errorString() const;
 
-    const TagKeyboardPtr keyboard() const;
+    const LayoutTreePtr tree() const;
     const QStringList imports() const;
     const QStringList symviews() const;
     const QStringList numbers() const;
@@ -72,25 +60,29 @@ public:
 
 private:
     QXmlStreamReader m_xml;
-    TagKeyboardPtr m_keyboard;
+    QSharedPointer<LayoutTree> m_tree;
     QStringList m_imports;
     QStringList m_symviews;
     QStringList m_numbers;
     QStringList m_phonenumbers;
 
     void parseKeyboard();
+    void parseKeyboardAttributes();
     void parseImport();
     void parseNewStyleImport();
-    void parseImportChild(QStringList *target_list);
+    void parseImportChild(QStringList *target_list,
+                          LayoutTree::Import::Type type);
     bool validateOldStyleImport();
     void parseLayout();
-    void parseSection(const TagLayoutPtr &layout);
-    void parseRow(const TagRowContainerPtr &row_container);
-    void parseKey(const TagRowPtr &row);
-    void parseBinding(const TagBindingContainerPtr &binding_container);
-    void parseModifiers(const TagBindingPtr &binding);
-    void parseExtended(const TagKeyPtr &key);
-    void parseSpacer(const TagRowPtr &row);
+    void parseSection(int layout);
+    LayoutTree::Row parseRowAttributes();
+    void parseRow(int row);
+    void parseKey(int row);
+    LayoutTree::Binding parseBindingAttributes();
+    void parseBinding(int binding);
+    void parseModifiers(int binding);
+    void parseExtended(int key);
+    void parseSpacer(int row);
     void goToRootElement();
     void readToEnd();
 
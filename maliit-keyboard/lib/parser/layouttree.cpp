@@ -0,0 +1,263 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "layouttree.h"
+
+namespace MaliitKeyboard {
+
+namespace {
+
+//! \brief Appends a record to a table and links it as last child.
+//!
+//! \a children must not live in \a table, as appending may move the table.
+template <typename T>
+int appendChild(QVector<T> *table,
+                LayoutTree::Children *children,
+                const T &record)
+{
+    const int index(table->size());
+
+    table->append(record);
+    (*table)[index].next = -1;
+
+    if (children->count == 0) {
+        children->first = index;
+    } else {
+        (*table)[children->last].next = index;
+    }
+
+    children->last = index;
+    ++children->count;
+
+    return index;
+}
+
+} // unnamed namespace
+
+LayoutTree::LayoutTree()
+    : m_strings()
+    , m_interned_strings()
+    , m_keyboard()
+    , m_imports()
+    , m_layouts()
+    , m_sections()
+    , m_rows()
+    , m_elements()
+    , m_bindings()
+    , m_modifiers()
+{
+    m_strings.append(QString());
+}
+
+//! \brief Returns the index of \a string in the string table.
+//!
+//! Equal strings are stored only once, and share their index.
+int LayoutTree::intern(const QString &string)
+{
+    if (string.isEmpty()) {
+        return 0;
+    }
+
+    const QHash<QString, int>::const_iterator it(m_interned_strings.find(string));
+
+    if (it != m_interned_strings.constEnd()) {
+        return *it;
+    }
+
+    const int index(m_strings.size());
+
+    m_strings.append(string);
+    m_interned_strings.insert(string, index);
+
+    return index;
+}
+
+const QString &LayoutTree::string(int index) const
+{
+    return m_strings.at(index);
+}
+
+const LayoutTree::Keyboard &LayoutTree::keyboard() const
+{
+    return m_keyboard;
+}
+
+LayoutTree::Keyboard &LayoutTree::rKeyboard()
+{
+    return m_keyboard;
+}
+
+const LayoutTree::Import &LayoutTree::import(int index) const
+{
+    return m_imports.at(index);
+}
+
+const LayoutTree::Layout &LayoutTree::layout(int index) const
+{
+    return m_layouts.at(index);
+}
+
+const LayoutTree::Section &LayoutTree::section(int index) const
+{
+    return m_sections.at(index);
+}
+
+const LayoutTree::Row &LayoutTree::row(int index) const
+{
+    return m_rows.at(index);
+}
+
+const LayoutTree::Element &LayoutTree::element(int index) const
+{
+    return m_elements.at(index);
+}
+
+const LayoutTree::Binding &LayoutTree::binding(int index) const
+{
+    return m_bindings.at(index);
+}
+
+const LayoutTree::Modifiers &LayoutTree::modifiers(int index) const
+{
+    return m_modifiers.at(index);
+}
+
+int LayoutTree::appendImport(const Import &import)
+{
+    return appendChild(&m_imports, &m_keyboard.imports, import);
+}
+
+int LayoutTree::appendLayout(const Layout &layout)
+{
+    return appendChild(&m_layouts, &m_keyboard.layouts, layout);
+}
+
+int LayoutTree::appendSection(int layout,
+                              const Section &section)
+{
+    return appendChild(&m_sections, &m_layouts[layout].sections, section);
+}
+
+int LayoutTree::appendRow(int section,
+                          const Row &row)
+{
+    return appendChild(&m_rows, &m_sections[section].rows, row);
+}
+
+int LayoutTree::appendExtendedRow(int element,
+                                  const Row &row)
+{
+    m_elements[element].extended = true;
+
+    return appendChild(&m_rows, &m_elements[element].extended_rows, row);
+}
+
+int LayoutTree::appendElement(int row,
+                              const Element &element)
+{
+    return appendChild(&m_elements, &m_rows[row].elements, element);
+}
+
+int LayoutTree::setKeyBinding(int element,
+                              const Binding &binding)
+{
+    const int index(m_bindings.size());
+
+    m_bindings.append(binding);
+    m_elements[element].binding = index;
+
+    return index;
+}
+
+int LayoutTree::appendModifiers(int binding,
+                                const Modifiers &modifiers)
+{
+    return appendChild(&m_modifiers, &m_bindings[binding].modifiers, modifiers);
+}
+
+int LayoutTree::setModifiersBinding(int modifiers,
+                                    const Binding &binding)
+{
+    const int index(m_bindings.size());
+
+    m_bindings.append(binding);
+    m_modifiers[modifiers].binding = index;
+
+    return index;
+}
+
+//! \brief Returns the files of all imports of the given type, in document order.
+QStringList LayoutTree::imports(Import::Type type) const
+{
+    QStringList files;
+
+    for (int index(m_keyboard.imports.first); index != -1; index = m_imports.at(index).next) {
+        if (m_imports.at(index).type == type) {
+            files.append(m_strings.at(m_imports.at(index).file));
+        }
+    }
+
+    return files;
+}
+
+//! \brief Returns the index of the section at \a position in a layout, or -1.
+int LayoutTree::sectionAt(int layout,
+                          int position) const
+{
+    int index(m_layouts.at(layout).sections.first);
+
+    for (; index != -1 and position > 0; --position) {
+        index = m_sections.at(index).next;
+    }
+
+    return index;
+}
+
+//! \brief Returns the binding used when Shift is active.
+//!
+//! Falls back to \a binding itself if it has no Shift modifier.
+int LayoutTree::shiftedBinding(int binding) const
+{
+    int shifted(binding);
+
+    for (int index(m_bindings.at(binding).modifiers.first); index != -1; index = m_modifiers.at(index).next) {
+        const Modifiers &record(m_modifiers.at(index));
+
+        if (record.keys == Modifiers::Shift and record.binding != -1) {
+            shifted = record.binding;
+        }
+    }
+
+    return shifted;
+}
+
+} // namespace MaliitKeyboard
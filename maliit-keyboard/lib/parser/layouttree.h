@@ -0,0 +1,367 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef MALIIT_KEYBOARD_LAYOUTTREE_H
+#define MALIIT_KEYBOARD_LAYOUTTREE_H
+
+#include <QHash>
+#include <QSharedPointer>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+namespace MaliitKeyboard {
+
+class LayoutTree;
+typedef QSharedPointer<const LayoutTree> LayoutTreePtr;
+
+//! \brief A parsed layout, stored as flat tables.
+//!
+//! Every kind of node has a table of its own, and nodes refer to each other
+//! by their index in these tables: a parent knows its first and last child,
+//! and every child knows its next sibling. All strings are interned in one
+//! string table and referenced by index, with index 0 being the empty string.
+//! Nodes are not allocated one by one, and a string used by many keys is
+//! stored once. The tables still grow as nodes are appended, and every
+//! distinct string is a QString of its own.
+class LayoutTree
+{
+public:
+    //! \brief Children of a node, linked through their next members.
+    struct Children
+    {
+        int first;
+        int last;
+        int count;
+
+        Children()
+            : first(-1)
+            , last(-1)
+            , count(0)
+        {}
+    };
+
+    struct Import
+    {
+        enum Type {
+            OldStyle,
+            Symview,
+            Number,
+            PhoneNumber
+        };
+
+        Type type;
+        int file;
+        int next;
+
+        Import()
+            : type(OldStyle)
+            , file(0)
+            , next(-1)
+        {}
+    };
+
+    struct Keyboard
+    {
+        int version;
+        int title;
+        int language;
+        int catalog;
+        bool autocapitalization;
+        Children layouts;
+        Children imports;
+
+        Keyboard()
+            : version(0)
+            , title(0)
+            , language(0)
+            , catalog(0)
+            , autocapitalization(true)
+            , layouts()
+            , imports()
+        {}
+    };
+
+    struct Layout
+    {
+        enum Type {
+            General,
+            Url,
+            Email,
+            Number,
+            PhoneNumber,
+            Common
+        };
+
+        enum Orientation {
+            Landscape,
+            Portrait
+        };
+
+        Type type;
+        Orientation orientation;
+        bool uniform_font_size;
+        Children sections;
+        int next;
+
+        Layout()
+            : type(General)
+            , orientation(Landscape)
+            , uniform_font_size(false)
+            , sections()
+            , next(-1)
+        {}
+    };
+
+    struct Section
+    {
+        enum Type {
+            Sloppy,
+            Nonsloppy
+        };
+
+        int id;
+        int style;
+        bool movable;
+        Type type;
+        Children rows;
+        int next;
+
+        Section()
+            : id(0)
+            , style(0)
+            , movable(true)
+            , type(Sloppy)
+            , rows()
+            , next(-1)
+        {}
+    };
+
+    struct Row
+    {
+        enum Height {
+            Small,
+            Medium,
+            Large,
+            XLarge,
+            XXLarge
+        };
+
+        Height height;
+        Children elements;
+        int next;
+
+        Row()
+            : height(Medium)
+            , elements()
+            , next(-1)
+        {}
+    };
+
+    //! \brief A key or a spacer. Only keys use the members after type.
+    struct Element
+    {
+        enum Type {
+            Key,
+            Spacer
+        };
+
+        enum Style {
+            Normal,
+            Special,
+            DeadKey,
+            Digits,
+            Activated
+        };
+
+        enum Width {
+            XXSmall,
+            XSmall,
+            Small,
+            Medium,
+            Large,
+            XLarge,
+            XXLarge,
+            Stretched
+        };
+
+        Type type;
+        Style style;
+        Width width;
+        bool rtl;
+        int id;
+        int binding;
+        bool extended;
+        Children extended_rows;
+        int next;
+
+        Element()
+            : type(Key)
+            , style(Normal)
+            , width(Medium)
+            , rtl(false)
+            , id(0)
+            , binding(-1)
+            , extended(false)
+            , extended_rows()
+            , next(-1)
+        {}
+    };
+
+    struct Binding
+    {
+        enum Action {
+            Insert,
+            Shift,
+            Backspace,
+            Space,
+            Cycle,
+            LayoutMenu,
+            Sym,
+            Return,
+            Commit,
+            DecimalSeparator,
+            PlusMinusToggle,
+            Switch,
+            OnOffToggle,
+            Compose,
+            Left,
+            Up,
+            Right,
+            Down,
+            Close,
+            Command
+        };
+
+        Action action;
+        int label;
+        int secondary_label;
+        int accents;
+        int accented_labels;
+        int cycle_set;
+        int sequence;
+        int icon;
+        bool dead;
+        bool quick_pick;
+        bool rtl;
+        bool enlarge;
+        Children modifiers;
+
+        Binding()
+            : action(Insert)
+            , label(0)
+            , secondary_label(0)
+            , accents(0)
+            , accented_labels(0)
+            , cycle_set(0)
+            , sequence(0)
+            , icon(0)
+            , dead(false)
+            , quick_pick(false)
+            , rtl(false)
+            , enlarge(false)
+            , modifiers()
+        {}
+    };
+
+    struct Modifiers
+    {
+        enum Keys {
+            Alt,
+            Shift,
+            AltShift
+        };
+
+        Keys keys;
+        int binding;
+        int next;
+
+        Modifiers()
+            : keys(Shift)
+            , binding(-1)
+            , next(-1)
+        {}
+    };
+
+    explicit LayoutTree();
+
+    int intern(const QString &string);
+    const QString &string(int index) const;
+
+    const Keyboard &keyboard() const;
+    Keyboard &rKeyboard();
+    const Import &import(int index) const;
+    const Layout &layout(int index) const;
+    const Section &section(int index) const;
+    const Row &row(int index) const;
+    const Element &element(int index) const;
+    const Binding &binding(int index) const;
+    const Modifiers &modifiers(int index) const;
+
+    int appendImport(const Import &import);
+    int appendLayout(const Layout &layout);
+    int appendSection(int layout,
+                      const Section &section);
+    int appendRow(int section,
+                  const Row &row);
+    int appendExtendedRow(int element,
+                          const Row &row);
+    int appendElement(int row,
+                      const Element &element);
+    int setKeyBinding(int element,
+                      const Binding &binding);
+    int appendModifiers(int binding,
+                        const Modifiers &modifiers);
+    int setModifiersBinding(int modifiers,
+                            const Binding &binding);
+
+    QStringList imports(Import::Type type) const;
+    int sectionAt(int layout,
+                  int position) const;
+    int shiftedBinding(int binding) const;
+
+private:
+    QVector<QString> m_strings;
+    QHash<QString, int> m_interned_strings;
+    Keyboard m_keyboard;
+    QVector<Import> m_imports;
+    QVector<Layout> m_layouts;
+    QVector<Section> m_sections;
+    QVector<Row> m_rows;
+    QVector<Element> m_elements;
+    QVector<Binding> m_bindings;
+    QVector<Modifiers> m_modifiers;
+};
+
+} // namespace MaliitKeyboard
+
+#endif // MALIIT_KEYBOARD_LAYOUTTREE_H
@@ -1,83 +0,0 @@
-/*
- * This file is part of Maliit Plugins
- *
- * Copyright (C) 2011 Nokia Corporation and/or its subsidiary(-ies). All rights reserved.
- * Copyright (C) 2012-2013 Canonical Ltd
- *
- * Contact: Mohammad Anwari <Mohammad.Anwari@nokia.com>
- *
- * Redistribution and use in source and binary forms, with or without modification,
- * are permitted provided that the following conditions are met:
- *
- * Redistributions of source code must retain the above copyright notice, this list
- * of conditions and the following disclaimer.
- * Redistributions in binary form must reproduce the above copyright notice, this list
- * of conditions and the following disclaimer in the documentation and/or other materials
- * provided with the distribution.
- * Neither the name of Nokia Corporation nor the names of its contributors may be
- * used to endorse or promote products derived from this software without specific
- * prior written permission.
- *
- * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
- * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
- * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
- * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
- * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
- * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
- * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
- * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- *
- */
-
-#include "tagkey.h"
-
-namespace MaliitKeyboard {
-
-TagKey::TagKey(Style style,
-               Width width,
-               bool rtl,
-               const QString &id)
-    : TagRowElement(Key)
-    , TagBindingContainer()
-    , m_style(style)
-    , m_width(width)
-    , m_rtl(rtl)
-    , m_id(id)
-    , m_extended()
-{}
-
-TagKey::~TagKey()
-{}
-
-TagKey::Style TagKey::style() const
-{
-    return m_style;
-}
-
-TagKey::Width TagKey::width() const
-{
-    return m_width;
-}
-
-bool TagKey::rtl() const
-{
-    return m_rtl;
-}
-
-const QString TagKey::id() const
-{
-    return m_id;
-}
-
-const TagExtendedPtr TagKey::extended() const
-{
-    return m_extended;
-}
-
-void TagKey::setExtended(const TagExtendedPtr &extended)
-{
-    m_extended = extended;
-}
-
-} // namespace MaliitKeyboard
@@ -4,6 +4,16 @@ SUBDIRS = \
     lib \
     view \
     plugin \
+
+!disable-compiled-layouts {
+    SUBDIRS += layout-compiler
+}
+
+!disable-compiled-styles {
+    SUBDIRS += style-compiler
+}
+
+SUBDIRS += \
     data \
     qml \
     benchmark \
@@ -0,0 +1,283 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "fontpreloader.h"
+
+#include <QFont>
+#include <QFontDatabase>
+#include <QGlyphRun>
+#include <QRawFont>
+#include <QTextLayout>
+
+namespace MaliitKeyboard {
+
+//! \class FontPreloader
+//! Reading font files otherwise happens on the GUI thread. The worker only
+//! reads the files; the font data is then registered with QFontDatabase on
+//! the GUI thread, from memory, as font registration is not thread-safe.
+//! warmUp() then shapes and rasterizes the labels of the active layout with
+//! the registered fonts, one font per event loop iteration, so that the
+//! font engines and their glyph caches are set up before the keyboard is
+//! first shown.
+
+namespace {
+
+//! \brief Forwards results of the worker to the GUI thread. Shared between
+//! FontPreloader and its workers, so that a worker never emits on a
+//! destroyed object.
+class FontLoaderRelay
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+    Q_SIGNAL void fontLoaded(int generation,
+                             const QString &font_file,
+                             const QByteArray &data);
+};
+
+class FontLoader
+    : public QRunnable
+{
+public:
+    explicit FontLoader(const QSharedPointer<FontLoaderRelay> &relay,
+                        int generation,
+                        const QStringList &font_files)
+        : m_relay(relay)
+        , m_generation(generation)
+        , m_font_files(font_files)
+    {}
+
+    virtual void run()
+    {
+        Q_FOREACH (const QString &font_file, m_font_files) {
+            QFile file(font_file);
+
+            if (not file.open(QIODevice::ReadOnly)) {
+                qWarning() << __PRETTY_FUNCTION__ << "Could not open font file:" << font_file << ", error:" << file.errorString();
+                continue;
+            }
+
+            Q_EMIT m_relay->fontLoaded(m_generation, font_file, file.readAll());
+        }
+    }
+
+private:
+    const QSharedPointer<FontLoaderRelay> m_relay;
+    const int m_generation;
+    const QStringList m_font_files;
+};
+
+} // unnamed namespace
+
+class FontPreloaderPrivate
+{
+public:
+    QSharedPointer<FontLoaderRelay> relay;
+    QThreadPool pool;
+    int generation;
+    QHash<QString, int> registered_fonts;
+    QTimer warm_up_timer;
+    QList<QFont> warm_up_fonts;
+    QString warm_up_text;
+
+    explicit FontPreloaderPrivate();
+};
+
+FontPreloaderPrivate::FontPreloaderPrivate()
+    : relay(new FontLoaderRelay)
+    , pool()
+    , generation(0)
+    , registered_fonts()
+    , warm_up_timer()
+    , warm_up_fonts()
+    , warm_up_text()
+{
+    // One worker, so that preloads run in the order they were requested.
+    pool.setMaxThreadCount(1);
+    warm_up_timer.setSingleShot(true);
+    warm_up_timer.setInterval(0);
+}
+
+
+FontPreloader::FontPreloader(QObject *parent)
+    : QObject(parent)
+    , d_ptr(new FontPreloaderPrivate)
+{
+    Q_D(FontPreloader);
+
+    connect(d->relay.data(), SIGNAL(fontLoaded(int,QString,QByteArray)),
+            this,            SLOT(onFontLoaded(int,QString,QByteArray)),
+            Qt::QueuedConnection);
+    connect(&d->warm_up_timer, SIGNAL(timeout()),
+            this,              SLOT(onWarmUpTimeout()));
+}
+
+
+FontPreloader::~FontPreloader()
+{
+    Q_D(FontPreloader);
+
+    d->relay->disconnect(this);
+    d->pool.clear();
+    d->pool.waitForDone();
+}
+
+
+//! \brief Reads font files on a worker thread, then registers the fonts with
+//! QFontDatabase.
+//!
+//! Results of a previous, still running preload are dropped. Font files that
+//! were registered before are neither read nor registered again.
+//! \param font_files The font files, with full paths.
+void FontPreloader::preload(const QStringList &font_files)
+{
+    Q_D(FontPreloader);
+
+    ++d->generation;
+    d->pool.clear();
+
+    QStringList unregistered_files;
+
+    Q_FOREACH (const QString &font_file, font_files) {
+        if (not d->registered_fonts.contains(font_file)) {
+            unregistered_files.append(font_file);
+        }
+    }
+
+    if (unregistered_files.isEmpty()) {
+        return;
+    }
+
+    d->pool.start(new FontLoader(d->relay, d->generation, unregistered_files));
+}
+
+
+//! \brief Shapes and rasterizes text with registered fonts, on the GUI thread
+//! while it is idle.
+//!
+//! Replaces the text of a previous warm up; fonts not warmed up yet are kept.
+//! \param families The font families to warm up.
+//! \param text The text to shape, such as the labels of the active layout.
+//! \param point_sizes The point sizes the text is shown in.
+void FontPreloader::warmUp(const QStringList &families,
+                           const QString &text,
+                           const QList<qreal> &point_sizes)
+{
+    Q_D(FontPreloader);
+
+    if (text.isEmpty()) {
+        return;
+    }
+
+    Q_FOREACH (const QString &family, families) {
+        Q_FOREACH (qreal point_size, point_sizes) {
+            if (point_size <= 0) {
+                continue;
+            }
+
+            QFont font(family);
+            font.setPointSizeF(point_size);
+            d->warm_up_fonts.append(font);
+        }
+    }
+
+    d->warm_up_text = text;
+
+    if (not d->warm_up_fonts.isEmpty()) {
+        d->warm_up_timer.start();
+    }
+}
+
+
+//! \brief Blocks until the worker is done. Results are still delivered
+//! through the event loop.
+void FontPreloader::waitForDone()
+{
+    Q_D(FontPreloader);
+    d->pool.waitForDone();
+}
+
+
+void FontPreloader::onFontLoaded(int generation,
+                                 const QString &font_file,
+                                 const QByteArray &data)
+{
+    Q_D(FontPreloader);
+
+    if (generation != d->generation or d->registered_fonts.contains(font_file)) {
+        return;
+    }
+
+    const int id(QFontDatabase::addApplicationFontFromData(data));
+
+    if (id == -1) {
+        qWarning() << __PRETTY_FUNCTION__ << "Could not register font:" << font_file;
+        return;
+    }
+
+    d->registered_fonts.insert(font_file, id);
+    Q_EMIT fontRegistered(font_file, QFontDatabase::applicationFontFamilies(id));
+}
+
+
+//! \brief Warms up one font, and schedules the next one.
+void FontPreloader::onWarmUpTimeout()
+{
+    Q_D(FontPreloader);
+
+    if (d->warm_up_fonts.isEmpty()) {
+        return;
+    }
+
+    QTextLayout layout(d->warm_up_text, d->warm_up_fonts.takeFirst());
+
+    layout.beginLayout();
+    layout.createLine();
+    layout.endLayout();
+
+    Q_FOREACH (const QGlyphRun &run, layout.glyphRuns()) {
+        const QRawFont raw_font(run.rawFont());
+
+        Q_FOREACH (quint32 glyph, run.glyphIndexes()) {
+            raw_font.alphaMapForGlyph(glyph);
+        }
+    }
+
+    if (not d->warm_up_fonts.isEmpty()) {
+        d->warm_up_timer.start();
+    }
+}
+
+} // namespace MaliitKeyboard
+
+#include "fontpreloader.moc"
@@ -1,7 +1,7 @@
 /*
  * This file is part of Maliit Plugins
  *
- * Copyright (C) 2012-2013 Canonical Ltd
+ * Copyright (C) 2013 Canonical Ltd
  *
  * Contact: maliit-discuss@lists.maliit.org
  *
@@ -29,32 +29,46 @@
  *
  */
 
-#ifndef MALIIT_KEYBOARD_TAG_BINDING_CONTAINER_H
-#define MALIIT_KEYBOARD_TAG_BINDING_CONTAINER_H
 
-#include <QtGlobal>
+#ifndef MALIIT_KEYBOARD_FONTPRELOADER_H
+#define MALIIT_KEYBOARD_FONTPRELOADER_H
 
-#include "alltagtypes.h"
+#include <QtCore>
 
 namespace MaliitKeyboard {
 
-class TagBindingContainer
+class FontPreloaderPrivate;
+
+//! \brief Loads the fonts of a style profile on a worker thread.
+class FontPreloader
+    : public QObject
 {
-    Q_DISABLE_COPY(TagBindingContainer)
+    Q_OBJECT
+    Q_DISABLE_COPY(FontPreloader)
+    Q_DECLARE_PRIVATE(FontPreloader)
 
 public:
-    TagBindingContainer();
-
-    virtual ~TagBindingContainer();
+    explicit FontPreloader(QObject *parent = 0);
+    virtual ~FontPreloader();
 
-    const TagBindingPtr binding() const;
+    void preload(const QStringList &font_files);
+    void warmUp(const QStringList &families,
+                const QString &text,
+                const QList<qreal> &point_sizes);
+    void waitForDone();
 
-    void setBinding(const TagBindingPtr &binding);
+    Q_SIGNAL void fontRegistered(const QString &font_file,
+                                 const QStringList &families);
 
 private:
-    TagBindingPtr m_binding;
+    Q_SLOT void onFontLoaded(int generation,
+                             const QString &font_file,
+                             const QByteArray &data);
+    Q_SLOT void onWarmUpTimeout();
+
+    const QScopedPointer<FontPreloaderPrivate> d_ptr;
 };
 
 } // namespace MaliitKeyboard
 
-#endif // MALIIT_KEYBOARD_TAG_BINDING_CONTAINER_H
+#endif // MALIIT_KEYBOARD_FONTPRELOADER_H
@@ -34,6 +34,8 @@
 #include "editor.h"
 #include "updatenotifier.h"
 #include "maliitcontext.h"
+#include "keyimageprovider.h"
+#include "fontpreloader.h"
 
 #include "models/key.h"
 #include "models/keyarea.h"
@@ -168,6 +170,10 @@ public:
     Editor editor;
     DefaultFeedback feedback;
     SharedStyle style;
+    SharedKeyboardLoader loader;
+    Logic::SharedKeyAreaStorage key_area_storage;
+    SharedKeyImageAtlas key_images;
+    FontPreloader font_preloader;
     UpdateNotifier notifier;
     QMap<QString, SharedOverride> key_overrides;
     Settings settings;
@@ -183,6 +189,7 @@ public:
 
     void connectToNotifier();
     void setContextProperties(QQmlContext *qml_context);
+    void preloadFonts();
 };
 
 
@@ -194,6 +201,10 @@ InputMethodPrivate::InputMethodPrivate(InputMethod *const q,
     , editor(new Model::Text, new Logic::WordEngine, new Logic::LanguageFeatures)
     , feedback()
     , style(new Style)
+    , loader(new KeyboardLoader)
+    , key_area_storage(new Logic::KeyAreaStorage)
+    , key_images(new KeyImageAtlas)
+    , font_preloader()
     , notifier()
     , key_overrides()
     , settings()
@@ -213,6 +224,14 @@ InputMethodPrivate::InputMethodPrivate(InputMethod *const q,
 
     layout.updater.setStyle(style);
     extended_layout.updater.setStyle(style);
+
+    // Both updaters show the same layout, so they share the loader and the
+    // converted key areas.
+    layout.updater.setKeyboardLoader(loader);
+    extended_layout.updater.setKeyboardLoader(loader);
+    layout.updater.setKeyAreaStorage(key_area_storage);
+    extended_layout.updater.setKeyAreaStorage(key_area_storage);
+
     feedback.setStyle(style);
 
     const QSize &screen_size(QGuiApplication::primaryScreen()->availableSize());
@@ -229,24 +248,41 @@ InputMethodPrivate::InputMethodPrivate(InputMethod *const q,
     // TODO: Figure out whether two views can share one engine.
     QQmlEngine *const engine(surface->engine());
     engine->addImportPath(MALIIT_KEYBOARD_DATA_DIR);
+    engine->addImageProvider(KeyImageProvider::id(), new KeyImageProvider(key_images));
     setContextProperties(engine->rootContext());
 
     surface->setSource(QUrl::fromLocalFile(g_maliit_keyboard_qml));
 
     QQmlEngine *const extended_engine(extended_surface->engine());
     extended_engine->addImportPath(MALIIT_KEYBOARD_DATA_DIR);
+    extended_engine->addImageProvider(KeyImageProvider::id(), new KeyImageProvider(key_images));
     setContextProperties(extended_engine->rootContext());
 
     extended_surface->setSource(QUrl::fromLocalFile(g_maliit_keyboard_extended_qml));
 
     QQmlEngine *const magnifier_engine(magnifier_surface->engine());
     magnifier_engine->addImportPath(MALIIT_KEYBOARD_DATA_DIR);
+    magnifier_engine->addImageProvider(KeyImageProvider::id(), new KeyImageProvider(key_images));
     setContextProperties(magnifier_engine->rootContext());
 
     magnifier_surface->setSource(QUrl::fromLocalFile(g_maliit_magnifier_qml));
 }
 
 
+//! \brief Loads the fonts of the style profile in the background.
+void InputMethodPrivate::preloadFonts()
+{
+    const QString fonts_directory(style->directory(Style::Fonts));
+    QStringList font_files;
+
+    Q_FOREACH (const QString &font_file, style->attributes()->fontFiles()) {
+        font_files.append(fonts_directory + "/" + font_file);
+    }
+
+    font_preloader.preload(font_files);
+}
+
+
 void InputMethodPrivate::setLayoutOrientation(Logic::LayoutHelper::Orientation orientation)
 {
     qWarning()<<"Setting maliit-keyboard orientation:"<<orientation;
@@ -310,6 +346,15 @@ InputMethod::InputMethod(MAbstractInputMethodHost *host)
     connect(&d->extended_layout.helper, SIGNAL(extendedPanelChanged(KeyArea,Logic::KeyOverrides)),
             &d->extended_layout.model, SLOT(setKeyArea(KeyArea)));
 
+    connect(&d->layout.helper, SIGNAL(centerPanelKeyChanged(int,Key)),
+            &d->layout.model,  SLOT(replaceKey(int,Key)));
+
+    connect(&d->font_preloader, SIGNAL(fontRegistered(QString,QStringList)),
+            this,               SLOT(onFontRegistered(QString,QStringList)));
+
+    connect(&d->extended_layout.helper, SIGNAL(extendedPanelKeyChanged(int,Key)),
+            &d->extended_layout.model,  SLOT(replaceKey(int,Key)));
+
     connect(&d->layout.helper,    SIGNAL(magnifierChanged(KeyArea)),
             &d->magnifier_layout, SLOT(setKeyArea(KeyArea)));
 
@@ -438,9 +483,8 @@ void InputMethod::setActiveSubView(const QString &id,
     Q_UNUSED(state)
     Q_D(InputMethod);
 
-    // FIXME: Perhaps better to let both LayoutUpdater share the same KeyboardLoader instance?
+    // The extended layout follows, as it shares the keyboard loader.
     d->layout.updater.setActiveKeyboardId(id);
-    d->extended_layout.updater.setActiveKeyboardId(id);
 }
 
 QString InputMethod::activeSubView(Maliit::HandlerState state) const
@@ -656,9 +700,43 @@ void InputMethod::onStyleSettingChanged()
 {
     Q_D(InputMethod);
     d->style->setProfile(d->settings.style->value().toString());
-    d->layout.model.setImageDirectory(d->style->directory(Style::Images));
-    d->extended_layout.model.setImageDirectory(d->style->directory(Style::Images));
-    d->magnifier_layout.setImageDirectory(d->style->directory(Style::Images));
+
+    // All images of the profile are decoded here, and then served from the
+    // atlas, so that key state changes never load images.
+    d->key_images->load(d->style->directory(Style::Images), d->style->files(Style::Images));
+    const QString image_directory(KeyImageProvider::imageDirectory(d->style->profile()));
+
+    d->layout.model.setImageDirectory(image_directory);
+    d->extended_layout.model.setImageDirectory(image_directory);
+    d->magnifier_layout.setImageDirectory(image_directory);
+
+    d->preloadFonts();
+}
+
+//! \brief Warms up a registered font with the labels of the active layout,
+//! in the sizes of keys and magnifier.
+void InputMethod::onFontRegistered(const QString &font_file,
+                                   const QStringList &families)
+{
+    Q_UNUSED(font_file)
+    Q_D(InputMethod);
+
+    QString labels;
+
+    Q_FOREACH (const Key &key, d->layout.helper.centerPanel().keys()) {
+        labels.append(key.label().text());
+    }
+
+    const Logic::LayoutHelper::Orientation orientation(d->layout.helper.orientation());
+    const StyleAttributes * const attributes(d->style->attributes());
+
+    if (not attributes) {
+        return;
+    }
+
+    d->font_preloader.warmUp(families, labels,
+                             QList<qreal>() << attributes->fontSize(orientation)
+                                            << attributes->magnifierFontSize(orientation));
 }
 
 void InputMethod::onKeyboardClosed()
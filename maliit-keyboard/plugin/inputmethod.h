@@ -102,6 +102,8 @@ private:
     Q_SLOT void onMagnifierLayoutWidthChanged(int width);
     Q_SLOT void onMagnifierLayoutHeightChanged(int height);
     Q_SLOT void onMagnifierLayoutOriginChanged(const QPoint &origin);
+    Q_SLOT void onFontRegistered(const QString &font_file,
+                                 const QStringList &families);
 
     const QScopedPointer<InputMethodPrivate> d_ptr;
 };
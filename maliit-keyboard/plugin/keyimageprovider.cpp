@@ -0,0 +1,265 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "keyimageprovider.h"
+
+#include <QPainter>
+
+namespace MaliitKeyboard {
+
+//! \class KeyImageAtlas
+//! Key backgrounds and icons are requested whenever a key changes its state.
+//! Decoding all images when the profile is loaded means that state changes
+//! never cause image I/O or PNG decoding.
+
+//! \class KeyImageProvider
+//! The profile is part of the image URLs, so that QML does not serve images
+//! of the previous profile from its pixmap cache after a profile change.
+
+namespace {
+
+const char *const g_provider_id("maliit-keyboard");
+const int g_min_atlas_width(1024);
+
+struct DecodedImage
+{
+    QString file_name;
+    QImage image;
+};
+
+bool isTaller(const DecodedImage &a,
+              const DecodedImage &b)
+{
+    return (a.image.height() > b.image.height());
+}
+
+// Sub-images reference the pixels of the atlas, which stays alive for as
+// long as one of them does.
+void releaseAtlas(void *atlas)
+{
+    delete static_cast<QImage *>(atlas);
+}
+
+QImage subImage(const QImage &atlas,
+                const QRect &rect)
+{
+    const uchar *const bits(atlas.constBits()
+                            + rect.y() * atlas.bytesPerLine()
+                            + rect.x() * (atlas.depth() / 8));
+
+    return QImage(bits, rect.width(), rect.height(), atlas.bytesPerLine(), atlas.format(),
+                  releaseAtlas, new QImage(atlas));
+}
+
+} // unnamed namespace
+
+class KeyImageAtlasPrivate
+{
+public:
+    mutable QMutex mutex; // requestImage() may be called from a QML loader thread
+    QImage atlas;
+    QHash<QString, QImage> images; // read-only views into atlas
+
+    explicit KeyImageAtlasPrivate();
+};
+
+KeyImageAtlasPrivate::KeyImageAtlasPrivate()
+    : mutex()
+    , atlas()
+    , images()
+{}
+
+
+KeyImageAtlas::KeyImageAtlas()
+    : d_ptr(new KeyImageAtlasPrivate)
+{}
+
+
+KeyImageAtlas::~KeyImageAtlas()
+{}
+
+
+//! \brief Decodes images and replaces the atlas with one holding them.
+//!
+//! Images are placed on shelves, tallest first. Files that cannot be decoded
+//! are skipped.
+//! \param directory The image directory of the profile.
+//! \param file_names The image files, relative to the directory.
+void KeyImageAtlas::load(const QString &directory,
+                         const QStringList &file_names)
+{
+    Q_D(KeyImageAtlas);
+
+    QList<DecodedImage> decoded;
+    int atlas_width(g_min_atlas_width);
+
+    Q_FOREACH (const QString &file_name, file_names) {
+        DecodedImage entry;
+
+        entry.file_name = file_name;
+        entry.image = QImage(directory + "/" + file_name);
+
+        if (entry.image.isNull()) {
+            qWarning() << __PRETTY_FUNCTION__ << "Could not decode image:" << directory + "/" + file_name;
+            continue;
+        }
+
+        entry.image = entry.image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        atlas_width = qMax(atlas_width, entry.image.width());
+        decoded.append(entry);
+    }
+
+    qStableSort(decoded.begin(), decoded.end(), isTaller);
+
+    QHash<QString, QRect> rects;
+    QPoint pos(0, 0);
+    int shelf_height(0);
+
+    Q_FOREACH (const DecodedImage &entry, decoded) {
+        if (pos.x() + entry.image.width() > atlas_width) {
+            pos = QPoint(0, pos.y() + shelf_height);
+            shelf_height = 0;
+        }
+
+        rects.insert(entry.file_name, QRect(pos, entry.image.size()));
+        pos.rx() += entry.image.width();
+        shelf_height = qMax(shelf_height, entry.image.height());
+    }
+
+    QImage atlas;
+    QHash<QString, QImage> images;
+
+    if (not decoded.isEmpty()) {
+        atlas = QImage(atlas_width, pos.y() + shelf_height, QImage::Format_ARGB32_Premultiplied);
+        atlas.fill(Qt::transparent);
+
+        {
+            QPainter painter(&atlas);
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+
+            Q_FOREACH (const DecodedImage &entry, decoded) {
+                painter.drawImage(rects.value(entry.file_name).topLeft(), entry.image);
+            }
+        }
+
+        for (QHash<QString, QRect>::const_iterator it(rects.constBegin()); it != rects.constEnd(); ++it) {
+            images.insert(it.key(), subImage(atlas, *it));
+        }
+    }
+
+    QMutexLocker locker(&d->mutex);
+    d->atlas = atlas;
+    d->images = images;
+}
+
+
+//! \brief Returns one image of the atlas, or a null image if the atlas does
+//! not hold it.
+//!
+//! The image shares the pixels of the atlas, so returning it does not copy
+//! or allocate them. Writing to it detaches.
+//! \param file_name The image file, relative to the image directory.
+QImage KeyImageAtlas::image(const QString &file_name) const
+{
+    Q_D(const KeyImageAtlas);
+    QMutexLocker locker(&d->mutex);
+
+    return d->images.value(file_name);
+}
+
+
+//! \brief Returns the size of the atlas image.
+QSize KeyImageAtlas::size() const
+{
+    Q_D(const KeyImageAtlas);
+    QMutexLocker locker(&d->mutex);
+
+    return d->atlas.size();
+}
+
+
+//! \param atlas The atlas to serve images from.
+KeyImageProvider::KeyImageProvider(const SharedKeyImageAtlas &atlas)
+    : QQuickImageProvider(QQuickImageProvider::Image)
+    , m_atlas(atlas)
+{}
+
+
+KeyImageProvider::~KeyImageProvider()
+{}
+
+
+//! \brief Returns the id under which the provider is added to QML engines.
+QString KeyImageProvider::id()
+{
+    return QString::fromLatin1(g_provider_id);
+}
+
+
+//! \brief Returns the image directory to use for Model::Layout, so that it
+//! builds image URLs served by this provider.
+//! \param profile The active style profile.
+QString KeyImageProvider::imageDirectory(const QString &profile)
+{
+    if (profile.isEmpty()) {
+        return QString();
+    }
+
+    return QString("image://%1/%2").arg(id()).arg(profile);
+}
+
+
+QImage KeyImageProvider::requestImage(const QString &id,
+                                      QSize *size,
+                                      const QSize &requested_size)
+{
+    // The id is "<profile>/<file name>".
+    const QString file_name(id.section('/', 1));
+    QImage result(m_atlas->image(file_name));
+
+    if (result.isNull()) {
+        qWarning() << __PRETTY_FUNCTION__ << "No such image:" << id;
+        return result;
+    }
+
+    if (size) {
+        *size = result.size();
+    }
+
+    if (requested_size.isValid() and requested_size != result.size()) {
+        result = result.scaled(requested_size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    }
+
+    return result;
+}
+
+} // namespace MaliitKeyboard
@@ -1,7 +1,7 @@
 /*
  * This file is part of Maliit Plugins
  *
- * Copyright (C) 2012-2013 Canonical Ltd
+ * Copyright (C) 2013 Canonical Ltd
  *
  * Contact: maliit-discuss@lists.maliit.org
  *
@@ -29,38 +29,60 @@
  *
  */
 
-#ifndef MALIIT_KEYBOARD_TAG_MODIFIERS_H
-#define MALIIT_KEYBOARD_TAG_MODIFIERS_H
 
-#include <QtGlobal>
+#ifndef MALIIT_KEYBOARD_KEYIMAGEPROVIDER_H
+#define MALIIT_KEYBOARD_KEYIMAGEPROVIDER_H
 
-#include "alltagtypes.h"
-#include "tagbindingcontainer.h"
+#include <QtCore>
+#include <QImage>
+#include <QQuickImageProvider>
 
 namespace MaliitKeyboard {
 
-class TagModifiers
-    : public TagBindingContainer
+class KeyImageAtlasPrivate;
+
+//! \brief Holds the images of a style profile, decoded once and packed into
+//! one atlas image.
+class KeyImageAtlas
 {
-    Q_DISABLE_COPY(TagModifiers)
+    Q_DISABLE_COPY(KeyImageAtlas)
+    Q_DECLARE_PRIVATE(KeyImageAtlas)
 
 public:
-    enum Keys {
-        Alt,
-        Shift,
-        AltShift
-    };
+    explicit KeyImageAtlas();
+    ~KeyImageAtlas();
+
+    void load(const QString &directory,
+              const QStringList &file_names);
+    QImage image(const QString &file_name) const;
+    QSize size() const;
+
+private:
+    const QScopedPointer<KeyImageAtlasPrivate> d_ptr;
+};
+
+typedef QSharedPointer<KeyImageAtlas> SharedKeyImageAtlas;
 
-    TagModifiers(Keys keys);
+//! \brief Serves the images of a KeyImageAtlas to QML, as
+//! "image://maliit-keyboard/<profile>/<file name>".
+class KeyImageProvider
+    : public QQuickImageProvider
+{
+public:
+    explicit KeyImageProvider(const SharedKeyImageAtlas &atlas);
+    virtual ~KeyImageProvider();
 
-    virtual ~TagModifiers();
+    static QString id();
+    static QString imageDirectory(const QString &profile);
 
-    Keys keys() const;
+    virtual QImage requestImage(const QString &id,
+                                QSize *size,
+                                const QSize &requested_size);
 
 private:
-    const Keys m_keys;
+    const SharedKeyImageAtlas m_atlas;
 };
 
 } // namespace MaliitKeyboard
 
-#endif // MALIIT_KEYBOARD_TAG_EXTENDED_H
+#endif // MALIIT_KEYBOARD_KEYIMAGEPROVIDER_H
@@ -25,6 +25,8 @@ HEADERS += \
     editor.h \
     updatenotifier.h \
     maliitcontext.h \
+    keyimageprovider.h \
+    fontpreloader.h \
 
 SOURCES += \
     plugin.cpp \
@@ -32,6 +34,8 @@ SOURCES += \
     editor.cpp \
     updatenotifier.cpp \
     maliitcontext.cpp \
+    keyimageprovider.cpp \
+    fontpreloader.cpp \
 
 target.path += $${MALIIT_PLUGINS_DIR}
 INSTALLS += target
@@ -0,0 +1,139 @@
+// -*- mode: C++; c-basic-offset: 4; indent-tabs-mode: nil; c-file-offsets: ((innamespace . 0)); -*-
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "models/stylebundle.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+
+#include <cstdio>
+
+using namespace MaliitKeyboard;
+
+namespace {
+
+void printUsage()
+{
+    std::fprintf(stderr, "Usage: maliit-keyboard-style-compiler -o OUTPUT PROFILE_DIRECTORY\n"
+                         "Compiles a style profile into one binary style bundle.\n");
+}
+
+//! \brief Returns the names of all files in a profile subdirectory.
+QStringList assetFiles(const QDir &profile_dir,
+                       const QString &sub_dir)
+{
+    const QDir dir(profile_dir.filePath(sub_dir));
+    return dir.entryList(QDir::Files | QDir::NoDotAndDotDot, QDir::Name);
+}
+
+} // unnamed namespace
+
+int main(int argc,
+         char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QStringList args(app.arguments());
+    QString output;
+    QString input;
+
+    args.removeFirst();
+
+    while (not args.isEmpty()) {
+        const QString arg(args.takeFirst());
+
+        if (arg == "-o") {
+            if (args.isEmpty()) {
+                printUsage();
+                return 1;
+            }
+            output = args.takeFirst();
+        } else if (arg == "-h" or arg == "--help") {
+            printUsage();
+            return 0;
+        } else if (input.isEmpty()) {
+            input = arg;
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (output.isEmpty() or input.isEmpty()) {
+        printUsage();
+        return 1;
+    }
+
+    const QDir profile_dir(input);
+    const QFileInfo main_file(profile_dir.filePath("main.ini"));
+    const QFileInfo extended_keys_file(profile_dir.filePath("extended-keys.ini"));
+
+    if (not main_file.exists()) {
+        qCritical("No main.ini in %s", qPrintable(input));
+        return 1;
+    }
+
+    const QSettings main_settings(main_file.filePath(), QSettings::IniFormat);
+    const QSettings extended_keys_settings(extended_keys_file.filePath(), QSettings::IniFormat);
+
+    if (main_settings.status() != QSettings::NoError
+        or extended_keys_settings.status() != QSettings::NoError) {
+        qCritical("Could not parse the INI files in %s", qPrintable(input));
+        return 1;
+    }
+
+    StyleBundleWriter writer;
+
+    writer.addTable(StyleBundleWriter::MainTable, main_settings);
+    writer.addTable(StyleBundleWriter::ExtendedKeysTable, extended_keys_settings);
+    writer.addAssets(StyleBundleWriter::ImageAsset, assetFiles(profile_dir, "images"));
+    writer.addAssets(StyleBundleWriter::SoundAsset, assetFiles(profile_dir, "sounds"));
+    writer.addAssets(StyleBundleWriter::FontAsset, assetFiles(profile_dir, "fonts"));
+    writer.setSourceHash(StyleBundle::hashSources(QStringList()
+                                                  << main_file.filePath()
+                                                  << extended_keys_file.filePath()));
+
+    QFile file(output);
+    const QByteArray bundle(writer.data());
+
+    if (not file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        or file.write(bundle) != bundle.size()) {
+        qCritical("Could not write %s: %s", qPrintable(output), qPrintable(file.errorString()));
+        return 1;
+    }
+
+    return 0;
+}
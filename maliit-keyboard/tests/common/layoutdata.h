@@ -1,7 +1,7 @@
 /*
  * This file is part of Maliit Plugins
  *
- * Copyright (C) 2012-2013 Canonical Ltd
+ * Copyright (C) 2013 Canonical Ltd
  *
  * Contact: maliit-discuss@lists.maliit.org
  *
@@ -29,25 +29,32 @@
  *
  */
 
-#include "tagrowcontainer.h"
+#ifndef TESTLAYOUTDATA_H
+#define TESTLAYOUTDATA_H
 
-namespace MaliitKeyboard {
+#include "logic/keyboardloader.h"
 
-TagRowContainer::TagRowContainer()
-    : m_rows()
-{}
+#include <QtCore>
 
-TagRowContainer::~TagRowContainer()
-{}
+namespace TestUtils {
 
-const TagRowPtrs TagRowContainer::rows() const
+// Makes the keyboard read the layouts and style profiles from
+// TEST_DATADIR (see layout-data.pri) and write its caches to cache_dir.
+inline bool useLayoutTestData(const QString &cache_dir)
 {
-    return m_rows;
+    return qputenv("MALIIT_PLUGINS_DATADIR", TEST_DATADIR)
+           and qputenv("MALIIT_KEYBOARD_DATADIR", TEST_MALIIT_KEYBOARD_DATADIR)
+           and qputenv("MALIIT_KEYBOARD_CACHEDIR", cache_dir.toUtf8());
 }
 
-void TagRowContainer::appendRow(const TagRowPtr &row)
+inline MaliitKeyboard::SharedKeyboardLoader getLoader(const QString &id)
 {
-    m_rows.append(row);
+    MaliitKeyboard::SharedKeyboardLoader loader(new MaliitKeyboard::KeyboardLoader);
+
+    loader->setActiveId(id);
+    return loader;
 }
 
-} // namespace MaliitKeyboard
+} // namespace TestUtils
+
+#endif
@@ -0,0 +1,133 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "layoutdata.h"
+
+#include "models/key.h"
+#include "models/keyarea.h"
+#include "logic/keyboardloader.h"
+#include "logic/keyareaconverter.h"
+#include "logic/keyareastorage.h"
+#include "logic/style.h"
+#include "logic/layouthelper.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+using TestUtils::getLoader;
+
+class TestKeyAreaStorage
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_cache_dir;
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_cache_dir.isValid());
+        QVERIFY(TestUtils::useLayoutTestData(m_cache_dir.path()));
+    }
+
+    Q_SLOT void testStoredEntriesOnDisk()
+    {
+        const QString name("styling_profile_test/test-profile/landscape");
+        SharedKeyboardLoader loader(getLoader("styling_profile_test"));
+        Style style;
+        style.setProfile("test-profile");
+
+        const QByteArray stamp(loader->sourceHash("styling_profile_test") + style.sourceHash());
+        QVERIFY(not stamp.isEmpty());
+
+        Logic::KeyAreaConverter converter(style.attributes(), loader.data());
+        converter.setLayoutOrientation(Logic::LayoutHelper::Landscape);
+
+        const QVector<KeyArea> key_areas(QVector<KeyArea>()
+                                         << converter.keyArea()
+                                         << converter.shiftedKeyArea());
+        QVERIFY(key_areas.first().hasKeys());
+
+        {
+            Logic::KeyAreaStorage storage(m_cache_dir.path() + "/keyareas");
+            QVector<KeyArea> loaded;
+
+            QVERIFY(not storage.load(name, stamp, &loaded));
+            storage.store(name, stamp, key_areas);
+        }
+
+        // A new storage, as after a restart.
+        Logic::KeyAreaStorage storage(m_cache_dir.path() + "/keyareas");
+        QVector<KeyArea> loaded;
+
+        QVERIFY(storage.load(name, stamp, &loaded));
+        QCOMPARE(loaded.size(), key_areas.size());
+
+        for (int index(0); index < key_areas.size(); ++index) {
+            const KeyArea &expected(key_areas.at(index));
+            const KeyArea &gotten(loaded.at(index));
+
+            QVERIFY(gotten.area() == expected.area());
+            QVERIFY(gotten.keys() == expected.keys());
+            QCOMPARE(gotten.origin(), expected.origin());
+
+            for (int key_index(0); key_index < expected.keys().size(); ++key_index) {
+                const Key expected_key(expected.keys().at(key_index));
+                const Key gotten_key(gotten.keys().at(key_index));
+
+                QCOMPARE(gotten_key.margins(), expected_key.margins());
+                QCOMPARE(gotten_key.action(), expected_key.action());
+                QCOMPARE(gotten_key.extendedKeysId(), expected_key.extendedKeysId());
+                QCOMPARE(gotten_key.label().font().size(), expected_key.label().font().size());
+            }
+        }
+
+        // Stale entries are never returned.
+        QVERIFY(not storage.load(name, stamp + "-changed", &loaded));
+    }
+
+    Q_SLOT void testStoredEntriesInMemory()
+    {
+        Logic::KeyAreaStorage storage(m_cache_dir.path() + "/memory");
+        QVector<KeyArea> key_areas;
+
+        // Stored entries are available right away, before they hit the disk.
+        storage.store("name", "stamp", QVector<KeyArea>() << KeyArea());
+        QVERIFY(storage.load("name", "stamp", &key_areas));
+        QCOMPARE(key_areas.size(), 1);
+        QVERIFY(not storage.load("name", "other-stamp", &key_areas));
+        storage.waitForDone();
+    }
+};
+
+QTEST_MAIN(TestKeyAreaStorage)
+#include "main.moc"
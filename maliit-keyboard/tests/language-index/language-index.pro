@@ -0,0 +1,20 @@
+include(../../config.pri)
+include(../common-check.pri)
+
+TOP_BUILDDIR = $${OUT_PWD}/../../..
+TARGET = language-index
+TEMPLATE = app
+QT = core testlib
+
+INCLUDEPATH += ../ ../../lib ../../
+LIBS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+PRE_TARGETDEPS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+
+DEFINES += TEST_LANGUAGES_DIR=\\\"$$PWD/../language-layout-loading/languages\\\"
+
+HEADERS += \
+
+SOURCES += \
+    main.cpp \
+
+include(../../word-prediction.pri)
@@ -0,0 +1,90 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "logic/keyboardloader.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+
+class TestLanguageIndex
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    // The languages directory is read once per process, so every test in
+    // here works on the same temporary directory.
+    QTemporaryDir m_data_dir;
+    QTemporaryDir m_cache_dir;
+
+    QString languagesDir() const
+    {
+        return m_data_dir.path() + "/languages";
+    }
+
+    bool addLanguage(const QString &source_id,
+                     const QString &id)
+    {
+        return QFile::copy(QString::fromLatin1(TEST_LANGUAGES_DIR) + "/" + source_id + ".xml",
+                           languagesDir() + "/" + id + ".xml");
+    }
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_data_dir.isValid());
+        QVERIFY(m_cache_dir.isValid());
+        QVERIFY(QDir(m_data_dir.path()).mkdir("languages"));
+        QVERIFY(qputenv("MALIIT_PLUGINS_DATADIR", m_data_dir.path().toUtf8()));
+        QVERIFY(qputenv("MALIIT_KEYBOARD_CACHEDIR", m_cache_dir.path().toUtf8()));
+    }
+
+    Q_SLOT void testIdsFollowDirectory()
+    {
+        QVERIFY(addLanguage("action_test1", "action_test1"));
+
+        KeyboardLoader loader;
+        QCOMPARE(loader.ids(), QStringList() << "action_test1");
+
+        // Ids keep everything up to the last dot of the file name.
+        QVERIFY(addLanguage("action_test2", "action_test2.v2"));
+        QTRY_COMPARE(loader.ids(), QStringList() << "action_test1" << "action_test2.v2");
+        QCOMPARE(loader.title("action_test2.v2"), QString("ActionTest2"));
+
+        QVERIFY(QFile::remove(languagesDir() + "/action_test1.xml"));
+        QTRY_COMPARE(loader.ids(), QStringList() << "action_test2.v2");
+    }
+};
+
+QTEST_MAIN(TestLanguageIndex)
+#include "main.moc"
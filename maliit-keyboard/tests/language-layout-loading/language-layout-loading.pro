@@ -10,10 +10,10 @@ INCLUDEPATH += ../ ../../lib ../../
 LIBS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
 PRE_TARGETDEPS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
 
-DEFINES += TEST_DATADIR=\\\"$$PWD\\\"
-DEFINES += TEST_MALIIT_KEYBOARD_DATADIR=\\\"$$PWD\\\"
+include(../layout-data.pri)
 
 HEADERS += \
+    ../common/layoutdata.h \
 
 SOURCES += \
     main.cpp \
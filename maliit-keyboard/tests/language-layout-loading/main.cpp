@@ -30,24 +30,29 @@
  */
 
 #include "utils.h"
+#include "layoutdata.h"
 #include "coreutils.h"
 
 #include "models/key.h"
 #include "models/keydescription.h"
 #include "models/keyboard.h"
+#include "models/keyarea.h"
 #include "models/styleattributes.h"
 #include "logic/keyboardloader.h"
 #include "logic/keyareaconverter.h"
+#include "logic/keyareastorage.h"
 #include "logic/style.h"
 #include "logic/layouthelper.h"
+#include "logic/layoutupdater.h"
+#include "parser/layoutimage.h"
+#include "parser/layoutparser.h"
 
 #include <QtCore>
 #include <QtTest>
 #include <QDebug>
 
 using namespace MaliitKeyboard;
-
-typedef QSharedPointer<KeyboardLoader> SharedKeyboardLoader;
+using TestUtils::getLoader;
 
 typedef QPair<QString, QString> DictionaryValue;
 typedef QMap<QString, QString> Dictionary;
@@ -59,14 +64,6 @@ Q_DECLARE_METATYPE(Keyboard)
 
 namespace {
 
-SharedKeyboardLoader getLoader(const QString &id)
-{
-    SharedKeyboardLoader loader(new KeyboardLoader);
-
-    loader->setActiveId(id);
-    return loader;
-}
-
 Keyboard stringToKeyboard(const QString &str)
 {
     enum
@@ -214,6 +211,8 @@ class TestLanguageLayoutLoading
     Q_OBJECT
 
 private:
+    QTemporaryDir m_cache_dir;
+
     void compareKeyboards(const Keyboard &kb1, const Keyboard &kb2)
     {
         QCOMPARE(kb1.keys.size(), kb2.keys.size());
@@ -243,8 +242,8 @@ private:
 
     Q_SLOT void initTestCase()
     {
-        QVERIFY(qputenv("MALIIT_PLUGINS_DATADIR", TEST_DATADIR));
-        QVERIFY(qputenv("MALIIT_KEYBOARD_DATADIR", TEST_MALIIT_KEYBOARD_DATADIR));
+        QVERIFY(m_cache_dir.isValid());
+        QVERIFY(TestUtils::useLayoutTestData(m_cache_dir.path()));
     }
 
     Q_SLOT void testSanity_data()
@@ -552,6 +551,62 @@ private:
         COMPARE_KEYBOARDS(loader->extendedKeyboard(pressed_key), stringToKeyboard(expected_keyboard));
     }
 
+    Q_SLOT void testExtendedByKeyId_data()
+    {
+        QTest::addColumn<QString>("keyboard_id");
+        QTest::addColumn<bool>("shifted");
+        QTest::addColumn<int>("key_index");
+        QTest::addColumn<QString>("label");
+        QTest::addColumn<QString>("expected_keyboard");
+
+        QTest::newRow("Key from layout does not depend on its label")
+            << "extended_test"
+            << false
+            << 3
+            << "d"
+            << "|h|i|\n|j|k|";
+
+        QTest::newRow("Key from shifted layout gets shifted extended keys")
+            << "extended_test"
+            << true
+            << 1
+            << "A"
+            << "|A|B|C|";
+
+        QTest::newRow("Key with empty label from layout")
+            << "extended_test"
+            << false
+            << 6
+            << ""
+            << "|x|";
+
+        QTest::newRow("No extended keyboard for spacebars from layout")
+            << "extended_test"
+            << false
+            << 5
+            << ""
+            << "";
+    }
+
+    Q_SLOT void testExtendedByKeyId()
+    {
+        QFETCH(QString, keyboard_id);
+        QFETCH(bool, shifted);
+        QFETCH(int, key_index);
+        QFETCH(QString, label);
+        QFETCH(QString, expected_keyboard);
+
+        SharedKeyboardLoader loader(getLoader(keyboard_id));
+        const Keyboard keyboard(shifted ? loader->shiftedKeyboard() : loader->keyboard());
+
+        QVERIFY(key_index < keyboard.keys.size());
+
+        Key pressed_key(keyboard.keys.at(key_index));
+
+        pressed_key.rLabel().setText(label);
+        COMPARE_KEYBOARDS(loader->extendedKeyboard(pressed_key), stringToKeyboard(expected_keyboard));
+    }
+
     Q_SLOT void testStylingProfile()
     {
         const Logic::LayoutHelper::Orientation orientation(Logic::LayoutHelper::Landscape);
@@ -619,6 +674,230 @@ private:
         QCOMPARE(key.rect().x(), expected_left_edge);
         QCOMPARE(key.rect().x() + key.rect().width(), expected_right_edge);
     }
+
+    Q_SLOT void testLayoutImage_data()
+    {
+        QTest::addColumn<QString>("keyboard_id");
+
+        QTest::newRow("General layout with imports") << "general_test1";
+        QTest::newRow("Imported symbols layout") << "general_test1_symbols";
+        QTest::newRow("Extended keys and modifiers") << "extended_test";
+        QTest::newRow("Actions and icons") << "icon_test1";
+    }
+
+    Q_SLOT void testLayoutImage()
+    {
+        QFETCH(QString, keyboard_id);
+
+        QFile file(QString::fromLatin1(TEST_DATADIR) + "/languages/" + keyboard_id + ".xml");
+        QVERIFY(file.open(QIODevice::ReadOnly));
+
+        LayoutParser parser(&file);
+        QVERIFY(parser.parse());
+
+        const QByteArray source_hash(LayoutImage::hashFile(file.fileName()));
+        QVERIFY(not source_hash.isEmpty());
+        LayoutImageWriter writer;
+        writer.addKeyboard(keyboard_id, parser.tree(), source_hash);
+
+        const QByteArray data(writer.data());
+        const LayoutImage image(reinterpret_cast<const uchar *>(data.constData()), data.size());
+
+        QVERIFY(image.isValid());
+        QCOMPARE(image.ids(), QStringList() << keyboard_id);
+        QCOMPARE(image.sourceHash(keyboard_id), source_hash);
+        QCOMPARE(image.isLanguage(keyboard_id),
+                 not parser.tree()->string(parser.tree()->keyboard().language).isEmpty());
+
+        const LayoutTreePtr tree(image.tree(keyboard_id));
+
+        QVERIFY(tree);
+        QCOMPARE(tree->string(tree->keyboard().title),
+                 parser.tree()->string(parser.tree()->keyboard().title));
+        QCOMPARE(tree->imports(LayoutTree::Import::OldStyle), parser.imports());
+        QCOMPARE(tree->imports(LayoutTree::Import::Symview), parser.symviews());
+        QCOMPARE(tree->imports(LayoutTree::Import::Number), parser.numbers());
+        QCOMPARE(tree->imports(LayoutTree::Import::PhoneNumber), parser.phonenumbers());
+
+        // A tree read back from the image has to produce the very same image.
+        LayoutImageWriter rewriter;
+        rewriter.addKeyboard(keyboard_id, tree, source_hash);
+        QCOMPARE(rewriter.data(), data);
+
+        QByteArray damaged(data);
+        damaged[0] = '\0';
+        QVERIFY(not LayoutImage(reinterpret_cast<const uchar *>(damaged.constData()), damaged.size()).isValid());
+        QVERIFY(not LayoutImage(reinterpret_cast<const uchar *>(data.constData()), data.size() - 1).isValid());
+    }
+
+    Q_SLOT void testLayoutTree()
+    {
+        QFile file(QString::fromLatin1(TEST_DATADIR) + "/languages/general_test1.xml");
+        QVERIFY(file.open(QIODevice::ReadOnly));
+
+        LayoutParser parser(&file);
+        QVERIFY(parser.parse());
+
+        const LayoutTreePtr tree(parser.tree());
+        const LayoutTree::Keyboard &keyboard(tree->keyboard());
+
+        QVERIFY(keyboard.layouts.count > 0);
+
+        // Walking the first section finds the keys the loader builds.
+        const int section(tree->layout(keyboard.layouts.first).sections.first);
+        int key_count(0);
+
+        for (int row(tree->section(section).rows.first); row != -1; row = tree->row(row).next) {
+            for (int element(tree->row(row).elements.first); element != -1; element = tree->element(element).next) {
+                if (tree->element(element).type == LayoutTree::Element::Key) {
+                    ++key_count;
+                }
+            }
+        }
+
+        SharedKeyboardLoader loader(getLoader("general_test1"));
+        QCOMPARE(key_count, loader->keyboard().keys.count());
+
+        LayoutTree strings;
+        const int index(strings.intern("a"));
+
+        QCOMPARE(strings.intern(QString::fromLatin1("a")), index);
+        QCOMPARE(strings.intern(QString()), 0);
+        QCOMPARE(strings.string(index), QString::fromLatin1("a"));
+    }
+
+    Q_SLOT void testLayoutMetadata()
+    {
+        QDir dir(QString::fromLatin1(TEST_DATADIR) + "/languages", "*.xml");
+        QStringList expected_ids;
+        QHash<QString, QString> expected_titles;
+
+        Q_FOREACH (const QFileInfo &file_info, dir.entryInfoList()) {
+            QFile file(file_info.filePath());
+            QVERIFY(file.open(QIODevice::ReadOnly));
+
+            LayoutParser parser(&file);
+            QVERIFY(parser.parse());
+
+            const LayoutTreePtr tree(parser.tree());
+
+            if (not tree->string(tree->keyboard().language).isEmpty()) {
+                expected_ids.append(file_info.completeBaseName());
+            }
+            expected_titles.insert(file_info.completeBaseName(), tree->string(tree->keyboard().title));
+
+            // Reading only the root element gives the same title.
+            QVERIFY(file.seek(0));
+            LayoutParser header_parser(&file);
+            QVERIFY(header_parser.parseHeader());
+
+            const LayoutTreePtr header_tree(header_parser.tree());
+
+            QCOMPARE(header_tree->string(header_tree->keyboard().title),
+                     tree->string(tree->keyboard().title));
+            QCOMPARE(header_tree->keyboard().layouts.count, 0);
+        }
+
+        // The second loader gets the metadata from the cache written by the
+        // first one.
+        for (int iteration(0); iteration < 2; ++iteration) {
+            KeyboardLoader loader;
+
+            QCOMPARE(loader.ids(), expected_ids);
+            QVERIFY(QFile::exists(m_cache_dir.path() + "/layouts-metadata.cache"));
+
+            Q_FOREACH (const QString &id, expected_titles.keys()) {
+                QCOMPARE(loader.title(id), expected_titles.value(id));
+            }
+        }
+    }
+
+    Q_SLOT void testSharedImports()
+    {
+        SharedKeyboardLoader loader(getLoader("general_test1"));
+        SharedKeyboardLoader other_loader(getLoader("general_test1"));
+        const Keyboard symbols(loader->symbolsKeyboard(0));
+        const Keyboard other_symbols(other_loader->symbolsKeyboard(0));
+
+        QVERIFY(not symbols.keys.isEmpty());
+        COMPARE_KEYBOARDS(symbols, other_symbols);
+
+        // Imported layouts are built once and shared by all loaders.
+        QCOMPARE(symbols.keys.constData(), other_symbols.keys.constData());
+        QCOMPARE(loader->numberKeyboard().keys.constData(),
+                 other_loader->numberKeyboard().keys.constData());
+    }
+
+    Q_SLOT void testPrefetchNeighbours()
+    {
+        SharedKeyboardLoader loader(new KeyboardLoader);
+        const QStringList ids(loader->ids());
+
+        QVERIFY(ids.size() >= 3);
+
+        // The default layout of a new loader is neither loaded nor prefetched.
+        QCOMPARE(loader->prefetchHits(), 0);
+        QCOMPARE(loader->prefetchMisses(), 0);
+        QVERIFY(loader->prefetchedIds().isEmpty());
+
+        QSignalSpy prefetched_spy(loader.data(), SIGNAL(neighboursPrefetched()));
+
+        loader->setActiveId(ids.at(1));
+        QCOMPARE(loader->prefetchHits(), 0);
+        QCOMPARE(loader->prefetchMisses(), 1);
+
+        QVERIFY(prefetched_spy.wait());
+        QCOMPARE(loader->prefetchedIds().toSet(), QSet<QString>() << ids.at(0) << ids.at(2));
+
+        const Keyboard next_keyboard(loader->prefetchedKeyboard(ids.at(2)));
+
+        COMPARE_KEYBOARDS(loader->nextKeyboard(), next_keyboard);
+
+        loader->setActiveId(ids.at(2));
+        QCOMPARE(loader->prefetchHits(), 1);
+        QCOMPARE(loader->prefetchMisses(), 1);
+        COMPARE_KEYBOARDS(loader->keyboard(), next_keyboard);
+
+        // Going back reuses the views of the previously active layout.
+        QVERIFY(prefetched_spy.wait());
+        QVERIFY(loader->prefetchedIds().contains(ids.at(1)));
+
+        loader->setActiveId(ids.at(1));
+        QCOMPARE(loader->prefetchHits(), 2);
+        QCOMPARE(loader->prefetchMisses(), 1);
+    }
+
+    Q_SLOT void testSharedKeyboardLoader()
+    {
+        SharedKeyboardLoader loader(new KeyboardLoader);
+        Logic::SharedKeyAreaStorage storage(new Logic::KeyAreaStorage);
+        Logic::LayoutUpdater updater;
+        Logic::LayoutUpdater extended_updater;
+        Logic::LayoutHelper layout;
+        Logic::LayoutHelper extended_layout;
+        SharedStyle style(new Style);
+        const QStringList ids(loader->ids());
+
+        QVERIFY(ids.size() >= 2);
+
+        updater.setLayout(&layout);
+        extended_updater.setLayout(&extended_layout);
+        updater.setStyle(style);
+        extended_updater.setStyle(style);
+
+        updater.setKeyboardLoader(loader);
+        extended_updater.setKeyboardLoader(loader);
+        updater.setKeyAreaStorage(storage);
+        extended_updater.setKeyAreaStorage(storage);
+
+        QSignalSpy title_spy(&extended_updater, SIGNAL(keyboardTitleChanged(QString)));
+        const int misses(loader->prefetchMisses());
+
+        updater.setActiveKeyboardId(ids.at(1));
+        QCOMPARE(extended_updater.activeKeyboardId(), ids.at(1));
+        QCOMPARE(title_spy.count(), 1);
+        QCOMPARE(loader->prefetchMisses(), misses + 1);
+    }
 };
 
 QTEST_MAIN(TestLanguageLayoutLoading)
@@ -0,0 +1,20 @@
+include(../../config.pri)
+include(../common-check.pri)
+
+TOP_BUILDDIR = $${OUT_PWD}/../../..
+TARGET = layout-cache
+TEMPLATE = app
+QT = core testlib
+
+INCLUDEPATH += ../ ../../lib ../../
+LIBS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+PRE_TARGETDEPS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+
+include(../layout-data.pri)
+
+HEADERS += \
+
+SOURCES += \
+    main.cpp \
+
+include(../../word-prediction.pri)
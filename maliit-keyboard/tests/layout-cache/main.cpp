@@ -0,0 +1,195 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "models/key.h"
+#include "models/keyboard.h"
+#include "logic/keyboardloader.h"
+
+#include <QtCore>
+#include <QtTest>
+
+#include <utime.h>
+
+using namespace MaliitKeyboard;
+
+namespace {
+
+QStringList labels(const Keyboard &keyboard)
+{
+    QStringList result;
+
+    Q_FOREACH (const Key &key, keyboard.keys) {
+        result.append(key.label().text());
+    }
+
+    return result;
+}
+
+Key deadKey(const QString &accent)
+{
+    Key key;
+
+    key.rLabel().setText(accent);
+    return key;
+}
+
+} // unnamed namespace
+
+class TestLayoutCache
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    // The languages directory is read once per process, so every test in
+    // here works on the same temporary directory.
+    QTemporaryDir m_data_dir;
+    QTemporaryDir m_cache_dir;
+
+    QString languagePath(const QString &id) const
+    {
+        return m_data_dir.path() + "/languages/" + id + ".xml";
+    }
+
+    bool addLanguage(const QString &source_id,
+                     const QString &id)
+    {
+        QFile::remove(languagePath(id));
+        return QFile::copy(QString::fromLatin1(TEST_DATADIR) + "/languages/" + source_id + ".xml",
+                           languagePath(id));
+    }
+
+    bool setLastModified(const QString &id,
+                         const QDateTime &last_modified)
+    {
+        struct utimbuf times;
+
+        times.actime = last_modified.toTime_t();
+        times.modtime = last_modified.toTime_t();
+        return (utime(QFile::encodeName(languagePath(id)).constData(), &times) == 0);
+    }
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_data_dir.isValid());
+        QVERIFY(m_cache_dir.isValid());
+        QVERIFY(QDir(m_data_dir.path()).mkdir("languages"));
+        QVERIFY(qputenv("MALIIT_PLUGINS_DATADIR", m_data_dir.path().toUtf8()));
+        QVERIFY(qputenv("MALIIT_KEYBOARD_CACHEDIR", m_cache_dir.path().toUtf8()));
+    }
+
+    Q_SLOT void testParsedLayoutCache()
+    {
+        const QDateTime last_modified(QDateTime::currentDateTime().addSecs(-60));
+        const QStringList styling_labels(QStringList() << "a" << "b" << "c" << "d");
+
+        QVERIFY(addLanguage("styling_profile_test", "cache_test"));
+        QVERIFY(setLastModified("cache_test", last_modified));
+
+        {
+            KeyboardLoader loader;
+            loader.setActiveId("cache_test");
+            QCOMPARE(labels(loader.keyboard()), styling_labels);
+        }
+
+        // A file with the same modification time is not parsed again, even
+        // by another loader.
+        QVERIFY(addLanguage("extended_test", "cache_test"));
+        QVERIFY(setLastModified("cache_test", last_modified));
+
+        {
+            KeyboardLoader loader;
+            loader.setActiveId("cache_test");
+            QCOMPARE(labels(loader.keyboard()), styling_labels);
+        }
+
+        // Invalidating the cache parses it again.
+        KeyboardLoader loader;
+        loader.setActiveId("cache_test");
+
+        QSignalSpy changed_spy(&loader, SIGNAL(keyboardsChanged()));
+        loader.invalidateCache("cache_test");
+        QCOMPARE(changed_spy.count(), 1);
+
+        const QStringList extended_labels(labels(loader.keyboard()));
+        QVERIFY(extended_labels != styling_labels);
+
+        // So does a new modification time.
+        QVERIFY(addLanguage("styling_profile_test", "cache_test"));
+        QVERIFY(setLastModified("cache_test", last_modified.addSecs(10)));
+
+        KeyboardLoader other_loader;
+        other_loader.setActiveId("cache_test");
+        QCOMPARE(labels(other_loader.keyboard()), styling_labels);
+
+        // The active layout of a loader is only resolved when it is
+        // activated, so its views stay as they were.
+        QCOMPARE(labels(loader.keyboard()), extended_labels);
+    }
+
+    Q_SLOT void testViewsBuiltOnActivation()
+    {
+        const QStringList ids(QStringList() << "general_test1" << "general_test1_symbols"
+                                            << "general_test1_numbers" << "general_test1_phonenumbers");
+
+        Q_FOREACH (const QString &id, ids) {
+            QVERIFY(addLanguage(id, id));
+        }
+
+        KeyboardLoader loader;
+        loader.setActiveId("general_test1");
+
+        // All views, including the imported ones, were built on activation,
+        // so switching views works without the layout files.
+        Q_FOREACH (const QString &id, ids) {
+            QVERIFY(QFile::remove(languagePath(id)));
+        }
+
+        QCOMPARE(labels(loader.keyboard()), QStringList() << "q" << "w" << "p" << "a");
+        QCOMPARE(labels(loader.shiftedKeyboard()), QStringList() << "Q" << "W" << "p" << "a");
+        QCOMPARE(labels(loader.deadKeyboard(deadKey(QString::fromUtf8("´")))),
+                 QStringList() << "q" << "e" << "p" << "a");
+        QCOMPARE(labels(loader.deadKeyboard(deadKey("'"))), QStringList() << "q" << "t" << "p" << "a");
+        QCOMPARE(labels(loader.shiftedDeadKeyboard(deadKey(QString::fromUtf8("´")))),
+                 QStringList() << "Q" << "E" << "p" << "a");
+        QCOMPARE(labels(loader.shiftedDeadKeyboard(deadKey(";"))), QStringList() << "Q" << "r" << "p" << "a");
+        QCOMPARE(labels(loader.symbolsKeyboard(0)), QStringList() << "1" << "2");
+        QCOMPARE(labels(loader.symbolsKeyboard(1)), QStringList() << "3" << "4");
+        QCOMPARE(labels(loader.numberKeyboard()), QStringList() << "0" << "1" << "2" << "3");
+        QCOMPARE(labels(loader.phoneNumberKeyboard()), QStringList() << "9" << "8" << "7" << "6");
+
+        // Accents without a dead key view give the plain keyboard.
+        QCOMPARE(labels(loader.deadKeyboard(deadKey("x"))), QStringList() << "q" << "w" << "p" << "a");
+    }
+};
+
+QTEST_MAIN(TestLayoutCache)
+#include "main.moc"
@@ -0,0 +1,5 @@
+# Layouts and style profiles shared by the tests that load them.
+TEST_LAYOUT_DATA_DIR = $$PWD/language-layout-loading
+
+DEFINES += TEST_DATADIR=\\\"$$TEST_LAYOUT_DATA_DIR\\\"
+DEFINES += TEST_MALIIT_KEYBOARD_DATADIR=\\\"$$TEST_LAYOUT_DATA_DIR\\\"
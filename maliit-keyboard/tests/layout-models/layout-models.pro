@@ -0,0 +1,18 @@
+include(../../config.pri)
+include(../common-check.pri)
+
+TOP_BUILDDIR = $${OUT_PWD}/../../..
+TARGET = layout-models
+TEMPLATE = app
+QT = core testlib
+
+INCLUDEPATH += ../ ../../lib ../../
+LIBS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+PRE_TARGETDEPS += $${TOP_BUILDDIR}/$${MALIIT_KEYBOARD_LIB}
+
+HEADERS += \
+
+SOURCES += \
+    main.cpp \
+
+include(../../word-prediction.pri)
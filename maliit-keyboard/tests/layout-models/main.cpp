@@ -0,0 +1,409 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "models/key.h"
+#include "models/keyarea.h"
+#include "models/font.h"
+#include "models/layout.h"
+#include "logic/layouthelper.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+
+Q_DECLARE_METATYPE(KeyArea)
+
+namespace {
+
+Key createKey(const QString &text,
+              Key::Action action = Key::ActionInsert)
+{
+    Key key;
+
+    key.rLabel().setText(text);
+    key.setAction(action);
+
+    return key;
+}
+
+//! Keys of one row, 10x10 each, laid out from left to right.
+QVector<Key> createKeys(const QStringList &labels)
+{
+    QVector<Key> keys;
+
+    for (int index = 0; index < labels.count(); ++index) {
+        Key key(createKey(labels.at(index)));
+
+        key.setOrigin(QPoint(index * 10, 0));
+        key.rArea().setSize(QSize(10, 10));
+        keys.append(key);
+    }
+
+    return keys;
+}
+
+//! A key area just large enough for keys created by createKeys().
+KeyArea createKeyArea(const QVector<Key> &keys)
+{
+    KeyArea key_area;
+    Area area;
+
+    area.setSize(QSize(keys.count() * 10, 10));
+    key_area.setArea(area);
+    key_area.setKeys(keys);
+
+    return key_area;
+}
+
+} // unnamed namespace
+
+class TestLayoutModels
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    Q_SLOT void initTestCase()
+    {
+        qRegisterMetaType<Key>("Key");
+        qRegisterMetaType<KeyArea>("KeyArea");
+    }
+
+    Q_SLOT void testKeyAreaContentId()
+    {
+        QCOMPARE(KeyArea().contentId(), 0);
+        QVERIFY(KeyArea() == KeyArea());
+
+        const QVector<Key> keys(createKeys(QStringList() << "a"));
+        KeyArea key_area(createKeyArea(keys));
+        QVERIFY(key_area.contentId() != 0);
+
+        // Copies share the id, origin is not part of the content.
+        KeyArea copy(key_area);
+        copy.setOrigin(QPoint(10, 10));
+        QCOMPARE(copy.contentId(), key_area.contentId());
+        QVERIFY(copy == key_area);
+
+        // Different ids compare unequal without looking at the content.
+        copy.setKeys(keys);
+        QVERIFY(copy.contentId() != key_area.contentId());
+        QVERIFY(copy != key_area);
+
+        // Untracked content is compared in full.
+        copy.rKeys()[0].rLabel().setText("b");
+        QVERIFY(copy != key_area);
+        copy.rKeys()[0].rLabel().setText("a");
+        QVERIFY(copy == key_area);
+
+        // Handing out a mutable reference drops the id, so that changes made
+        // through a kept reference are still seen.
+        KeyArea edited(key_area);
+        QVector<Key> &edited_keys(edited.rKeys());
+        QCOMPARE(edited.contentId(), 0);
+
+        const KeyArea before_edit(edited);
+        edited_keys[0].rLabel().setText("c");
+        QVERIFY(before_edit != edited);
+        QVERIFY(before_edit == key_area);
+    }
+
+    Q_SLOT void testKeyImplicitSharing()
+    {
+        QVERIFY(Key() == Key());
+        QCOMPARE(Key().action(), Key::ActionInsert);
+        QCOMPARE(Key().extendedKeysId(), -1);
+        QCOMPARE(Font().stretch(), 100);
+
+        Key key(createKey("a"));
+        key.rArea().setSize(QSize(10, 20));
+
+        // Writing to a copy must not leak into the original, and vice versa.
+        Key copy(key);
+        QVERIFY(copy == key);
+        copy.rLabel().setText("b");
+        copy.setAction(Key::ActionShift);
+        QCOMPARE(key.label().text(), QString("a"));
+        QCOMPARE(key.action(), Key::ActionInsert);
+        QCOMPARE(copy.label().text(), QString("b"));
+
+        key.rArea().setSize(QSize(30, 40));
+        QCOMPARE(copy.area().size(), QSize(10, 20));
+
+        // Default constructed keys share data, but still detach on write.
+        Key empty;
+        empty.rLabel().setText("c");
+        QVERIFY(Key().label().text().isEmpty());
+
+        Font font;
+        QVERIFY(font == Font());
+        font.setSize(12);
+        QVERIFY(font != Font());
+        Font font_copy(font);
+        QVERIFY(font_copy == font);
+        font_copy.setSize(14);
+        QCOMPARE(font.size(), 12);
+        QVERIFY(font_copy != font);
+    }
+
+    Q_SLOT void testLayoutIncrementalUpdates()
+    {
+        QVector<Key> keys(createKeys(QStringList() << "a" << "b" << "c"));
+
+        Model::Layout layout;
+        QSignalSpy reset_spy(&layout, SIGNAL(modelReset()));
+        QSignalSpy inserted_spy(&layout, SIGNAL(rowsInserted(QModelIndex,int,int)));
+        QSignalSpy removed_spy(&layout, SIGNAL(rowsRemoved(QModelIndex,int,int)));
+        QSignalSpy changed_spy(&layout, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+        KeyArea key_area(createKeyArea(keys));
+        layout.setKeyArea(key_area);
+        QCOMPARE(layout.rowCount(), 3);
+        QCOMPARE(inserted_spy.count(), 1);
+        QCOMPARE(inserted_spy.first().at(1).toInt(), 0);
+        QCOMPARE(inserted_spy.first().at(2).toInt(), 2);
+        QCOMPARE(changed_spy.count(), 0);
+
+        // Same area again: nothing to report.
+        layout.setKeyArea(key_area);
+        QCOMPARE(changed_spy.count(), 0);
+
+        // Shift toggle: only the text of the first two keys changes.
+        keys[0].rLabel().setText("A");
+        keys[1].rLabel().setText("B");
+        key_area.setKeys(keys);
+        layout.setKeyArea(key_area);
+        QCOMPARE(changed_spy.count(), 1);
+        QCOMPARE(changed_spy.first().at(0).value<QModelIndex>().row(), 0);
+        QCOMPARE(changed_spy.first().at(1).value<QModelIndex>().row(), 1);
+        QCOMPARE(changed_spy.first().at(2).value<QVector<int> >(),
+                 QVector<int>() << Model::Layout::RoleKeyText);
+        QCOMPARE(layout.data(0, "key_text").toString(), QString("A"));
+
+        // Fewer keys: trailing rows are removed.
+        keys.remove(2);
+        key_area.setKeys(keys);
+        layout.setKeyArea(key_area);
+        QCOMPARE(layout.rowCount(), 2);
+        QCOMPARE(removed_spy.count(), 1);
+        QCOMPARE(removed_spy.first().at(1).toInt(), 2);
+        QCOMPARE(removed_spy.first().at(2).toInt(), 2);
+
+        changed_spy.clear();
+        layout.setImageDirectory("/tmp");
+        QCOMPARE(changed_spy.count(), 1);
+        QCOMPARE(changed_spy.first().at(2).value<QVector<int> >(),
+                 QVector<int>() << Model::Layout::RoleKeyBackground
+                                << Model::Layout::RoleKeyIcon);
+
+        QCOMPARE(reset_spy.count(), 0);
+    }
+
+    Q_SLOT void testKeyOverridePatch()
+    {
+        QVector<Key> keys(createKeys(QStringList() << "a" << "" << "b"));
+        keys[1].setAction(Key::ActionReturn);
+
+        Logic::LayoutHelper helper;
+        helper.setCenterPanel(createKeyArea(keys));
+
+        QSignalSpy panel_spy(&helper, SIGNAL(centerPanelChanged(KeyArea,Logic::KeyOverrides)));
+        QSignalSpy key_spy(&helper, SIGNAL(centerPanelKeyChanged(int,Key)));
+
+        Logic::KeyOverrides overrides;
+        overrides.insert("actionKey", createKey("Go"));
+        helper.onKeysOverriden(overrides, false);
+
+        // Only the return key is patched, the panel is not re-emitted.
+        QCOMPARE(panel_spy.count(), 0);
+        QCOMPARE(key_spy.count(), 1);
+        QCOMPARE(key_spy.first().at(0).toInt(), 1);
+        const Key &patched(key_spy.first().at(1).value<Key>());
+        QCOMPARE(patched.label().text(), QString("Go"));
+        QCOMPARE(patched.action(), Key::ActionReturn);
+
+        // Unchanged overrides do not emit anything.
+        key_spy.clear();
+        helper.onKeysOverriden(overrides, true);
+        QCOMPARE(key_spy.count(), 0);
+
+        // A new panel, e.g. after a shift toggle, keeps the override.
+        keys[0].rLabel().setText("A");
+        keys[2].rLabel().setText("B");
+        helper.setCenterPanel(createKeyArea(keys));
+        QCOMPARE(panel_spy.count(), 1);
+        const KeyArea &emitted(panel_spy.first().at(0).value<KeyArea>());
+        QCOMPARE(emitted.keys().at(0).label().text(), QString("A"));
+        QCOMPARE(emitted.keys().at(1).label().text(), QString("Go"));
+        QVERIFY(helper.centerPanel().keys().at(1).label().text().isEmpty());
+        QCOMPARE(helper.panelKey(Logic::LayoutHelper::CenterPanel, 1).label().text(), QString("Go"));
+        QCOMPARE(helper.panelKey(Logic::LayoutHelper::CenterPanel, 0).label().text(), QString("A"));
+
+        // Removing the override restores the original key.
+        helper.onKeysOverriden(Logic::KeyOverrides(), false);
+        QCOMPARE(key_spy.count(), 1);
+        QVERIFY(key_spy.first().at(1).value<Key>().label().text().isEmpty());
+        QVERIFY(helper.panelKey(Logic::LayoutHelper::CenterPanel, 1).label().text().isEmpty());
+    }
+
+    Q_SLOT void testActiveKeys()
+    {
+        QVector<Key> keys(createKeys(QStringList() << "a" << "b" << "c"));
+
+        Logic::LayoutHelper helper;
+        helper.setCenterPanel(createKeyArea(keys));
+        helper.setActivePanel(Logic::LayoutHelper::CenterPanel);
+
+        QSignalSpy added_spy(&helper, SIGNAL(activeKeyAdded(Panel,int)));
+        QSignalSpy removed_spy(&helper, SIGNAL(activeKeyRemoved(Panel,int)));
+
+        // Nothing active, nothing to clear.
+        helper.clearActiveKeys();
+        QCOMPARE(removed_spy.count(), 0);
+
+        // Keys are found by origin, even if modified (e.g. pressed state).
+        Key pressed(keys.at(2));
+        pressed.rArea().setBackground("pressed.png");
+        helper.appendActiveKey(pressed);
+        helper.appendActiveKey(keys.at(0));
+        helper.appendActiveKey(keys.at(0));
+        QCOMPARE(added_spy.count(), 2);
+        QCOMPARE(added_spy.at(0).at(1).toInt(), 2);
+        QCOMPARE(added_spy.at(1).at(1).toInt(), 0);
+        QVERIFY(helper.isActiveKey(Logic::LayoutHelper::CenterPanel, 2));
+        QVERIFY(not helper.isActiveKey(Logic::LayoutHelper::CenterPanel, 1));
+        QCOMPARE(helper.activeKeys().count(), 2);
+        QCOMPARE(helper.activeKeys().first().area().background(), QByteArray("pressed.png"));
+
+        helper.removeActiveKey(keys.at(2));
+        helper.removeActiveKey(keys.at(1));
+        QCOMPARE(removed_spy.count(), 1);
+        QCOMPARE(removed_spy.first().at(1).toInt(), 2);
+
+        // Held keys survive a panel change if a key remains at their position.
+        keys[0].rLabel().setText("A");
+        helper.setCenterPanel(createKeyArea(keys));
+        QVERIFY(helper.isActiveKey(Logic::LayoutHelper::CenterPanel, 0));
+
+        removed_spy.clear();
+        helper.clearActiveKeys();
+        QCOMPARE(removed_spy.count(), 1);
+        QVERIFY(helper.activeKeys().isEmpty());
+
+        // Held keys without a key at their position in the new panel are
+        // dropped, and reported as removed.
+        helper.appendActiveKey(keys.at(0));
+        helper.appendActiveKey(keys.at(2));
+        removed_spy.clear();
+        helper.setCenterPanel(createKeyArea(keys.mid(0, 2)));
+        QCOMPARE(removed_spy.count(), 1);
+        QCOMPARE(removed_spy.first().at(1).toInt(), 2);
+        QVERIFY(helper.isActiveKey(Logic::LayoutHelper::CenterPanel, 0));
+        QCOMPARE(helper.activeKeys().count(), 1);
+    }
+
+    Q_SLOT void testMagnifierKeyArea()
+    {
+        Key key(createKey("a"));
+        key.setOrigin(QPoint(20, 30));
+        key.rArea().setSize(QSize(40, 50));
+        key.rArea().setBackground("magnifier.png");
+
+        const KeyArea &area(Logic::LayoutHelper::magnifierKeyArea(key));
+        QCOMPARE(area.origin(), QPoint(20, 30));
+        QCOMPARE(area.area().background(), QByteArray("magnifier.png"));
+        QCOMPARE(area.keys().count(), 1);
+        QCOMPARE(area.keys().first().origin(), QPoint());
+        QVERIFY(area.keys().first().area().background().isEmpty());
+
+        Logic::LayoutHelper helper;
+        QSignalSpy spy(&helper, SIGNAL(magnifierChanged(KeyArea)));
+
+        // Showing the same precomputed magnifier again is a no-op.
+        helper.setMagnifier(area);
+        helper.setMagnifier(area);
+        QCOMPARE(spy.count(), 1);
+        QVERIFY(helper.magnifierKey() == key);
+
+        helper.clearMagnifierKey();
+        helper.clearMagnifierKey();
+        QCOMPARE(spy.count(), 2);
+    }
+
+    Q_SLOT void testLayoutHelperUpdate()
+    {
+        Logic::LayoutHelper helper;
+        QSignalSpy center_spy(&helper, SIGNAL(centerPanelChanged(KeyArea,Logic::KeyOverrides)));
+        QSignalSpy ribbon_spy(&helper, SIGNAL(wordRibbonChanged(WordRibbon)));
+
+        const KeyArea lower(createKeyArea(createKeys(QStringList() << "a")));
+        const KeyArea upper(createKeyArea(createKeys(QStringList() << "A")));
+
+        // Nested updates only emit once the outermost one is committed, and
+        // only the latest value.
+        helper.beginUpdate();
+        helper.setCenterPanel(lower);
+        helper.beginUpdate();
+        helper.setCenterPanel(upper);
+        helper.setWordRibbon(WordRibbon());
+        helper.commitUpdate();
+        QVERIFY(helper.isUpdating());
+        QCOMPARE(center_spy.count(), 0);
+        helper.commitUpdate();
+        QVERIFY(not helper.isUpdating());
+        QCOMPARE(center_spy.count(), 1);
+        QCOMPARE(ribbon_spy.count(), 0);
+        QCOMPARE(helper.centerPanel().keys().first().label().text(), QString("A"));
+
+        // Outside of updates, changes are emitted right away.
+        helper.setCenterPanel(lower);
+        QCOMPARE(center_spy.count(), 2);
+
+        // Overrides arriving while a panel is pending are part of the panel
+        // emitted on commit.
+        QVector<Key> keys(createKeys(QStringList() << ""));
+        keys[0].setAction(Key::ActionReturn);
+        Logic::KeyOverrides overrides;
+        overrides.insert("actionKey", createKey("Go"));
+
+        helper.beginUpdate();
+        helper.setCenterPanel(createKeyArea(keys));
+        helper.onKeysOverriden(overrides, false);
+        helper.commitUpdate();
+        QCOMPARE(center_spy.count(), 3);
+        QCOMPARE(center_spy.last().at(0).value<KeyArea>().keys().first().label().text(),
+                 QString("Go"));
+    }
+};
+
+QTEST_MAIN(TestLayoutModels)
+#include "main.moc"
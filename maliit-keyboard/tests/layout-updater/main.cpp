@@ -0,0 +1,161 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "models/keyarea.h"
+#include "logic/keyboardloader.h"
+#include "logic/layouthelper.h"
+#include "logic/layoutupdater.h"
+#include "logic/style.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+using namespace MaliitKeyboard::Logic;
+
+class TestLayoutUpdater
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    // The data directories are read once per process, so every test in
+    // here works on the same temporary directories.
+    QTemporaryDir m_data_dir;
+    QTemporaryDir m_cache_dir;
+
+    bool addFile(const QString &source_path,
+                 const QString &path)
+    {
+        return QFile::copy(QString::fromLatin1(TEST_DATADIR) + "/" + source_path,
+                           m_data_dir.path() + "/" + path);
+    }
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_data_dir.isValid());
+        QVERIFY(m_cache_dir.isValid());
+
+        QDir data_dir(m_data_dir.path());
+        QVERIFY(data_dir.mkpath("languages"));
+        QVERIFY(data_dir.mkpath("styles/test-profile"));
+        QVERIFY(data_dir.mkpath("styles/other-profile"));
+
+        Q_FOREACH (const QString &id, QStringList() << "general_test1" << "general_test1_symbols"
+                                                    << "general_test1_numbers" << "general_test1_phonenumbers") {
+            QVERIFY(addFile("languages/" + id + ".xml", "languages/" + id + ".xml"));
+        }
+
+        // A second profile, which differs from the first by its name only.
+        QVERIFY(addFile("styles/test-profile/main.ini", "styles/test-profile/main.ini"));
+        QVERIFY(addFile("styles/test-profile/main.ini", "styles/other-profile/main.ini"));
+
+        QVERIFY(qputenv("MALIIT_PLUGINS_DATADIR", m_data_dir.path().toUtf8()));
+        QVERIFY(qputenv("MALIIT_KEYBOARD_DATADIR", m_data_dir.path().toUtf8()));
+        QVERIFY(qputenv("MALIIT_KEYBOARD_CACHEDIR", m_cache_dir.path().toUtf8()));
+    }
+
+    Q_SLOT void testKeyAreaCache()
+    {
+        LayoutHelper layout;
+        LayoutUpdater updater;
+        SharedStyle style(new Style);
+
+        layout.setScreenSize(QSize(854, 480));
+        style->setProfile("test-profile");
+        updater.setLayout(&layout);
+        updater.setStyle(style);
+        updater.setKeyboardLoader(SharedKeyboardLoader(new KeyboardLoader));
+        updater.setActiveKeyboardId("general_test1");
+
+        const KeyArea main_key_area(layout.centerPanel());
+        QVERIFY(main_key_area.hasKeys());
+        QVERIFY(main_key_area.contentId() != 0);
+
+        // Toggling shift switches between the cached main and shifted key
+        // areas without converting them again.
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftPressed"));
+        const KeyArea shifted_key_area(layout.centerPanel());
+        QVERIFY(shifted_key_area.hasKeys());
+        QVERIFY(shifted_key_area.contentId() != main_key_area.contentId());
+
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftCancelled"));
+        QCOMPARE(layout.centerPanel().contentId(), main_key_area.contentId());
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftPressed"));
+        QCOMPARE(layout.centerPanel().contentId(), shifted_key_area.contentId());
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftCancelled"));
+
+        // Symbol pages are cached by variant.
+        QVERIFY(QMetaObject::invokeMethod(&updater, "symKeyReleased"));
+        const KeyArea symbols_key_area(layout.centerPanel());
+        QVERIFY(symbols_key_area.hasKeys());
+
+        QVERIFY(QMetaObject::invokeMethod(&updater, "symKeyReleased"));
+        QCOMPARE(layout.centerPanel().contentId(), main_key_area.contentId());
+        QVERIFY(QMetaObject::invokeMethod(&updater, "symKeyReleased"));
+        QCOMPARE(layout.centerPanel().contentId(), symbols_key_area.contentId());
+        QVERIFY(QMetaObject::invokeMethod(&updater, "symKeyReleased"));
+
+        // Turning back to an orientation finds its key areas in the key area
+        // storage.
+        updater.setOrientation(LayoutHelper::Portrait);
+        const KeyArea portrait_key_area(layout.centerPanel());
+        QVERIFY(portrait_key_area.hasKeys());
+        QVERIFY(portrait_key_area.contentId() != main_key_area.contentId());
+
+        updater.setOrientation(LayoutHelper::Landscape);
+        QCOMPARE(layout.centerPanel().contentId(), main_key_area.contentId());
+        updater.setOrientation(LayoutHelper::Portrait);
+        QCOMPARE(layout.centerPanel().contentId(), portrait_key_area.contentId());
+        updater.setOrientation(LayoutHelper::Landscape);
+
+        // Another style profile needs new key areas, even if its attributes
+        // are the same.
+        style->setProfile("other-profile");
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftPressed"));
+        QVERIFY(layout.centerPanel().contentId() != shifted_key_area.contentId());
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftCancelled"));
+
+        const KeyArea other_profile_key_area(layout.centerPanel());
+        QVERIFY(other_profile_key_area.hasKeys());
+        QVERIFY(other_profile_key_area.contentId() != main_key_area.contentId());
+
+        // So does another screen size.
+        layout.setScreenSize(QSize(1280, 720));
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftPressed"));
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftCancelled"));
+        QVERIFY(layout.centerPanel().hasKeys());
+        QVERIFY(layout.centerPanel().contentId() != other_profile_key_area.contentId());
+    }
+};
+
+QTEST_MAIN(TestLayoutUpdater)
+#include "main.moc"
@@ -0,0 +1,179 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include "logic/layoutupdater.h"
+#include "logic/state-machines/shiftmachine.h"
+#include "logic/state-machines/viewmachine.h"
+#include "logic/state-machines/deadkeymachine.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+using namespace MaliitKeyboard::Logic;
+
+class TestStateMachines
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    // Drive the QStateMachine reference implementation:
+    Q_SIGNAL void shiftPressed();
+    Q_SIGNAL void shiftCancelled();
+
+    Q_SLOT void testShiftMachine()
+    {
+        LayoutUpdater updater;
+        ShiftMachine machine;
+        QCOMPARE(machine.state(), -1);
+
+        // Setting up starts the machine right away:
+        machine.setup(&updater);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::NoShiftState));
+        QVERIFY(machine.inState(ShiftMachine::no_shift_state));
+
+        // Signals of the updater are mapped to their events:
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftPressed"));
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::LatchedShiftState));
+        QVERIFY(QMetaObject::invokeMethod(&updater, "shiftCancelled"));
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::NoShiftState));
+
+        // Transitions happen right away, without an event loop:
+        machine.processEvent(ShiftMachine::ShiftPressedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::LatchedShiftState));
+        QVERIFY(machine.inState(ShiftMachine::latched_shift_state));
+
+        machine.processEvent(ShiftMachine::ShiftReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::CapsLockState));
+
+        // No transition for this event in caps lock:
+        machine.processEvent(ShiftMachine::ShiftCancelledEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::CapsLockState));
+
+        machine.processEvent(ShiftMachine::ShiftReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::NoShiftState));
+
+        machine.processEvent(ShiftMachine::AutoCapsActivatedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::LatchedShiftState));
+        machine.restart();
+        QCOMPARE(machine.state(), static_cast<int>(ShiftMachine::NoShiftState));
+    }
+
+    Q_SLOT void testViewMachine()
+    {
+        LayoutUpdater updater;
+        ViewMachine machine;
+        machine.setup(&updater);
+        QVERIFY(machine.inState(ViewMachine::main_state));
+
+        machine.processEvent(ViewMachine::SymSwitcherReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ViewMachine::MainState));
+
+        machine.processEvent(ViewMachine::SymKeyReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ViewMachine::Symbols0State));
+
+        machine.processEvent(ViewMachine::SymSwitcherReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ViewMachine::Symbols1State));
+
+        machine.processEvent(ViewMachine::SymKeyReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(ViewMachine::MainState));
+    }
+
+    Q_SLOT void testDeadkeyMachine()
+    {
+        LayoutUpdater updater;
+        DeadkeyMachine machine;
+        machine.setup(&updater);
+        QVERIFY(machine.inState(DeadkeyMachine::no_deadkey_state));
+
+        machine.processEvent(DeadkeyMachine::DeadkeyPressedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(DeadkeyMachine::DeadkeyState));
+
+        machine.processEvent(DeadkeyMachine::DeadkeyReleasedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(DeadkeyMachine::LatchedDeadkeyState));
+
+        machine.processEvent(DeadkeyMachine::DeadkeyPressedEvent);
+        QCOMPARE(machine.state(), static_cast<int>(DeadkeyMachine::NoDeadkeyState));
+    }
+
+    Q_SLOT void benchmarkShiftToggle()
+    {
+        LayoutUpdater updater;
+        ShiftMachine machine;
+        machine.setup(&updater);
+
+        QBENCHMARK {
+            machine.processEvent(ShiftMachine::ShiftPressedEvent);
+            machine.processEvent(ShiftMachine::ShiftCancelledEvent);
+        }
+
+        QVERIFY(machine.inState(ShiftMachine::no_shift_state));
+    }
+
+    // The QStateMachine based shift machine this replaces, for comparison.
+    // Like the keyboard did, wait for the state change before toggling back.
+    Q_SLOT void benchmarkShiftToggleQStateMachine()
+    {
+        QStateMachine machine;
+        QState *no_shift = new QState;
+        QState *latched_shift = new QState;
+        machine.addState(no_shift);
+        machine.addState(latched_shift);
+        machine.setInitialState(no_shift);
+
+        no_shift->setObjectName(ShiftMachine::no_shift_state);
+        latched_shift->setObjectName(ShiftMachine::latched_shift_state);
+        no_shift->addTransition(this, SIGNAL(shiftPressed()), latched_shift);
+        latched_shift->addTransition(this, SIGNAL(shiftCancelled()), no_shift);
+
+        machine.start();
+        QTRY_VERIFY(machine.configuration().contains(no_shift));
+
+        QBENCHMARK {
+            Q_EMIT shiftPressed();
+
+            while (not machine.configuration().contains(latched_shift)) {
+                QCoreApplication::processEvents();
+            }
+
+            Q_EMIT shiftCancelled();
+
+            while (not machine.configuration().contains(no_shift)) {
+                QCoreApplication::processEvents();
+            }
+        }
+    }
+};
+
+QTEST_MAIN(TestStateMachines)
+#include "main.moc"
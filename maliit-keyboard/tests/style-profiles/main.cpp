@@ -0,0 +1,186 @@
+/*
+ * This file is part of Maliit Plugins
+ *
+ * Copyright (C) 2013 Canonical Ltd
+ *
+ * Contact: maliit-discuss@lists.maliit.org
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * Redistributions of source code must retain the above copyright notice, this list
+ * of conditions and the following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list
+ * of conditions and the following disclaimer in the documentation and/or other materials
+ * provided with the distribution.
+ * Neither the name of Nokia Corporation nor the names of its contributors may be
+ * used to endorse or promote products derived from this software without specific
+ * prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "layoutdata.h"
+
+#include "models/key.h"
+#include "models/keydescription.h"
+#include "models/styleattributes.h"
+#include "models/stylebundle.h"
+#include "logic/style.h"
+#include "logic/layouthelper.h"
+
+#include <QtCore>
+#include <QtTest>
+
+using namespace MaliitKeyboard;
+
+class TestStyleProfiles
+    : public QObject
+{
+    Q_OBJECT
+
+private:
+    QTemporaryDir m_cache_dir;
+
+    Q_SLOT void initTestCase()
+    {
+        QVERIFY(m_cache_dir.isValid());
+        QVERIFY(TestUtils::useLayoutTestData(m_cache_dir.path()));
+    }
+
+    Q_SLOT void testStyleSnapshot()
+    {
+        Style style;
+        style.setProfile("test-profile");
+        StyleAttributes *attributes = style.attributes();
+
+        const Logic::LayoutHelper::Orientation orientations[] = {
+            Logic::LayoutHelper::Landscape, Logic::LayoutHelper::Portrait
+        };
+
+        for (int o = 0; o < 2; ++o) {
+            const Logic::LayoutHelper::Orientation orientation(orientations[o]);
+            // Unknown style names resolve to the 'default' section.
+            attributes->setStyleName("no-such-style");
+            const StyleSnapshot &snapshot(attributes->snapshot("no-such-style", orientation));
+
+            QCOMPARE(snapshot.font.name(), attributes->fontName(orientation));
+            QCOMPARE(snapshot.font.size(), static_cast<int>(attributes->fontSize(orientation)));
+            QCOMPARE(snapshot.small_font.size(), static_cast<int>(attributes->smallFontSize(orientation)));
+            QCOMPARE(snapshot.key_widths[KeyDescription::Medium],
+                     attributes->keyWidth(orientation, KeyDescription::Medium));
+            QCOMPARE(snapshot.key_widths[KeyDescription::XLarge],
+                     attributes->keyWidth(orientation, KeyDescription::XLarge));
+            QCOMPARE(snapshot.key_backgrounds[Key::StyleSpecialKey][KeyDescription::PressedState],
+                     attributes->keyBackground(Key::StyleSpecialKey, KeyDescription::PressedState));
+            QCOMPARE(snapshot.icons[KeyDescription::ShiftIcon][KeyDescription::NormalState],
+                     attributes->icon(KeyDescription::ShiftIcon, KeyDescription::NormalState));
+            QCOMPARE(snapshot.custom_icons.value("square-smiley"), attributes->customIcon("square-smiley"));
+            QCOMPARE(snapshot.key_background_borders, attributes->keyBackgroundBorders());
+            QCOMPARE(snapshot.key_area_width, attributes->keyAreaWidth(orientation));
+            QCOMPARE(snapshot.key_margin, attributes->keyMargin(orientation));
+            QCOMPARE(snapshot.key_area_padding, attributes->keyAreaPadding(orientation));
+            QCOMPARE(snapshot.word_ribbon_height, attributes->wordRibbonHeight(orientation));
+        }
+
+        QCOMPARE(attributes->snapshot("no-such-style", Logic::LayoutHelper::Portrait).key_area_width, 480.0);
+    }
+
+    Q_SLOT void testStyleAttributesCache()
+    {
+        const Logic::LayoutHelper::Orientation orientation(Logic::LayoutHelper::Portrait);
+        Style style;
+        style.setProfile("test-profile");
+        StyleAttributes *attributes = style.attributes();
+        attributes->setStyleName("keys-cache-test");
+
+        const int hits(attributes->cacheHits());
+        const int misses(attributes->cacheMisses());
+
+        QCOMPARE(attributes->keyHeight(orientation), 80.0);
+        QCOMPARE(attributes->cacheMisses(), misses + 1);
+        QCOMPARE(attributes->keyHeight(orientation), 80.0);
+        QCOMPARE(attributes->cacheHits(), hits + 1);
+
+        // Values are cached per style, so switching between styles, as done
+        // for each converted view, keeps them. The sections of the profile
+        // were already looked up for the style snapshots.
+        attributes->setStyleName("default");
+        QCOMPARE(attributes->keyHeight(orientation), 80.0);
+        QCOMPARE(attributes->keyBackgroundBorders(), QMargins(2, 2, 2, 2));
+        QCOMPARE(attributes->cacheHits(), hits + 3);
+
+        attributes->setStyleName("keys-cache-test");
+        QCOMPARE(attributes->keyHeight(orientation), 80.0);
+        QCOMPARE(attributes->cacheHits(), hits + 4);
+        QCOMPARE(attributes->cacheMisses(), misses + 1);
+    }
+
+    Q_SLOT void testStyleBundle()
+    {
+        const QString main_file_name(QString::fromLatin1(TEST_MALIIT_KEYBOARD_DATADIR)
+                                     + "/styles/test-profile/main.ini");
+        const QSettings settings(main_file_name, QSettings::IniFormat);
+
+        StyleBundleWriter writer;
+        writer.addTable(StyleBundleWriter::MainTable, settings);
+        writer.addAssets(StyleBundleWriter::ImageAsset, QStringList() << "background.png" << "key-background.png");
+        const QByteArray source_hash(StyleBundle::hashSources(QStringList() << main_file_name));
+        writer.setSourceHash(source_hash);
+
+        const SharedStyleBundle bundle(new StyleBundle(writer.data()));
+        QVERIFY(bundle->isValid());
+        QCOMPARE(bundle->sourceHash(), source_hash);
+        QCOMPARE(bundle->keys(StyleBundle::MainTable).size(), settings.allKeys().size());
+        QVERIFY(bundle->keys(StyleBundle::ExtendedKeysTable).isEmpty());
+        QCOMPARE(bundle->assets(StyleBundle::ImageAsset),
+                 QStringList() << "background.png" << "key-background.png");
+        QVERIFY(bundle->assets(StyleBundle::SoundAsset).isEmpty());
+        QCOMPARE(bundle->value(StyleBundle::MainTable, "default/portrait/key-height").toReal(), 80.0);
+        QCOMPARE(bundle->value(StyleBundle::MainTable, "icon/shift").toString(), QString("shift-icon.png"));
+        QVERIFY(not bundle->value(StyleBundle::MainTable, "icon/no-such-icon").isValid());
+
+        StyleAttributes ini_attributes(new QSettings(main_file_name, QSettings::IniFormat));
+        StyleAttributes bundle_attributes(bundle, StyleBundle::MainTable);
+
+        for (int o = 0; o < 2; ++o) {
+            const Logic::LayoutHelper::Orientation orientation(static_cast<Logic::LayoutHelper::Orientation>(o));
+
+            QCOMPARE(bundle_attributes.fontSize(orientation), ini_attributes.fontSize(orientation));
+            QCOMPARE(bundle_attributes.fontColor(orientation), ini_attributes.fontColor(orientation));
+            QCOMPARE(bundle_attributes.keyWidth(orientation, KeyDescription::Large),
+                     ini_attributes.keyWidth(orientation, KeyDescription::Large));
+            QCOMPARE(bundle_attributes.keyAreaWidth(orientation), ini_attributes.keyAreaWidth(orientation));
+        }
+
+        QCOMPARE(bundle_attributes.keyBackground(Key::StyleNormalKey, KeyDescription::PressedState),
+                 ini_attributes.keyBackground(Key::StyleNormalKey, KeyDescription::PressedState));
+        QCOMPARE(bundle_attributes.keyBackgroundBorders(), ini_attributes.keyBackgroundBorders());
+        QCOMPARE(bundle_attributes.customIcon("square-smiley"), ini_attributes.customIcon("square-smiley"));
+        QCOMPARE(bundle_attributes.keyPressSound(), ini_attributes.keyPressSound());
+
+        // Source hashes depend on the contents only, not on file times.
+        QTemporaryDir copy_dir;
+        QVERIFY(copy_dir.isValid());
+        const QString copy_file_name(copy_dir.path() + "/main.ini");
+        QVERIFY(QFile::copy(main_file_name, copy_file_name));
+        QCOMPARE(StyleBundle::hashSources(QStringList() << copy_file_name), source_hash);
+        QVERIFY(StyleBundle::hashSources(QStringList() << copy_file_name << copy_file_name)
+                != source_hash);
+
+        // Not a bundle.
+        QVERIFY(not StyleBundle(QByteArray("MKSB")).isValid());
+    }
+};
+
+QTEST_MAIN(TestStyleProfiles)
+#include "main.moc"
@@ -7,6 +7,13 @@ SUBDIRS = \
     repeat-backspace \
     word-candidates \
     language-layout-loading \
+    language-index \
+    layout-models \
+    state-machines \
+    style-profiles \
+    key-area-storage \
+    layout-updater \
+    layout-cache \
 
 CONFIG += ordered
 QMAKE_EXTRA_TARGETS += check
@@ -18,6 +18,8 @@ include(config.pri)
         \\n\\t nodoc: Do not build documentation \
         \\n\\t disable-maliit-keyboard: Do not build the C++ reference keyboard (Maliit Keyboard) \
         \\n\\t disable-nemo-keyboard: Do not build the QML reference keyboard (Nemo Keyboard) \
+        \\n\\t disable-compiled-layouts: Do not compile the language layouts into a binary image (maliit-keyboard-plugin only) \
+        \\n\\t disable-compiled-styles: Do not compile the style profiles into binary bundles (maliit-keyboard-plugin only) \
         \\n\\t disable-background-translucency : Do not set translucent background hint on surfaces (workaround for non-compositing WMs) \
         \\nInfluential environment variables: \
         \\n\\t QMAKEFEATURES A mkspecs/features directory list to look for features. \